@@ -0,0 +1,208 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+#include <raylib.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include "audio.h"
+
+#define AUDIO_SAMPLE_RATE 48000
+#define AUDIO_FRAME_HZ 60
+#define AUDIO_FRAME_SAMPLES (AUDIO_SAMPLE_RATE / AUDIO_FRAME_HZ)
+#define AUDIO_TONE_HZ 480 // divides a frame into whole periods, so every frame starts in phase
+#define AUDIO_AMPLITUDE 0x1800
+#define AUDIO_RING_SIZE 64 // frames, must be a power of two
+
+#define AUDIO_PATTERN_BITS 128
+#define AUDIO_PATTERN_RATE 4000.0 // XO-CHIP pattern bits per second at pitch 64
+
+struct audio_slot {
+	const int16_t* samples; // wave, silence or rendered
+	int16_t rendered[AUDIO_FRAME_SAMPLES];
+};
+
+static struct {
+	AudioStream stream;
+	bool ready;
+	int16_t wave[AUDIO_FRAME_SAMPLES]; // one frame of square wave
+	int16_t silence[AUDIO_FRAME_SAMPLES];
+	/* ring of frames, the emulation thread owns head and the audio callback owns tail. The callback
+	keeps the slot it is playing until it is done with it, so rendered samples are never overwritten. */
+	struct audio_slot ring[AUDIO_RING_SIZE];
+	_Atomic uint32_t head;
+	_Atomic uint32_t tail;
+	uint32_t max_queued; // frames
+	// emulation side
+	double pattern_phase; // in pattern bits
+	// callback side
+	const int16_t* current;
+	bool holding; // current is a ring slot
+	uint32_t position; // samples already played from current
+	// statistics, read by audio_report() while the callback may still be adding to them
+	_Atomic uint64_t overruns; // gates dropped because the ring was full
+	_Atomic uint64_t underruns; // frames of silence played because the ring was empty
+	_Atomic uint64_t trimmed; // gates skipped to stay within max_queued
+	_Atomic uint64_t queued_total; // queue depth in frames summed at every gate start
+	_Atomic uint64_t gates;
+} audio;
+
+static void audio_callback(void* buffer, unsigned int frames) {
+	int16_t* out = buffer;
+	while (frames > 0) {
+		if (audio.position == AUDIO_FRAME_SAMPLES) {
+			uint32_t tail = atomic_load_explicit(&audio.tail, memory_order_relaxed);
+			if (audio.holding) {
+				tail++;
+				audio.holding = false;
+			}
+			uint32_t head = atomic_load_explicit(&audio.head, memory_order_acquire);
+			if (head - tail > audio.max_queued) {
+				atomic_fetch_add_explicit(&audio.trimmed, head - tail - audio.max_queued, memory_order_relaxed);
+				tail = head - audio.max_queued;
+			}
+			if (head == tail) {
+				audio.current = audio.silence;
+				atomic_fetch_add_explicit(&audio.underruns, 1, memory_order_relaxed);
+			} else {
+				atomic_fetch_add_explicit(&audio.queued_total, head - tail, memory_order_relaxed);
+				atomic_fetch_add_explicit(&audio.gates, 1, memory_order_relaxed);
+				audio.current = audio.ring[tail % AUDIO_RING_SIZE].samples;
+				audio.holding = true;
+			}
+			atomic_store_explicit(&audio.tail, tail, memory_order_release);
+			audio.position = 0;
+		}
+		uint32_t n = AUDIO_FRAME_SAMPLES - audio.position;
+		if (n > frames)
+			n = frames;
+		memcpy(out, audio.current + audio.position, n * sizeof(int16_t));
+		audio.position += n;
+		out += n;
+		frames -= n;
+	}
+}
+
+bool audio_init(unsigned latency_ms) {
+	for (int i = 0; i < AUDIO_FRAME_SAMPLES; i++) {
+		int half_period = AUDIO_SAMPLE_RATE / AUDIO_TONE_HZ / 2;
+		audio.wave[i] = (i / half_period) % 2 ? -AUDIO_AMPLITUDE : AUDIO_AMPLITUDE;
+	}
+	audio.current = audio.silence;
+	audio.position = AUDIO_FRAME_SAMPLES;
+	audio.max_queued = latency_ms * AUDIO_FRAME_HZ / 1000;
+	if (audio.max_queued < 1)
+		audio.max_queued = 1;
+	if (audio.max_queued > AUDIO_RING_SIZE)
+		audio.max_queued = AUDIO_RING_SIZE;
+	atomic_init(&audio.head, 0);
+	atomic_init(&audio.tail, 0);
+	atomic_init(&audio.overruns, 0);
+	atomic_init(&audio.underruns, 0);
+	atomic_init(&audio.trimmed, 0);
+	atomic_init(&audio.queued_total, 0);
+	atomic_init(&audio.gates, 0);
+
+	InitAudioDevice();
+	if (!IsAudioDeviceReady())
+		return false;
+	// the device buffer is the other half of the latency budget, keep it to about a frame
+	SetAudioStreamBufferSizeDefault(AUDIO_FRAME_SAMPLES);
+	audio.stream = LoadAudioStream(AUDIO_SAMPLE_RATE, 16, 1);
+	SetAudioStreamCallback(audio.stream, audio_callback);
+	PlayAudioStream(audio.stream);
+	audio.ready = true;
+	return true;
+}
+
+// next free slot, NULL when the ring is full
+static struct audio_slot* audio_reserve(void) {
+	uint32_t head = atomic_load_explicit(&audio.head, memory_order_relaxed);
+	uint32_t tail = atomic_load_explicit(&audio.tail, memory_order_acquire);
+	if (head - tail >= AUDIO_RING_SIZE) {
+		atomic_fetch_add_explicit(&audio.overruns, 1, memory_order_relaxed);
+		return NULL;
+	}
+	return &audio.ring[head % AUDIO_RING_SIZE];
+}
+
+static void audio_commit(void) {
+	uint32_t head = atomic_load_explicit(&audio.head, memory_order_relaxed);
+	atomic_store_explicit(&audio.head, head + 1, memory_order_release);
+}
+
+void audio_push_frame(bool tone) {
+	struct audio_slot* slot = audio_reserve();
+	if (!slot)
+		return;
+	slot->samples = tone ? audio.wave : audio.silence;
+	audio.pattern_phase = 0.0;
+	audio_commit();
+}
+
+// XO-CHIP plays the 128 bit pattern as 1 bit samples at 4000*2^((pitch-64)/48) bits per second
+void audio_push_pattern(const uint8_t pattern[16], uint8_t pitch) {
+	struct audio_slot* slot = audio_reserve();
+	if (!slot)
+		return;
+	double step = AUDIO_PATTERN_RATE * pow(2.0, (pitch - 64) / 48.0) / AUDIO_SAMPLE_RATE;
+	double phase = audio.pattern_phase;
+	for (int i = 0; i < AUDIO_FRAME_SAMPLES; i++) {
+		unsigned bit = (unsigned)phase;
+		slot->rendered[i] = (pattern[bit >> 3] >> (7 - (bit & 7))) & 1 ? AUDIO_AMPLITUDE : -AUDIO_AMPLITUDE;
+		phase += step;
+		if (phase >= AUDIO_PATTERN_BITS)
+			phase -= AUDIO_PATTERN_BITS;
+	}
+	audio.pattern_phase = phase;
+	slot->samples = slot->rendered;
+	audio_commit();
+}
+
+void audio_report(FILE* out) {
+	if (!audio.ready)
+		return;
+	double frame_ms = 1000.0 / AUDIO_FRAME_HZ;
+	uint64_t gates = atomic_load_explicit(&audio.gates, memory_order_relaxed);
+	uint64_t queued_total = atomic_load_explicit(&audio.queued_total, memory_order_relaxed);
+	fprintf(out, "audio: %llu frames played, %llu underruns, %llu overruns, %llu trimmed\n",
+		(unsigned long long)gates,
+		(unsigned long long)atomic_load_explicit(&audio.underruns, memory_order_relaxed),
+		(unsigned long long)atomic_load_explicit(&audio.overruns, memory_order_relaxed),
+		(unsigned long long)atomic_load_explicit(&audio.trimmed, memory_order_relaxed));
+	if (gates)
+		fprintf(out, "  queued latency: mean %.1f ms (limit %.1f ms) plus %.1f ms device buffer\n",
+			queued_total * frame_ms / gates, audio.max_queued * frame_ms, frame_ms);
+}
+
+void audio_close(void) {
+	if (!audio.ready)
+		return;
+	StopAudioStream(audio.stream);
+	UnloadAudioStream(audio.stream);
+	CloseAudioDevice();
+	audio.ready = false;
+}
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
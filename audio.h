@@ -0,0 +1,48 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+#ifndef AUDIO_H
+#define AUDIO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* Buzzer output for the sound timer.
+The emulation thread pushes one entry per 60hz emulated frame into a lock-free single producer/single
+consumer ring. The raylib audio callback plays each entry as one frame of samples by copying, either
+from a precomputed square wave (or silence), or from samples the emulation thread rendered from the
+XO-CHIP pattern buffer, so the tone starts and stops exactly on emulated timer edges.
+latency_ms bounds how many frames may queue up in the ring on top of the device buffer. */
+bool audio_init(unsigned latency_ms);
+
+// emulation thread, once per emulated frame
+void audio_push_frame(bool tone);
+// emulation thread, once per emulated frame while an XO-CHIP sound timer runs
+void audio_push_pattern(const uint8_t pattern[16], uint8_t pitch);
+void audio_report(FILE* out);
+void audio_close(void);
+
+#endif
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
@@ -0,0 +1,722 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+#include <stdlib.h>
+#include <string.h>
+#include "batch.h"
+
+#define BATCH_ALIGN 64 // every lane array starts on its own cache line
+#define BATCH_DIVERGED 8 // groups per step past which a block is cheaper run one lane at a time
+#define BATCH_WINDOW 16 // steps of a block between looks at how much of it ran one lane at a time
+#define BATCH_SERIAL 4 // a block with more than one in this many lane instructions drawing or scalar, likewise
+
+//***lane transfer***
+// the lane's chip8 gets the current values of the structure of arrays fields
+static void scatter(const chip8_batch* b, unsigned lane, chip8* chip) {
+	for (unsigned r = 0; r < 16; r++)
+		chip->registers[r] = b->v[r][lane];
+	for (unsigned d = 0; d < CHIP8_STACK_SIZE; d++)
+		chip->stack[d] = b->stack[d][lane];
+	chip->pc = b->pc[lane];
+	chip->idx_reg = b->i[lane];
+	chip->opcode = b->opcode[lane];
+	chip->idx_stack = b->sp[lane];
+	chip->timer_delay = b->dt[lane];
+	chip->timer_sound = b->st[lane];
+	chip->keys = b->keys[lane];
+	chip->rng = b->rng[lane];
+	chip->cycles = b->cycles[lane];
+	chip->fault = b->fault[lane];
+	chip->events = b->events[lane];
+	chip->quirks = b->quirks;
+}
+
+static void gather(chip8_batch* b, unsigned lane, const chip8* chip) {
+	for (unsigned r = 0; r < 16; r++)
+		b->v[r][lane] = chip->registers[r];
+	for (unsigned d = 0; d < CHIP8_STACK_SIZE; d++)
+		b->stack[d][lane] = chip->stack[d];
+	b->pc[lane] = chip->pc;
+	b->i[lane] = chip->idx_reg;
+	b->opcode[lane] = chip->opcode;
+	b->sp[lane] = chip->idx_stack;
+	b->dt[lane] = chip->timer_delay;
+	b->st[lane] = chip->timer_sound;
+	b->keys[lane] = chip->keys;
+	b->rng[lane] = chip->rng;
+	b->cycles[lane] = chip->cycles;
+	b->fault[lane] = chip->fault;
+	b->events[lane] = chip->events;
+}
+
+// widens the lane's range of RAM that may differ from the image by what opcode is about to write
+static void note_write(chip8_batch* b, unsigned lane, uint16_t opcode) {
+	unsigned x = (opcode >> 8) & 0xFu, y = (opcode >> 4) & 0xFu;
+	unsigned length;
+	if ((opcode & 0xF0FFu) == 0xF033u)
+		length = 3;
+	else if ((opcode & 0xF0FFu) == 0xF055u)
+		length = x + 1;
+	else if ((opcode & 0xF00Fu) == 0x5002u && b->machine == CHIP8_MACHINE_XOCHIP)
+		length = (x <= y ? y - x : x - y) + 1;
+	else
+		return;
+	unsigned start = b->i[lane] & b->addr_mask;
+	unsigned end = start + length - 1;
+	if (end > b->addr_mask) {
+		// wraps around the address space
+		start = 0;
+		end = b->addr_mask;
+	}
+	if (start < b->written_lo[lane])
+		b->written_lo[lane] = start;
+	if (end > b->written_hi[lane])
+		b->written_hi[lane] = end;
+}
+
+// the scalar interpreter for one lane
+static void step_lane(chip8_batch* b, unsigned lane, uint16_t opcode) {
+	chip8* chip = b->lanes[lane];
+	note_write(b, lane, opcode);
+	const uint64_t cycles = b->cycles[lane];
+	scatter(b, lane, chip);
+	b->step(chip);
+	gather(b, lane, chip);
+	b->cycles[lane] = cycles; // counted by step_block()
+}
+
+/* The rest of a run for one lane on the scalar interpreter, for blocks whose lanes have drifted apart.
+The lane's dirty bits are set aside so the ones left afterwards are exactly the blocks the run wrote,
+and only those are compared with the image to widen the written range. */
+static void run_lane(chip8_batch* b, unsigned lane, uint64_t instructions) {
+	chip8* chip = b->lanes[lane];
+	uint64_t dirty[sizeof(chip->dirty) / sizeof(chip->dirty[0])];
+	memcpy(dirty, chip->dirty, sizeof(dirty));
+	memset(chip->dirty, 0, sizeof(chip->dirty));
+	scatter(b, lane, chip);
+	for (uint64_t n = 0; n < instructions && chip->fault == CHIP8_FAULT_NONE; n++)
+		b->step(chip);
+	gather(b, lane, chip);
+	for (unsigned w = 0; w < sizeof(dirty) / sizeof(dirty[0]); w++) {
+		for (uint64_t bits = chip->dirty[w]; bits; bits &= bits - 1) {
+			unsigned start = (w * 64 + __builtin_ctzll(bits)) * CHIP8_DIRTY_BLOCK;
+			for (unsigned a = start; a < start + CHIP8_DIRTY_BLOCK; a++) {
+				if (chip->ram[a] == b->image[a])
+					continue;
+				if (a < b->written_lo[lane])
+					b->written_lo[lane] = a;
+				if (a > b->written_hi[lane])
+					b->written_hi[lane] = a;
+			}
+		}
+		chip->dirty[w] |= dirty[w];
+	}
+}
+
+// as mem_write() in chip8.c, without the watchpoints
+static inline void lane_write(chip8* chip, unsigned mask, unsigned addr, uint8_t value) {
+	addr &= mask;
+	chip->ram[addr] = value;
+	chip->dirty[addr / CHIP8_DIRTY_BLOCK / 64] |= 1ull << (addr / CHIP8_DIRTY_BLOCK % 64);
+}
+
+/* The instructions without a vector form that games run all the time, for one lane but on the lane
+arrays in place: only RAM and the display are taken from the lane's chip8, so there is no scatter()
+and gather() around them. Returns false for anything else, which is left to step_lane(). Mirrors
+step_impl() in chip8.c. */
+static bool exec_lane(chip8_batch* b, unsigned lane, uint16_t opcode) {
+	chip8* chip = b->lanes[lane];
+	const unsigned x = (opcode >> 8) & 0xFu;
+	const unsigned mask = b->addr_mask;
+	const uint16_t i = b->i[lane];
+	if ((opcode & 0xF000u) == 0xD000u) {
+		b->v[0xF][lane] = chip8_draw(chip, i, b->v[x][lane], b->v[(opcode >> 4) & 0xFu][lane], opcode & 0xFu);
+		b->events[lane] |= CHIP8_EVENT_DISPLAY;
+	} else if (opcode == 0x00E0u) {
+		for (unsigned p = 0; p < CHIP8_PLANES; p++) {
+			if (chip->planes & (1u << p))
+				memset(chip->display[p], 0, sizeof(chip->display[p]));
+		}
+		chip->drawn = ~0ull;
+		b->events[lane] |= CHIP8_EVENT_DISPLAY;
+	} else if ((opcode & 0xF0FFu) == 0xF033u) {
+		uint8_t value = b->v[x][lane];
+		note_write(b, lane, opcode);
+		lane_write(chip, mask, i, value / 100);
+		lane_write(chip, mask, i + 1, (value / 10) % 10);
+		lane_write(chip, mask, i + 2, value % 10);
+	} else if ((opcode & 0xF0FFu) == 0xF055u) {
+		note_write(b, lane, opcode);
+		for (unsigned r = 0; r <= x; r++)
+			lane_write(chip, mask, i + r, b->v[r][lane]);
+		if (b->quirks & CHIP8_QUIRK_MEMORY_INCREMENT)
+			b->i[lane] = i + x + 1;
+	} else if ((opcode & 0xF0FFu) == 0xF065u) {
+		for (unsigned r = 0; r <= x; r++)
+			b->v[r][lane] = chip->ram[(i + r) & mask];
+		if (b->quirks & CHIP8_QUIRK_MEMORY_INCREMENT)
+			b->i[lane] = i + x + 1;
+	} else {
+		return false;
+	}
+	b->pc[lane] += 2;
+	b->opcode[lane] = opcode;
+	return true;
+}
+
+//***vector execution***
+/* A block's lanes as GCC vectors: 32 lanes are one u8x32, or two u16x16, four u32x8 or eight u64x4.
+The avx2 clone of step_block() keeps each in one ymm register, the default one splits them in two.
+Masks are 0 or all ones per lane; lane arrays are 64-byte aligned and blocks start at multiples of 32,
+so every load and store below is aligned. */
+typedef uint8_t u8x32 __attribute__((vector_size(32)));
+typedef uint16_t u16x16 __attribute__((vector_size(32)));
+typedef uint32_t u32x8 __attribute__((vector_size(32)));
+typedef uint64_t u64x4 __attribute__((vector_size(32)));
+typedef uint8_t u8x16 __attribute__((vector_size(16)));
+typedef uint8_t u8x8 __attribute__((vector_size(8)));
+typedef int8_t i8x16 __attribute__((vector_size(16)));
+typedef int8_t i8x8 __attribute__((vector_size(8)));
+typedef int8_t i8x4 __attribute__((vector_size(4)));
+typedef int16_t i16x16 __attribute__((vector_size(32)));
+typedef int32_t i32x8 __attribute__((vector_size(32)));
+typedef int64_t i64x4 __attribute__((vector_size(32)));
+
+#define VEC_INLINE static inline __attribute__((always_inline))
+
+VEC_INLINE u8x32 load8(const uint8_t* p) { u8x32 v; memcpy(&v, p, sizeof(v)); return v; }
+VEC_INLINE void store8(uint8_t* p, u8x32 v) { memcpy(p, &v, sizeof(v)); }
+VEC_INLINE u16x16 load16(const uint16_t* p) { u16x16 v; memcpy(&v, p, sizeof(v)); return v; }
+VEC_INLINE void store16(uint16_t* p, u16x16 v) { memcpy(p, &v, sizeof(v)); }
+VEC_INLINE u32x8 load32(const uint32_t* p) { u32x8 v; memcpy(&v, p, sizeof(v)); return v; }
+VEC_INLINE void store32(uint32_t* p, u32x8 v) { memcpy(p, &v, sizeof(v)); }
+VEC_INLINE u64x4 load64(const uint64_t* p) { u64x4 v; memcpy(&v, p, sizeof(v)); return v; }
+VEC_INLINE void store64(uint64_t* p, u64x4 v) { memcpy(p, &v, sizeof(v)); }
+
+// a where the mask is set, b elsewhere
+VEC_INLINE u8x32 select8(u8x32 m, u8x32 a, u8x32 b) { return (a & m) | (b & ~m); }
+VEC_INLINE u16x16 select16(u16x16 m, u16x16 a, u16x16 b) { return (a & m) | (b & ~m); }
+
+// lanes 16h..16h+15 of an 8-bit mask as a 16-bit one, and so on
+VEC_INLINE u16x16 mask16(u8x32 m, unsigned h) {
+	i8x16 part;
+	memcpy(&part, (const uint8_t*)&m + 16 * h, sizeof(part));
+	return (u16x16)__builtin_convertvector(part, i16x16);
+}
+VEC_INLINE u32x8 mask32(u8x32 m, unsigned q) {
+	i8x8 part;
+	memcpy(&part, (const uint8_t*)&m + 8 * q, sizeof(part));
+	return (u32x8)__builtin_convertvector(part, i32x8);
+}
+VEC_INLINE u64x4 mask64(u8x32 m, unsigned o) {
+	i8x4 part;
+	memcpy(&part, (const uint8_t*)&m + 4 * o, sizeof(part));
+	return (u64x4)__builtin_convertvector(part, i64x4);
+}
+// zero extends lanes 16h..16h+15
+VEC_INLINE u16x16 widen16(u8x32 v, unsigned h) {
+	u8x16 part;
+	memcpy(&part, (const uint8_t*)&v + 16 * h, sizeof(part));
+	return __builtin_convertvector(part, u16x16);
+}
+// a 16-bit mask pair back to 8 bits
+VEC_INLINE u8x32 narrow_mask(const u16x16 m16[2]) {
+	i8x16 parts[2] = {__builtin_convertvector((i16x16)m16[0], i8x16), __builtin_convertvector((i16x16)m16[1], i8x16)};
+	u8x32 m;
+	memcpy(&m, parts, sizeof(m));
+	return m;
+}
+
+VEC_INLINE bool any(u8x32 m) {
+	uint64_t w[4];
+	memcpy(w, &m, sizeof(w));
+	return (w[0] | w[1] | w[2] | w[3]) != 0;
+}
+
+// the first lane set in m, CHIP8_BATCH_BLOCK when none is
+VEC_INLINE unsigned first(u8x32 m) {
+	uint64_t w[4];
+	memcpy(w, &m, sizeof(w));
+	for (unsigned i = 0; i < 4; i++) {
+		if (w[i])
+			return i * 8 + __builtin_ctzll(w[i]) / 8;
+	}
+	return CHIP8_BATCH_BLOCK;
+}
+
+// pc = m ? value : pc, for both halves of a block
+VEC_INLINE void set_pc(uint16_t* pc, const u16x16 m[2], u16x16 value0, u16x16 value1) {
+	store16(pc, select16(m[0], value0, load16(pc)));
+	store16(pc + 16, select16(m[1], value1, load16(pc + 16)));
+}
+
+// pc = m && cond ? pc + 2 : pc, cond per lane, for the skips
+VEC_INLINE void skip_if(uint16_t* pc, const u16x16 m[2], u8x32 cond) {
+	for (unsigned h = 0; h < 2; h++) {
+		u16x16 p = load16(pc + 16 * h);
+		store16(pc + 16 * h, select16(m[h] & mask16(cond, h), p + 2, p));
+	}
+}
+
+/* Runs opcode on the lanes of the block at base selected in *lanes, which all sit at pc. Returns the
+lanes left for the scalar interpreter: the ones that would fault, or the whole group when the
+instruction has no vector form. Mirrors step_impl() in chip8.c, including the order registers are
+written in when Vx or Vy is VF. */
+VEC_INLINE u8x32 exec_vector(chip8_batch* b, unsigned base, uint16_t pc, uint16_t opcode, const u8x32* lanes) {
+	const u8x32 group = *lanes;
+	const unsigned x = (opcode >> 8) & 0xFu, y = (opcode >> 4) & 0xFu;
+	const uint8_t kk = opcode & 0xFFu;
+	const uint16_t nnn = opcode & 0x0FFFu;
+	const bool xochip = b->machine == CHIP8_MACHINE_XOCHIP;
+	uint8_t* vx = b->v[x] + base;
+	uint8_t* vy = b->v[y] + base;
+	uint8_t* vf = b->v[0xF] + base;
+	uint16_t* lane_pc = b->pc + base;
+	uint16_t* lane_i = b->i + base;
+	uint8_t* lane_sp = b->sp + base;
+	const u8x32 zero8 = {0};
+	const u16x16 zero16 = {0};
+	u8x32 m = group;
+	u8x32 scalar = zero8;
+
+	// the two instructions with a fault path leave the lanes that would fault to the scalar interpreter
+	u8x32 sp = load8(lane_sp);
+	if (opcode == 0x00EEu)
+		scalar = m & (u8x32)(sp == 0);
+	else if ((opcode & 0xF000u) == 0x2000u)
+		scalar = m & (u8x32)(sp >= CHIP8_STACK_SIZE);
+	m &= ~scalar;
+	u16x16 m16[2] = {mask16(m, 0), mask16(m, 1)};
+	const uint16_t next = pc + 2u;
+
+	switch (opcode & 0xF000u) {
+		case 0x0000u:
+			if (opcode == 0x00EEu) {
+				u16x16 ret[2] = {zero16, zero16};
+				u16x16 sp16[2] = {widen16(sp, 0), widen16(sp, 1)};
+				for (unsigned d = 0; d < CHIP8_STACK_SIZE; d++) {
+					for (unsigned h = 0; h < 2; h++)
+						ret[h] |= load16(b->stack[d] + base + 16 * h) & (u16x16)(sp16[h] == (uint16_t)(d + 1));
+				}
+				set_pc(lane_pc, m16, ret[0], ret[1]);
+				store8(lane_sp, sp - (m & 1));
+				goto done;
+			}
+			if (opcode == 0x00E0u || b->machine >= CHIP8_MACHINE_SCHIP)
+				return group;
+			break; // anything else is a no-op on CHIP-8
+		case 0x1000u:
+			set_pc(lane_pc, m16, zero16 + nnn, zero16 + nnn);
+			goto done;
+		case 0x2000u:
+			{
+				u16x16 sp16[2] = {widen16(sp, 0), widen16(sp, 1)};
+				for (unsigned d = 0; d < CHIP8_STACK_SIZE; d++) {
+					for (unsigned h = 0; h < 2; h++) {
+						uint16_t* stack = b->stack[d] + base + 16 * h;
+						store16(stack, select16(m16[h] & (u16x16)(sp16[h] == (uint16_t)d), zero16 + next, load16(stack)));
+					}
+				}
+				store8(lane_sp, sp + (m & 1));
+				set_pc(lane_pc, m16, zero16 + nnn, zero16 + nnn);
+			}
+			goto done;
+		// XO-CHIP skips over a whole F000 nnnn, which depends on the lane's RAM
+		case 0x3000u:
+			if (xochip)
+				return group;
+			set_pc(lane_pc, m16, zero16 + next, zero16 + next);
+			skip_if(lane_pc, m16, (u8x32)(load8(vx) == kk));
+			goto done;
+		case 0x4000u:
+			if (xochip)
+				return group;
+			set_pc(lane_pc, m16, zero16 + next, zero16 + next);
+			skip_if(lane_pc, m16, (u8x32)(load8(vx) != kk));
+			goto done;
+		case 0x5000u:
+			if (xochip)
+				return group;
+			set_pc(lane_pc, m16, zero16 + next, zero16 + next);
+			skip_if(lane_pc, m16, (u8x32)(load8(vx) == load8(vy)));
+			goto done;
+		case 0x9000u:
+			if (xochip)
+				return group;
+			set_pc(lane_pc, m16, zero16 + next, zero16 + next);
+			skip_if(lane_pc, m16, (u8x32)(load8(vx) != load8(vy)));
+			goto done;
+		case 0x6000u:
+			store8(vx, select8(m, zero8 + kk, load8(vx)));
+			break;
+		case 0x7000u:
+			{
+				u8x32 a = load8(vx);
+				store8(vx, select8(m, a + kk, a));
+			}
+			break;
+		case 0x8000u:
+			{
+				// stored in the same order as step_impl(), so Vx or Vy being VF comes out the same
+				u8x32 a = load8(vx), c = load8(vy);
+				switch (opcode & 0xFu) {
+					case 0x0u:
+						store8(vx, select8(m, c, a));
+						break;
+					case 0x1u:
+						store8(vx, select8(m, a | c, a));
+						break;
+					case 0x2u:
+						store8(vx, select8(m, a & c, a));
+						break;
+					case 0x3u:
+						store8(vx, select8(m, a ^ c, a));
+						break;
+					case 0x4u:
+						{
+							u8x32 sum = a + c;
+							store8(vx, select8(m, sum, a));
+							store8(vf, select8(m, (u8x32)(sum < a) & 1, load8(vf)));
+						}
+						break;
+					case 0x5u:
+						store8(vx, select8(m, a - c, a));
+						store8(vf, select8(m, (u8x32)(a >= c) & 1, load8(vf)));
+						break;
+					case 0x6u:
+					case 0xEu:
+						{
+							u8x32 value = (b->quirks & CHIP8_QUIRK_SHIFT_VX) ? a : c;
+							bool left = (opcode & 0xFu) == 0xEu;
+							store8(vx, select8(m, left ? value << 1 : value >> 1, a));
+							store8(vf, select8(m, left ? value >> 7 : value & 1, load8(vf)));
+						}
+						break;
+					case 0x7u:
+						store8(vx, select8(m, c - a, a));
+						store8(vf, select8(m, (u8x32)(c >= a) & 1, load8(vf)));
+						break;
+				}
+				if ((b->quirks & CHIP8_QUIRK_VF_RESET) && (opcode & 0xFu) >= 1u && (opcode & 0xFu) <= 3u)
+					store8(vf, select8(m, zero8, load8(vf)));
+			}
+			break;
+		case 0xA000u:
+			set_pc(lane_i, m16, zero16 + nnn, zero16 + nnn);
+			break;
+		case 0xB000u:
+			{
+				u8x32 offset = load8((b->quirks & CHIP8_QUIRK_JUMP_VX) ? vx : b->v[0] + base);
+				set_pc(lane_pc, m16, widen16(offset, 0) + nnn, widen16(offset, 1) + nnn);
+			}
+			goto done;
+		case 0xC000u:
+			{
+				uint32_t* rng = b->rng + base;
+				u8x8 bytes[4];
+				for (unsigned q = 0; q < 4; q++) {
+					u32x8 r = load32(rng + 8 * q);
+					r ^= r << 13;
+					r ^= r >> 17;
+					r ^= r << 5;
+					u32x8 m32 = mask32(m, q);
+					store32(rng + 8 * q, (r & m32) | (load32(rng + 8 * q) & ~m32));
+					bytes[q] = __builtin_convertvector(r >> 24, u8x8);
+				}
+				u8x32 value;
+				memcpy(&value, bytes, sizeof(value));
+				store8(vx, select8(m, value & kk, load8(vx)));
+			}
+			break;
+		case 0xE000u:
+			if (kk == 0x9Eu || kk == 0xA1u) {
+				if (xochip)
+					return group;
+				set_pc(lane_pc, m16, zero16 + next, zero16 + next);
+				const uint16_t* keys = b->keys + base;
+				u8x32 key = load8(vx) & 0xF;
+				u16x16 down[2];
+				for (unsigned h = 0; h < 2; h++)
+					down[h] = (u16x16)(((load16(keys + 16 * h) >> widen16(key, h)) & 1) != 0);
+				u8x32 pressed = narrow_mask(down);
+				skip_if(lane_pc, m16, kk == 0x9Eu ? pressed : ~pressed);
+				uint8_t* events = b->events + base;
+				store8(events, load8(events) | (m & CHIP8_EVENT_KEYPAD_READ));
+				goto done;
+			}
+			break;
+		case 0xF000u:
+			switch (kk) {
+				case 0x07u:
+					store8(vx, select8(m, load8(b->dt + base), load8(vx)));
+					break;
+				case 0x15u:
+					store8(b->dt + base, select8(m, load8(vx), load8(b->dt + base)));
+					break;
+				case 0x18u:
+					store8(b->st + base, select8(m, load8(vx), load8(b->st + base)));
+					break;
+				case 0x1Eu:
+					{
+						u8x32 a = load8(vx);
+						set_pc(lane_i, m16, load16(lane_i) + widen16(a, 0), load16(lane_i + 16) + widen16(a, 1));
+					}
+					break;
+				case 0x29u:
+					{
+						u8x32 a = load8(vx);
+						set_pc(lane_i, m16, widen16(a, 0) * 5 + FONT_START_ADDRESS, widen16(a, 1) * 5 + FONT_START_ADDRESS);
+					}
+					break;
+				case 0x30u:
+					if (b->machine < CHIP8_MACHINE_SCHIP)
+						return group;
+					{
+						u8x32 a = load8(vx) & 0xF;
+						set_pc(lane_i, m16, widen16(a, 0) * 10 + BIG_FONT_START_ADDRESS, widen16(a, 1) * 10 + BIG_FONT_START_ADDRESS);
+					}
+					break;
+				default:
+					return group;
+			}
+			break;
+		default:
+			return group;
+	}
+	// everything that didn't jump goes on to the next instruction
+	set_pc(lane_pc, m16, zero16 + next, zero16 + next);
+done:
+	set_pc(b->opcode + base, m16, zero16 + opcode, zero16 + opcode);
+	return scalar;
+}
+
+/* One instruction for every live lane of the block at base. The lanes are split into groups at the
+same PC running the same opcode: the first lane still pending leads, every lane whose written range
+doesn't cover the PC has the image's opcode there and only the others fetch their own. Lanes that
+follow the same code path form one group, so this is usually a single pass. Returns the number of
+groups and adds the lanes that drew or needed the scalar interpreter to serial. */
+__attribute__((target_clones("avx2", "default")))
+static unsigned step_block(chip8_batch* b, unsigned base, unsigned* serial) {
+	const unsigned mask = b->addr_mask;
+	const uint16_t* lane_pc = b->pc + base;
+	u16x16 lo[2] = {load16(b->written_lo + base), load16(b->written_lo + base + 16)};
+	u16x16 hi[2] = {load16(b->written_hi + base), load16(b->written_hi + base + 16)};
+	u16x16 pcs[2] = {load16(lane_pc), load16(lane_pc + 16)};
+	u8x32 pending = (u8x32)(load8(b->fault + base) == 0);
+	unsigned groups = 0;
+	// until a lane writes RAM, every lane runs the image's code
+	const bool clean = !any(narrow_mask((u16x16[2]){(u16x16)(lo[0] <= hi[0]), (u16x16)(lo[1] <= hi[1])}));
+
+	for (unsigned lead = first(pending); lead < CHIP8_BATCH_BLOCK; lead = first(pending)) {
+		const uint16_t pc = lane_pc[lead];
+		const unsigned at = pc & mask;
+		const uint8_t* ram = b->lanes[base + lead]->ram;
+		const uint16_t opcode = (ram[at] << 8) | ram[(at + 1) & mask];
+		const bool image = ((b->image[at] << 8) | b->image[(at + 1) & mask]) == opcode;
+		// an opcode straddling the end of the address space is checked by every lane
+		const bool wraps = at == mask;
+		u16x16 same[2] = {(u16x16)(pcs[0] == pc), (u16x16)(pcs[1] == pc)};
+		u8x32 on_pc = pending & narrow_mask(same);
+		u8x32 group = on_pc;
+		if (!clean || !image || wraps) {
+			u16x16 written[2];
+			for (unsigned h = 0; h < 2; h++)
+				written[h] = (u16x16)((hi[h] >= (uint16_t)at) & (lo[h] <= (uint16_t)(at + 1)));
+			group = image && !wraps ? on_pc & ~narrow_mask(written) : (u8x32){0};
+		}
+		u8x32 check = on_pc & ~group;
+		if (any(check)) {
+			uint8_t lanes[CHIP8_BATCH_BLOCK];
+			memcpy(lanes, &check, sizeof(lanes));
+			memcpy(&check, &group, sizeof(check));
+			for (unsigned l = 0; l < CHIP8_BATCH_BLOCK; l++) {
+				if (!lanes[l])
+					continue;
+				const uint8_t* own = b->lanes[base + l]->ram;
+				if (((own[at] << 8) | own[(at + 1) & mask]) == opcode)
+					((uint8_t*)&check)[l] = 0xFFu;
+			}
+			group = check;
+		}
+
+		u8x32 scalar = exec_vector(b, base, pc, opcode, &group);
+		if (any(scalar)) {
+			uint8_t lanes[CHIP8_BATCH_BLOCK];
+			memcpy(lanes, &scalar, sizeof(lanes));
+			for (unsigned l = 0; l < CHIP8_BATCH_BLOCK; l++) {
+				if (!lanes[l])
+					continue;
+				if (!exec_lane(b, base + l, opcode)) {
+					step_lane(b, base + l, opcode);
+					(*serial)++;
+				} else if ((opcode & 0xF000u) == 0xD000u) {
+					(*serial)++;
+				}
+			}
+		}
+		pending &= ~group;
+		groups++;
+	}
+
+	// as in chip8_step(), an instruction counts unless it faulted, once per block rather than per group
+	u8x32 live = (u8x32)(load8(b->fault + base) == 0);
+	for (unsigned o = 0; o < 8; o++) {
+		uint64_t* cycles = b->cycles + base + 4 * o;
+		store64(cycles, load64(cycles) + (mask64(live, o) & 1));
+	}
+	return groups;
+}
+
+void chip8_batch_step(chip8_batch* batch) {
+	unsigned serial = 0;
+	for (unsigned base = 0; base < batch->count; base += CHIP8_BATCH_BLOCK)
+		step_block(batch, base, &serial);
+}
+
+/* Block by block, the lanes of different blocks never meet. Once a step of a block splits into more
+than BATCH_DIVERGED groups, e.g. lanes that branched on random numbers, each pass covers a handful of
+lanes and the block finishes the run lane by lane instead. So does a block that keeps drawing or
+falling back to the scalar interpreter: those run one lane at a time either way, and a separate
+machine keeps its own display in cache rather than touching 32 of them per step. The next run starts
+on vectors again. */
+void chip8_batch_run(chip8_batch* batch, uint64_t instructions) {
+	for (unsigned base = 0; base < batch->count; base += CHIP8_BATCH_BLOCK) {
+		unsigned serial = 0;
+		for (uint64_t n = 0; n < instructions; n++) {
+			bool separate = step_block(batch, base, &serial) > BATCH_DIVERGED;
+			if ((n + 1) % BATCH_WINDOW == 0) {
+				separate |= serial * BATCH_SERIAL > BATCH_WINDOW * CHIP8_BATCH_BLOCK;
+				serial = 0;
+			}
+			if (!separate)
+				continue;
+			for (unsigned l = base; l < base + CHIP8_BATCH_BLOCK; l++) {
+				if (batch->fault[l] == CHIP8_FAULT_NONE)
+					run_lane(batch, l, instructions - n - 1);
+			}
+			break;
+		}
+	}
+}
+
+void chip8_batch_tick(chip8_batch* batch) {
+	uint8_t* dt = batch->dt;
+	uint8_t* st = batch->st;
+	for (unsigned l = 0; l < batch->count; l++) {
+		dt[l] -= dt[l] > 0;
+		st[l] -= st[l] > 0;
+	}
+}
+
+//***setup***
+// the next array at offset, aligned. base is NULL while only the size is being worked out
+static void* carve(uint8_t* base, size_t* offset, size_t bytes) {
+	size_t at = *offset;
+	*offset += (bytes + BATCH_ALIGN - 1) & ~(size_t)(BATCH_ALIGN - 1);
+	return base ? base + at : NULL;
+}
+
+// the lane arrays in order, sized by the same walk that carves them. Returns the arena size
+static size_t layout(chip8_batch* b, uint8_t* base) {
+	size_t offset = 0;
+	unsigned n = b->count;
+	for (unsigned r = 0; r < 16; r++)
+		b->v[r] = carve(base, &offset, n);
+	for (unsigned d = 0; d < CHIP8_STACK_SIZE; d++)
+		b->stack[d] = carve(base, &offset, n * sizeof(uint16_t));
+	b->pc = carve(base, &offset, n * sizeof(uint16_t));
+	b->i = carve(base, &offset, n * sizeof(uint16_t));
+	b->opcode = carve(base, &offset, n * sizeof(uint16_t));
+	b->sp = carve(base, &offset, n);
+	b->dt = carve(base, &offset, n);
+	b->st = carve(base, &offset, n);
+	b->keys = carve(base, &offset, n * sizeof(uint16_t));
+	b->rng = carve(base, &offset, n * sizeof(uint32_t));
+	b->cycles = carve(base, &offset, n * sizeof(uint64_t));
+	b->fault = carve(base, &offset, n);
+	b->events = carve(base, &offset, n);
+	b->written_lo = carve(base, &offset, n * sizeof(uint16_t));
+	b->written_hi = carve(base, &offset, n * sizeof(uint16_t));
+	b->lanes = carve(base, &offset, n * sizeof(chip8*));
+	b->image = carve(base, &offset, XOCHIP_RAM_SIZE);
+	// each lane's chip8 starts on a cache line of its own too
+	size_t lane_size = chip8_size(b->machine);
+	for (unsigned l = 0; l < n; l++) {
+		chip8* lane = carve(base, &offset, lane_size);
+		if (base)
+			b->lanes[l] = lane;
+	}
+	return offset;
+}
+
+// nothing written since the image was taken
+static void clear_written(chip8_batch* b, unsigned lane) {
+	b->written_lo[lane] = UINT16_MAX;
+	b->written_hi[lane] = 0;
+}
+
+chip8_batch* chip8_batch_create(chip8_machine machine, unsigned quirks, unsigned count, uint32_t seed) {
+	chip8_batch* b = calloc(1, sizeof(*b));
+	if (!b)
+		return NULL;
+	b->count = (count + CHIP8_BATCH_BLOCK - 1) / CHIP8_BATCH_BLOCK * CHIP8_BATCH_BLOCK;
+	b->machine = machine;
+	b->quirks = quirks;
+	b->addr_mask = machine == CHIP8_MACHINE_XOCHIP ? XOCHIP_RAM_SIZE - 1u : CHIP8_RAM_SIZE - 1u;
+	size_t size = layout(b, NULL);
+	b->arena = aligned_alloc(BATCH_ALIGN, size);
+	if (!b->arena) {
+		free(b);
+		return NULL;
+	}
+	layout(b, b->arena);
+	for (unsigned l = 0; l < b->count; l++) {
+		chip8* chip = b->lanes[l];
+		chip8_init(chip, machine, seed + l);
+		chip->quirks = quirks;
+		gather(b, l, chip);
+		clear_written(b, l);
+	}
+	memcpy(b->image, b->lanes[0]->ram, b->lanes[0]->ram_size);
+	b->step = chip8_step_for(b->lanes[0]);
+	return b;
+}
+
+void chip8_batch_free(chip8_batch* batch) {
+	if (!batch)
+		return;
+	free(batch->arena);
+	free(batch);
+}
+
+bool chip8_batch_load(chip8_batch* batch, const uint8_t* program, size_t size) {
+	for (unsigned l = 0; l < batch->count; l++) {
+		if (!chip8_load(batch->lanes[l], program, size))
+			return false;
+		clear_written(batch, l);
+	}
+	memcpy(batch->image, batch->lanes[0]->ram, batch->lanes[0]->ram_size);
+	return true;
+}
+
+void chip8_batch_get(const chip8_batch* batch, unsigned lane, chip8* out) {
+	memcpy(out, batch->lanes[lane], chip8_size(batch->machine));
+	scatter(batch, lane, out);
+}
+
+void chip8_batch_put(chip8_batch* batch, unsigned lane, const chip8* in) {
+	chip8* chip = batch->lanes[lane];
+	memcpy(chip, in, chip8_size(batch->machine));
+	chip->quirks = batch->quirks;
+	gather(batch, lane, chip);
+	// the new RAM differs from the image somewhere between its first and last differing bytes
+	clear_written(batch, lane);
+	for (unsigned a = 0; a < chip->ram_size; a++) {
+		if (chip->ram[a] != batch->image[a]) {
+			if (a < batch->written_lo[lane])
+				batch->written_lo[lane] = a;
+			batch->written_hi[lane] = a;
+		}
+	}
+}
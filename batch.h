@@ -0,0 +1,91 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "chip8.h"
+
+/* Many instances of one machine and ROM stepped in lockstep, e.g. rollouts with different inputs.
+The state every instruction touches is kept as structure of arrays, one entry per lane: V0-VF, PC, I,
+the stack, timers, keypad and RNG. RAM and the display stay in a chip8 per lane. Each step, the lanes
+of a block that sit on the same PC with the same opcode execute it together as one vector operation;
+instructions without a vector form run one lane at a time: 00E0, Dxyn, Fx33, Fx55 and Fx65 straight on
+the lane arrays, the rare rest (Fx0A, faults, the SUPER-CHIP/XO-CHIP ones) through the scalar
+interpreter. Every lane ends up exactly where the same number of chip8_step() calls would have left it.
+Only register-bound code runs faster than separate machines; drawing and RAM-heavy code runs at best as
+fast. */
+#define CHIP8_BATCH_BLOCK 32 // lanes per block, one AVX2 register of 8-bit lanes
+
+typedef struct chip8_batch {
+	unsigned count; // lanes, a multiple of CHIP8_BATCH_BLOCK
+	uint8_t machine;
+	uint8_t quirks; // shared by every lane
+	chip8_step_fn step; // scalar interpreter for everything else
+	uint16_t addr_mask;
+	// per lane, indexed by lane
+	uint8_t* v[16];
+	uint16_t* pc;
+	uint16_t* i;
+	uint16_t* opcode;
+	uint16_t* stack[CHIP8_STACK_SIZE];
+	uint8_t* sp;
+	uint8_t* dt;
+	uint8_t* st;
+	uint16_t* keys; // written by the host
+	uint32_t* rng;
+	uint64_t* cycles;
+	uint8_t* fault; // a faulted lane is frozen until chip8_batch_put() replaces it
+	uint8_t* events; // CHIP8_EVENT_* bits, accumulated until the host clears them
+	/* RAM bytes lo..hi of a lane may differ from image, everything else is known to match it. Lanes on
+	the same PC only need their own opcode fetched when the PC falls in that range. */
+	uint16_t* written_lo;
+	uint16_t* written_hi;
+	chip8** lanes; // RAM, display and everything else, its copies of the fields above are stale
+	uint8_t* image; // RAM as loaded, shared by every lane
+	void* arena;
+} chip8_batch;
+
+// count is rounded up to a whole block. Lane n is seeded with seed + n. NULL when out of memory
+chip8_batch* chip8_batch_create(chip8_machine machine, unsigned quirks, unsigned count, uint32_t seed);
+void chip8_batch_free(chip8_batch* batch);
+// loads the program into every lane, false when it doesn't fit the machine
+bool chip8_batch_load(chip8_batch* batch, const uint8_t* program, size_t size);
+// every lane that hasn't faulted executes one instruction
+void chip8_batch_step(chip8_batch* batch);
+/* as many steps as instructions, the same as that many chip8_batch_step() calls. A block whose lanes have spread
+over many PCs runs the rest of it lane by lane on the scalar interpreter. */
+void chip8_batch_run(chip8_batch* batch, uint64_t instructions);
+// the 60hz delay and sound timer tick, for every lane
+void chip8_batch_tick(chip8_batch* batch);
+// copies one lane out as a whole machine, out must have room for chip8_size(batch->machine)
+void chip8_batch_get(const chip8_batch* batch, unsigned lane, chip8* out);
+// replaces one lane with a machine of the batch's type, e.g. to reset it; its quirks are ignored
+void chip8_batch_put(chip8_batch* batch, unsigned lane, const chip8* in);
+
+#endif
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
@@ -0,0 +1,573 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+/* Headless benchmark: runs ROMs, or synthetic loops of one opcode class each, for a fixed number of
+instructions on each interpreter and reports emulated MIPS. With --counters it also reads the host's
+hardware counters through perf_event_open around the timed loop and reports them per emulated
+instruction, which tells a dispatch or decode change apart from plain noise: host cycles and
+instructions per instruction, the branch miss rate and L1d misses. */
+
+#include <argp.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <linux/perf_event.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include "batch.h"
+#include "chip8.h"
+#include "rom.h"
+
+#define BENCH_INSTRUCTIONS 20000000
+#define BENCH_REPEAT 3
+#define BENCH_FRAME_CYCLES 500 // instructions between timer ticks, keeps ROMs waiting on DT moving
+#define MICRO_BODY 64 // copies of the measured instructions in each loop, the jump back is the only overhead
+
+//***engines***
+struct engine {
+	const char* name;
+	chip8_step_fn (*select)(const chip8* chip);
+};
+
+static chip8_step_fn select_specialized(const chip8* chip) {
+	return chip8_step_for(chip);
+}
+
+static chip8_step_fn select_generic(const chip8* chip) {
+	(void)chip;
+	return chip8_step;
+}
+
+static const struct engine engines[] = {
+	{"specialized", select_specialized},
+	{"generic", select_generic},
+};
+#define ENGINE_COUNT (sizeof(engines) / sizeof(engines[0]))
+
+//***hardware counters***
+enum {
+	COUNTER_CYCLES,
+	COUNTER_INSTRUCTIONS,
+	COUNTER_BRANCHES,
+	COUNTER_BRANCH_MISSES,
+	COUNTER_L1D_MISSES,
+	COUNTER_COUNT,
+};
+
+static const struct {
+	const char* name;
+	uint32_t type;
+	uint64_t config;
+} counter_events[COUNTER_COUNT] = {
+	[COUNTER_CYCLES] = {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+	[COUNTER_INSTRUCTIONS] = {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+	[COUNTER_BRANCHES] = {"branches", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS},
+	[COUNTER_BRANCH_MISSES] = {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+	[COUNTER_L1D_MISSES] = {"L1-dcache-load-misses", PERF_TYPE_HW_CACHE,
+		PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+};
+
+/* Every counter is its own event rather than one group, so a counter the CPU or hypervisor doesn't
+have only loses that column. When the kernel multiplexes them, the counts are scaled up by the share of
+time each one was actually running. */
+struct counters {
+	int fd[COUNTER_COUNT];
+	double value[COUNTER_COUNT]; // -1 when unavailable
+};
+
+static bool counters_open(struct counters* c) {
+	bool any = false;
+	for (int i = 0; i < COUNTER_COUNT; i++) {
+		struct perf_event_attr attr = {
+			.size = sizeof(attr),
+			.type = counter_events[i].type,
+			.config = counter_events[i].config,
+			.disabled = 1,
+			.exclude_kernel = 1, // user space only, allowed up to perf_event_paranoid 2
+			.exclude_hv = 1,
+			.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING,
+		};
+		c->fd[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+		if (c->fd[i] < 0)
+			fprintf(stderr, "counter %s unavailable: %s\n", counter_events[i].name, strerror(errno));
+		else
+			any = true;
+	}
+	return any;
+}
+
+static void counters_start(struct counters* c) {
+	for (int i = 0; i < COUNTER_COUNT; i++) {
+		if (c->fd[i] >= 0) {
+			ioctl(c->fd[i], PERF_EVENT_IOC_RESET, 0);
+			ioctl(c->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+}
+
+static void counters_stop(struct counters* c) {
+	for (int i = 0; i < COUNTER_COUNT; i++) {
+		c->value[i] = -1.0;
+		if (c->fd[i] < 0)
+			continue;
+		ioctl(c->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+		uint64_t data[3]; // value, time enabled, time running
+		if (read(c->fd[i], data, sizeof(data)) != sizeof(data) || data[2] == 0)
+			continue;
+		c->value[i] = (double)data[0] * ((double)data[1] / (double)data[2]);
+	}
+}
+
+static void counters_close(struct counters* c) {
+	for (int i = 0; i < COUNTER_COUNT; i++) {
+		if (c->fd[i] >= 0)
+			close(c->fd[i]);
+	}
+}
+
+//***microbenchmarks***
+/* Each one is a short setup followed by a loop of MICRO_BODY copies of its instructions and a jump
+back, so nearly every executed instruction belongs to the class being measured. */
+struct micro {
+	const char* name;
+	uint16_t setup[4];
+	uint16_t body[8]; // repeated in order, 0 ends it
+};
+
+static const struct micro micros[] = {
+	{"load", {0}, {0x6012, 0x6134, 0x6256, 0x6378}}, // 6xkk
+	{"add", {0}, {0x7001, 0x7103, 0x7205, 0x7307}}, // 7xkk
+	{"alu", {0x6005, 0x6103}, {0x8011, 0x8012, 0x8013, 0x8014, 0x8015, 0x8016, 0x8017, 0x801E}}, // 8xyn
+	{"skip", {0x6001}, {0x3000, 0x4001, 0x5010, 0x9000}}, // never taken
+	{"jump", {0}, {0x0000}}, // 1nnn to the next instruction, filled in by micro_build
+	{"call", {0}, {0x0000}}, // 2nnn to a 00EE, filled in by micro_build
+	{"index", {0x6001}, {0xA300, 0xF01E, 0xF01E, 0xF029}}, // Annn, Fx1E, Fx29
+	{"memory", {0}, {0xA800, 0xF355, 0xA800, 0xF365}}, // Fx55/Fx65, I reset around the memory_increment quirk
+	{"bcd", {0x60FE}, {0xA800, 0xF033}}, // Fx33
+	{"random", {0}, {0xC0FF, 0xC10F}}, // Cxkk
+	{"timers", {0x6010}, {0xF015, 0xF107, 0xF018}}, // Fx15, Fx07, Fx18
+	{"draw", {0x6008, 0x6108, 0xF029}, {0xD015, 0xD015}}, // Dxyn, XORs the sprite on and off
+	{"mixed", {0x6001}, {0x6123, 0x7101, 0x8214, 0x3000, 0xA300, 0xC0FF, 0xF01E, 0x8106}}, // dispatch across classes
+};
+#define MICRO_COUNT (sizeof(micros) / sizeof(micros[0]))
+
+static void put16(uint8_t* program, size_t* size, uint16_t opcode) {
+	program[(*size)++] = opcode >> 8;
+	program[(*size)++] = opcode & 0xFFu;
+}
+
+// returns the program size, program must hold at least 2 KB
+static size_t micro_build(const struct micro* m, uint8_t* program) {
+	size_t size = 0;
+	for (int i = 0; i < 4 && m->setup[i]; i++)
+		put16(program, &size, m->setup[i]);
+	uint16_t loop = START_ADDRESS + size;
+	uint16_t sub = START_ADDRESS + 0x700; // return-only subroutine for the call benchmark
+	for (int n = 0; n < MICRO_BODY;) {
+		for (int i = 0; i < 8 && n < MICRO_BODY; i++, n++) {
+			uint16_t opcode = m->body[i];
+			if (strcmp(m->name, "jump") == 0)
+				opcode = 0x1000 | (START_ADDRESS + size + 2);
+			else if (strcmp(m->name, "call") == 0)
+				opcode = 0x2000 | sub;
+			else if (opcode == 0)
+				break;
+			put16(program, &size, opcode);
+		}
+	}
+	put16(program, &size, 0x1000 | loop);
+	if (strcmp(m->name, "call") == 0) {
+		size = sub - START_ADDRESS;
+		put16(program, &size, 0x00EE);
+	}
+	return size;
+}
+
+//***arguments***
+struct arguments {
+	char** roms;
+	int rom_count;
+	chip8_machine machine;
+	const char* quirks;
+	uint64_t instructions;
+	int repeat;
+	const struct engine* engine; // NULL for all of them
+	bool micro;
+	bool counters;
+	unsigned batch; // lanes, 0 to measure single machines
+};
+
+enum {
+	OPT_MICRO = 256,
+	OPT_BATCH,
+};
+
+static struct argp_option options[] = {
+	{"machine", 'm', "NAME", 0, "Machine to run on: chip8, schip or xochip. Defaults to chip8", 0},
+	{"quirks", 'q', "LIST", 0, "Quirks, same syntax as the emulator's --quirks. Defaults to the machine's profile", 0},
+	{"instructions", 'n', "COUNT", 0, "Instructions per run. Defaults to 20000000", 0},
+	{"repeat", 'r', "COUNT", 0, "Runs of each benchmark, the fastest is reported. Defaults to 3", 0},
+	{"engine", 'e', "NAME", 0, "Interpreter to measure: specialized or generic. Defaults to both", 0},
+	{"micro", OPT_MICRO, 0, 0, "Run the per-opcode-class microbenchmarks, the default without ROMs", 0},
+	{"counters", 'c', 0, 0, "Read hardware performance counters around each run", 0},
+	{"batch", OPT_BATCH, "LANES", 0, "Run LANES copies of each benchmark as one lockstep batch, and as that many separate machines", 0},
+	{0}
+};
+
+static error_t parse_opt(int key, char* arg, struct argp_state* state) {
+	struct arguments* arguments = state->input;
+	switch (key) {
+		case 'm':
+			if (!chip8_parse_machine(arg, &arguments->machine))
+				argp_error(state, "unknown machine '%s'", arg);
+			break;
+		case 'q':
+			arguments->quirks = arg;
+			break;
+		case 'n':
+			arguments->instructions = strtoull(arg, NULL, 10);
+			if (arguments->instructions == 0)
+				argp_error(state, "instructions must be at least 1");
+			break;
+		case 'r':
+			arguments->repeat = atoi(arg);
+			if (arguments->repeat < 1)
+				argp_error(state, "repeat must be at least 1");
+			break;
+		case 'e':
+			arguments->engine = NULL;
+			for (size_t i = 0; i < ENGINE_COUNT; i++) {
+				if (strcmp(engines[i].name, arg) == 0)
+					arguments->engine = &engines[i];
+			}
+			if (!arguments->engine)
+				argp_error(state, "unknown engine '%s'", arg);
+			break;
+		case OPT_MICRO:
+			arguments->micro = true;
+			break;
+		case 'c':
+			arguments->counters = true;
+			break;
+		case OPT_BATCH:
+			arguments->batch = strtoul(arg, NULL, 10);
+			if (arguments->batch == 0)
+				argp_error(state, "batch needs at least 1 lane");
+			break;
+		case ARGP_KEY_ARGS:
+			arguments->roms = state->argv + state->next;
+			arguments->rom_count = state->argc - state->next;
+			break;
+		case ARGP_KEY_NO_ARGS:
+			arguments->micro = true;
+			break;
+		default:
+			return ARGP_ERR_UNKNOWN;
+	}
+	return 0;
+}
+
+static struct argp argp = {
+	.options = options,
+	.parser = parse_opt,
+	.args_doc = "[ROM...]",
+	.doc = "Measures the CHIP-8 interpreters on ROMs and per-opcode-class loops",
+};
+
+//***runs***
+static uint64_t now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+struct result {
+	uint64_t instructions;
+	uint64_t ns;
+	double counter[COUNTER_COUNT];
+};
+
+static void counted_start(struct counters* counters, uint64_t* start) {
+	if (counters)
+		counters_start(counters);
+	*start = now_ns();
+}
+
+static void counted_stop(struct counters* counters, uint64_t start, struct result* r) {
+	r->ns = now_ns() - start;
+	if (counters) {
+		counters_stop(counters);
+		memcpy(r->counter, counters->value, sizeof(r->counter));
+	}
+}
+
+// the timed loop, only the steps and the timer ticks are inside the counted region
+static void run_once(chip8* chip, chip8_step_fn step, uint64_t instructions, struct counters* counters, struct result* r) {
+	uint64_t start;
+	counted_start(counters, &start);
+	uint64_t n = 0;
+	while (n < instructions && !chip->fault) {
+		uint64_t frame = instructions - n < BENCH_FRAME_CYCLES ? instructions - n : BENCH_FRAME_CYCLES;
+		for (uint64_t i = 0; i < frame; i++)
+			step(chip);
+		n += frame;
+		if (chip->timer_delay > 0)
+			chip->timer_delay--;
+		if (chip->timer_sound > 0)
+			chip->timer_sound--;
+	}
+	counted_stop(counters, start, r);
+	r->instructions = chip->cycles;
+}
+
+// the same work as the batch below, one machine after the other on the specialized interpreter
+static void run_lanes_once(chip8** lanes, unsigned count, uint64_t steps, struct counters* counters, struct result* r) {
+	chip8_step_fn step = chip8_step_for(lanes[0]);
+	uint64_t start;
+	counted_start(counters, &start);
+	for (uint64_t n = 0; n < steps; n += BENCH_FRAME_CYCLES) {
+		uint64_t frame = steps - n < BENCH_FRAME_CYCLES ? steps - n : BENCH_FRAME_CYCLES;
+		for (unsigned l = 0; l < count; l++) {
+			chip8* chip = lanes[l];
+			for (uint64_t i = 0; i < frame && !chip->fault; i++)
+				step(chip);
+			if (chip->timer_delay > 0)
+				chip->timer_delay--;
+			if (chip->timer_sound > 0)
+				chip->timer_sound--;
+		}
+	}
+	counted_stop(counters, start, r);
+	r->instructions = 0;
+	for (unsigned l = 0; l < count; l++)
+		r->instructions += lanes[l]->cycles;
+}
+
+static void run_batch_once(chip8_batch* batch, unsigned count, uint64_t steps, struct counters* counters, struct result* r) {
+	uint64_t start;
+	counted_start(counters, &start);
+	for (uint64_t n = 0; n < steps; n += BENCH_FRAME_CYCLES) {
+		uint64_t frame = steps - n < BENCH_FRAME_CYCLES ? steps - n : BENCH_FRAME_CYCLES;
+		chip8_batch_run(batch, frame);
+		chip8_batch_tick(batch);
+	}
+	counted_stop(counters, start, r);
+	r->instructions = 0;
+	for (unsigned l = 0; l < count; l++)
+		r->instructions += batch->cycles[l];
+}
+
+static void print_header(bool counters) {
+	printf("%-24s %-12s %12s %8s", "benchmark", "engine", "instructions", "MIPS");
+	if (counters)
+		printf(" %8s %8s %6s %8s %8s %8s", "cyc/ins", "ins/ins", "IPC", "br-miss%", "miss/ins", "L1d/kins");
+	printf("\n");
+}
+
+static void print_ratio(double num, double den, double scale, const char* format) {
+	if (num < 0.0 || den <= 0.0)
+		printf(" %8s", "-");
+	else
+		printf(format, num / den * scale);
+}
+
+static void print_result(const char* name, const char* engine, const struct result* r, bool counters) {
+	printf("%-24s %-12s %12" PRIu64 " %8.1f", name, engine, r->instructions,
+		r->ns ? (double)r->instructions * 1e3 / (double)r->ns : 0.0);
+	if (counters) {
+		double n = (double)r->instructions;
+		print_ratio(r->counter[COUNTER_CYCLES], n, 1.0, " %8.2f");
+		print_ratio(r->counter[COUNTER_INSTRUCTIONS], n, 1.0, " %8.2f");
+		if (r->counter[COUNTER_CYCLES] > 0.0 && r->counter[COUNTER_INSTRUCTIONS] >= 0.0)
+			printf(" %6.2f", r->counter[COUNTER_INSTRUCTIONS] / r->counter[COUNTER_CYCLES]);
+		else
+			printf(" %6s", "-");
+		print_ratio(r->counter[COUNTER_BRANCH_MISSES], r->counter[COUNTER_BRANCHES], 100.0, " %8.3f");
+		print_ratio(r->counter[COUNTER_BRANCH_MISSES], n, 1.0, " %8.4f");
+		print_ratio(r->counter[COUNTER_L1D_MISSES], n, 1000.0, " %8.3f");
+	}
+	printf("\n");
+}
+
+// runs program on every selected engine, -1 when it could not be set up
+static int bench(const char* name, const uint8_t* program, size_t size, const struct arguments* args, struct counters* counters) {
+	size_t chip_size = chip8_size(args->machine);
+	chip8* chip = malloc(chip_size);
+	if (!chip) {
+		fprintf(stderr, "%s: could not allocate memory\n", name);
+		return -1;
+	}
+	int status = 0;
+	for (size_t e = 0; e < ENGINE_COUNT; e++) {
+		if (args->engine && args->engine != &engines[e])
+			continue;
+		struct result best = {0};
+		for (int rep = 0; rep < args->repeat; rep++) {
+			// every run starts from the same state, the seed only feeds Cxkk
+			chip8_init(chip, args->machine, 1);
+			if (args->quirks) { // validated in main
+				unsigned quirks = chip->quirks;
+				chip8_parse_quirks(args->quirks, &quirks);
+				chip->quirks = quirks;
+			}
+			if (!chip8_load(chip, program, size)) {
+				fprintf(stderr, "%s: too big for the %s machine\n", name, chip8_machine_name(args->machine));
+				status = -1;
+				goto done;
+			}
+			struct result r;
+			run_once(chip, engines[e].select(chip), args->instructions, counters, &r);
+			if (rep == 0 || r.ns < best.ns)
+				best = r;
+		}
+		print_result(name, engines[e].name, &best, counters != NULL);
+		if (chip->fault)
+			printf("%-24s stopped early: %s at %03X\n", "", chip8_fault_name(chip->fault), chip->pc);
+	}
+done:
+	free(chip);
+	return status;
+}
+
+/* args->batch copies of program, stepped together by the batch core and then as separate machines.
+The instruction count is split between the lanes, the lanes only differ in their Cxkk seeds. */
+static int bench_batch(const char* name, const uint8_t* program, size_t size, const struct arguments* args, struct counters* counters) {
+	unsigned count = args->batch;
+	uint64_t steps = args->instructions / count ? args->instructions / count : 1;
+	char label[32];
+	int status = -1;
+	chip8** lanes = calloc(count, sizeof(*lanes));
+	if (!lanes) {
+		fprintf(stderr, "%s: could not allocate memory\n", name);
+		return -1;
+	}
+	unsigned quirks = chip8_default_quirks(args->machine);
+	if (args->quirks) // validated in main
+		chip8_parse_quirks(args->quirks, &quirks);
+
+	struct result best = {0};
+	for (int rep = 0; rep < args->repeat; rep++) {
+		chip8_batch* batch = chip8_batch_create(args->machine, quirks, count, 1);
+		if (!batch) {
+			fprintf(stderr, "%s: could not allocate memory\n", name);
+			goto done;
+		}
+		if (!chip8_batch_load(batch, program, size)) {
+			fprintf(stderr, "%s: too big for the %s machine\n", name, chip8_machine_name(args->machine));
+			chip8_batch_free(batch);
+			goto done;
+		}
+		struct result r;
+		run_batch_once(batch, count, steps, counters, &r);
+		if (rep == 0 || r.ns < best.ns)
+			best = r;
+		chip8_batch_free(batch);
+	}
+	snprintf(label, sizeof(label), "batch x%u", count);
+	print_result(name, label, &best, counters != NULL);
+
+	for (unsigned l = 0; l < count; l++) {
+		lanes[l] = malloc(chip8_size(args->machine));
+		if (!lanes[l]) {
+			fprintf(stderr, "%s: could not allocate memory\n", name);
+			goto done;
+		}
+	}
+	for (int rep = 0; rep < args->repeat; rep++) {
+		for (unsigned l = 0; l < count; l++) {
+			chip8_init(lanes[l], args->machine, 1 + l);
+			lanes[l]->quirks = quirks;
+			chip8_load(lanes[l], program, size); // fits, the batch took it
+		}
+		struct result r;
+		run_lanes_once(lanes, count, steps, counters, &r);
+		if (rep == 0 || r.ns < best.ns)
+			best = r;
+	}
+	snprintf(label, sizeof(label), "scalar x%u", count);
+	print_result(name, label, &best, counters != NULL);
+	status = 0;
+done:
+	for (unsigned l = 0; l < count; l++)
+		free(lanes[l]);
+	free(lanes);
+	return status;
+}
+
+int main(int argc, char* argv[]) {
+	struct arguments arguments = {
+		.machine = CHIP8_MACHINE_CHIP8,
+		.instructions = BENCH_INSTRUCTIONS,
+		.repeat = BENCH_REPEAT,
+	};
+	argp_parse(&argp, argc, argv, 0, 0, &arguments);
+	if (arguments.quirks && !chip8_parse_quirks(arguments.quirks, &(unsigned){0})) {
+		fprintf(stderr, "Unknown quirk in '%s'\n", arguments.quirks);
+		return 1;
+	}
+
+	struct counters counters;
+	struct counters* active = NULL;
+	if (arguments.counters) {
+		if (counters_open(&counters))
+			active = &counters;
+		else
+			fprintf(stderr, "No hardware counters, check /proc/sys/kernel/perf_event_paranoid. Reporting time only\n");
+	}
+
+	int failed = 0;
+	print_header(active != NULL);
+	if (arguments.micro) {
+		static uint8_t program[0x800];
+		for (size_t i = 0; i < MICRO_COUNT; i++) {
+			size_t size = micro_build(&micros[i], program);
+			if ((arguments.batch ? bench_batch : bench)(micros[i].name, program, size, &arguments, active) < 0)
+				failed++;
+		}
+	}
+	for (int i = 0; i < arguments.rom_count; i++) {
+		struct rom rom;
+		rom_status status = rom_open(&rom, arguments.roms[i], XOCHIP_RAM_SIZE - START_ADDRESS);
+		if (status != ROM_OK) {
+			fprintf(stderr, "%s: %s\n", arguments.roms[i], rom_status_name(status));
+			failed++;
+			continue;
+		}
+		// the file name is enough to tell ROMs apart in the table
+		const char* name = strrchr(arguments.roms[i], '/');
+		if ((arguments.batch ? bench_batch : bench)(name ? name + 1 : arguments.roms[i], rom.data, rom.size, &arguments, active) < 0)
+			failed++;
+		rom_close(&rom);
+	}
+	if (active)
+		counters_close(active);
+	return failed != 0;
+}
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
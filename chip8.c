@@ -0,0 +1,1066 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "chip8.h"
+
+//font sprite magic numbers
+static const uint8_t fontset[FONTSET_SIZE] =
+{
+0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
+0x20, 0x60, 0x20, 0x20, 0x70, // 1
+0xF0, 0x10, 0xF0, 0x80, 0xF0, // 2
+0xF0, 0x10, 0xF0, 0x10, 0xF0, // 3
+0x90, 0x90, 0xF0, 0x10, 0x10, // 4
+0xF0, 0x80, 0xF0, 0x10, 0xF0, // 5
+0xF0, 0x80, 0xF0, 0x90, 0xF0, // 6
+0xF0, 0x10, 0x20, 0x40, 0x40, // 7
+0xF0, 0x90, 0xF0, 0x90, 0xF0, // 8
+0xF0, 0x90, 0xF0, 0x10, 0xF0, // 9
+0xF0, 0x90, 0xF0, 0x90, 0x90, // A
+0xE0, 0x90, 0xE0, 0x90, 0xE0, // B
+0xF0, 0x80, 0x80, 0x80, 0xF0, // C
+0xE0, 0x90, 0x90, 0x90, 0xE0, // D
+0xF0, 0x80, 0xF0, 0x80, 0xF0, // E
+0xF0, 0x80, 0xF0, 0x80, 0x80	// F
+};
+
+//SUPER-CHIP 8x10 digits for Fx30
+static const uint8_t big_fontset[BIG_FONTSET_SIZE] =
+{
+0x3C, 0x7E, 0xE7, 0xC3, 0xC3, 0xC3, 0xC3, 0xE7, 0x7E, 0x3C, // 0
+0x18, 0x38, 0x58, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x3C, // 1
+0x3E, 0x7F, 0xC3, 0x06, 0x0C, 0x18, 0x30, 0x60, 0xFF, 0xFF, // 2
+0x3C, 0x7E, 0xC3, 0x03, 0x0E, 0x0E, 0x03, 0xC3, 0x7E, 0x3C, // 3
+0x06, 0x0E, 0x1E, 0x36, 0x66, 0xC6, 0xFF, 0xFF, 0x06, 0x06, // 4
+0xFF, 0xFF, 0xC0, 0xC0, 0xFC, 0xFE, 0x03, 0xC3, 0x7E, 0x3C, // 5
+0x3E, 0x7C, 0xC0, 0xC0, 0xFC, 0xFE, 0xC3, 0xC3, 0x7E, 0x3C, // 6
+0xFF, 0xFF, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x60, 0x60, // 7
+0x3C, 0x7E, 0xC3, 0xC3, 0x7E, 0x7E, 0xC3, 0xC3, 0x7E, 0x3C, // 8
+0x3C, 0x7E, 0xC3, 0xC3, 0x7F, 0x3F, 0x03, 0x03, 0x3E, 0x7C, // 9
+0x3C, 0x7E, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xC3, 0xC3, // A
+0xFC, 0xFE, 0xC3, 0xC3, 0xFE, 0xFE, 0xC3, 0xC3, 0xFE, 0xFC, // B
+0x3C, 0x7E, 0xC3, 0xC0, 0xC0, 0xC0, 0xC0, 0xC3, 0x7E, 0x3C, // C
+0xFC, 0xFE, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFE, 0xFC, // D
+0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, // E
+0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xC0, 0xC0	// F
+};
+
+typedef unsigned __int128 chip8_row;
+
+size_t chip8_size(chip8_machine machine) {
+	return sizeof(chip8) + (machine == CHIP8_MACHINE_XOCHIP ? XOCHIP_RAM_SIZE : CHIP8_RAM_SIZE);
+}
+
+chip8* chip8_create(chip8_machine machine, uint32_t seed) {
+	chip8* chip = malloc(chip8_size(machine));
+	if (chip)
+		chip8_init(chip, machine, seed);
+	return chip;
+}
+
+void chip8_init(chip8* chip, chip8_machine machine, uint32_t seed) {
+	memset(chip, 0, chip8_size(machine));
+	chip->ram_size = machine == CHIP8_MACHINE_XOCHIP ? XOCHIP_RAM_SIZE : CHIP8_RAM_SIZE;
+	memcpy(&chip->ram[FONT_START_ADDRESS], fontset, FONTSET_SIZE);
+	memcpy(&chip->ram[BIG_FONT_START_ADDRESS], big_fontset, BIG_FONTSET_SIZE);
+	chip->machine = machine;
+	chip->quirks = chip8_default_quirks(machine);
+	chip->planes = 1;
+	chip->pitch = 64;
+	// until F002 loads one, XO-CHIP plays a plain square wave
+	for (int i = 0; i < 16; i++)
+		chip->pattern[i] = i & 1 ? 0x00 : 0xFF;
+	chip->pc = START_ADDRESS;
+	chip->drawn = ~0ull; // no row hashed yet
+	// xorshift gets stuck on 0
+	chip->rng = seed ? seed : 0x2545F491u;
+}
+
+bool chip8_load(chip8* chip, const uint8_t* program, size_t size) {
+	if (size > chip->ram_size - START_ADDRESS)
+		return false;
+	memcpy(&chip->ram[START_ADDRESS], program, size);
+	return true;
+}
+
+const char* chip8_fault_name(chip8_fault fault) {
+	switch (fault) {
+		case CHIP8_FAULT_NONE:
+			return "no fault";
+		case CHIP8_FAULT_STACK_UNDERFLOW:
+			return "stack underflow";
+		case CHIP8_FAULT_STACK_OVERFLOW:
+			return "stack overflow";
+		case CHIP8_FAULT_EXIT:
+			return "program exited";
+	}
+	return "unknown fault";
+}
+
+unsigned chip8_default_quirks(chip8_machine machine) {
+	switch (machine) {
+		case CHIP8_MACHINE_CHIP8:
+			return CHIP8_QUIRKS_CHIP8;
+		case CHIP8_MACHINE_SCHIP:
+			return CHIP8_QUIRKS_SCHIP;
+		case CHIP8_MACHINE_XOCHIP:
+			return CHIP8_QUIRKS_XOCHIP;
+	}
+	return CHIP8_QUIRKS_CHIP8;
+}
+
+static const struct {
+	const char* name;
+	unsigned quirks;
+	bool profile;
+} quirk_names[] = {
+	{"chip8", CHIP8_QUIRKS_CHIP8, true},
+	{"vip", CHIP8_QUIRKS_VIP, true},
+	{"schip", CHIP8_QUIRKS_SCHIP, true},
+	{"xochip", CHIP8_QUIRKS_XOCHIP, true},
+	{"vf_reset", CHIP8_QUIRK_VF_RESET, false},
+	{"memory_increment", CHIP8_QUIRK_MEMORY_INCREMENT, false},
+	{"shift_vx", CHIP8_QUIRK_SHIFT_VX, false},
+	{"jump_vx", CHIP8_QUIRK_JUMP_VX, false},
+	{"clip", CHIP8_QUIRK_CLIP, false},
+};
+
+bool chip8_parse_quirks(const char* spec, unsigned* quirks) {
+	unsigned result = *quirks;
+	while (*spec) {
+		size_t len = strcspn(spec, ",");
+		bool clear = spec[0] == '-';
+		const char* name = spec + clear;
+		size_t name_len = len - clear;
+		bool found = false;
+		for (size_t i = 0; i < sizeof(quirk_names) / sizeof(quirk_names[0]); i++) {
+			if (strlen(quirk_names[i].name) != name_len || strncmp(quirk_names[i].name, name, name_len) != 0)
+				continue;
+			if (quirk_names[i].profile && clear)
+				return false;
+			if (quirk_names[i].profile)
+				result = quirk_names[i].quirks;
+			else if (clear)
+				result &= ~quirk_names[i].quirks;
+			else
+				result |= quirk_names[i].quirks;
+			found = true;
+			break;
+		}
+		if (!found)
+			return false;
+		spec += len;
+		if (*spec == ',')
+			spec++;
+	}
+	*quirks = result;
+	return true;
+}
+
+void chip8_format_quirks(unsigned quirks, char* buf, size_t size) {
+	size_t used = 0;
+	buf[0] = '\0';
+	for (size_t i = 0; i < sizeof(quirk_names) / sizeof(quirk_names[0]); i++) {
+		if (quirk_names[i].profile || !(quirks & quirk_names[i].quirks))
+			continue;
+		int n = snprintf(buf + used, size - used, "%s%s", used ? "," : "", quirk_names[i].name);
+		if (n < 0 || (size_t)n >= size - used)
+			break;
+		used += n;
+	}
+}
+
+bool chip8_parse_machine(const char* name, chip8_machine* machine) {
+	if (strcmp(name, "chip8") == 0)
+		*machine = CHIP8_MACHINE_CHIP8;
+	else if (strcmp(name, "schip") == 0)
+		*machine = CHIP8_MACHINE_SCHIP;
+	else if (strcmp(name, "xochip") == 0)
+		*machine = CHIP8_MACHINE_XOCHIP;
+	else
+		return false;
+	return true;
+}
+
+const char* chip8_machine_name(chip8_machine machine) {
+	switch (machine) {
+		case CHIP8_MACHINE_CHIP8:
+			return "chip8";
+		case CHIP8_MACHINE_SCHIP:
+			return "schip";
+		case CHIP8_MACHINE_XOCHIP:
+			return "xochip";
+	}
+	return "unknown";
+}
+
+static inline uint64_t rotr64(uint64_t v, unsigned n) {
+	return (v >> (n & 63)) | (v << ((64 - n) & 63));
+}
+
+static inline chip8_row rotr128(chip8_row v, unsigned n) {
+	return (v >> (n & 127)) | (v << ((128 - n) & 127));
+}
+
+static inline chip8_row load_row(const chip8_plane plane, unsigned y) {
+	return ((chip8_row)plane[y][0] << 64) | plane[y][1];
+}
+
+static inline void store_row(chip8_plane plane, unsigned y, chip8_row row) {
+	plane[y][0] = row >> 64;
+	plane[y][1] = (uint64_t)row;
+}
+
+// the interpreters below are instantiated per machine and quirk set, so everything they use must inline
+#define CHIP8_INLINE static inline __attribute__((always_inline))
+
+/* Sprites are XORed a whole row at a time: the sprite row is placed at the left edge of a display row
+word and rotated into position, which also wraps it around the right edge. With clipping it is shifted
+instead and the rows below the screen are dropped. The start position always wraps. Returns VF. */
+CHIP8_INLINE uint8_t draw_lores_impl(chip8* chip, chip8_plane plane, uint16_t addr, unsigned x, unsigned y, unsigned height, bool wide, bool clip) {
+	const unsigned mask = chip->ram_size - 1u; // shared by all machines, so the mask comes from the instance
+	uint8_t collision = 0;
+	x %= CHIP8_WIDTH;
+	y %= CHIP8_HEIGHT;
+	if (clip && y + height > CHIP8_HEIGHT)
+		height = CHIP8_HEIGHT - y;
+	for (unsigned row = 0; row < height; row++) {
+		uint64_t sprite = wide
+			? (uint64_t)((chip->ram[(addr + 2 * row) & mask] << 8) | chip->ram[(addr + 2 * row + 1) & mask]) << 48
+			: (uint64_t)chip->ram[(addr + row) & mask] << 56;
+		uint64_t bits = clip ? sprite >> x : rotr64(sprite, x);
+		unsigned line = (y + row) % CHIP8_HEIGHT;
+		collision |= (plane[line][0] & bits) != 0;
+		plane[line][0] ^= bits;
+		chip->drawn |= 1ull << line;
+	}
+	return collision;
+}
+
+// SUPER-CHIP 1.1 sets VF to the number of rows that collided in hi-res
+CHIP8_INLINE uint8_t draw_hires_impl(chip8* chip, chip8_plane plane, uint16_t addr, unsigned x, unsigned y, unsigned height, bool wide, bool clip) {
+	const unsigned mask = chip->ram_size - 1u;
+	uint8_t collisions = 0;
+	x %= CHIP8_HIRES_WIDTH;
+	y %= CHIP8_HIRES_HEIGHT;
+	if (clip && y + height > CHIP8_HIRES_HEIGHT) {
+		// SUPER-CHIP 1.1 also counts the rows that fell off the bottom, XO-CHIP doesn't
+		if (chip->machine == CHIP8_MACHINE_SCHIP)
+			collisions = y + height - CHIP8_HIRES_HEIGHT;
+		height = CHIP8_HIRES_HEIGHT - y;
+	}
+	for (unsigned row = 0; row < height; row++) {
+		chip8_row sprite = wide
+			? (chip8_row)((chip->ram[(addr + 2 * row) & mask] << 8) | chip->ram[(addr + 2 * row + 1) & mask]) << 112
+			: (chip8_row)chip->ram[(addr + row) & mask] << 120;
+		chip8_row bits = clip ? sprite >> x : rotr128(sprite, x);
+		unsigned line = (y + row) % CHIP8_HIRES_HEIGHT;
+		chip8_row current = load_row(plane, line);
+		collisions += (current & bits) != 0;
+		store_row(plane, line, current ^ bits);
+		chip->drawn |= 1ull << line;
+	}
+	return collisions;
+}
+
+/* Drawing is too big to copy into every interpreter, so there is one out of line copy per clipping mode
+and the interpreters pick theirs at compile time. */
+#define CHIP8_DRAW_VARIANT(res, mode, clip) \
+	static __attribute__((noinline)) uint8_t draw_##res##_##mode(chip8* chip, chip8_plane plane, uint16_t addr, unsigned x, unsigned y, unsigned height, bool wide) { \
+		return draw_##res##_impl(chip, plane, addr, x, y, height, wide, clip); \
+	}
+CHIP8_DRAW_VARIANT(lores, wrap, false)
+CHIP8_DRAW_VARIANT(lores, clip, true)
+CHIP8_DRAW_VARIANT(hires, wrap, false)
+CHIP8_DRAW_VARIANT(hires, clip, true)
+
+// 00Cn and XO-CHIP 00Dn, rows are whole words so this is a memmove. Negative n scrolls up
+static __attribute__((noinline)) void scroll_vertical(chip8_plane plane, bool hires, int n) {
+	unsigned height = hires ? CHIP8_HIRES_HEIGHT : CHIP8_HEIGHT;
+	unsigned shift = n < 0 ? -n : n;
+	if (shift > height)
+		shift = height;
+	if (n > 0) {
+		memmove(plane[shift], plane[0], (height - shift) * sizeof(plane[0]));
+		memset(plane[0], 0, shift * sizeof(plane[0]));
+	} else {
+		memmove(plane[0], plane[shift], (height - shift) * sizeof(plane[0]));
+		memset(plane[height - shift], 0, shift * sizeof(plane[0]));
+	}
+}
+
+// 00FB and 00FC, 4 pixels of the current resolution. Negative n scrolls left
+static __attribute__((noinline)) void scroll_horizontal(chip8_plane plane, bool hires, int n) {
+	if (hires) {
+		for (unsigned y = 0; y < CHIP8_HIRES_HEIGHT; y++) {
+			chip8_row row = load_row(plane, y);
+			store_row(plane, y, n > 0 ? row >> n : row << -n);
+		}
+	} else {
+		for (unsigned y = 0; y < CHIP8_HEIGHT; y++)
+			plane[y][0] = n > 0 ? plane[y][0] >> n : plane[y][0] << -n;
+	}
+}
+
+// Dxyn from addr, returns VF
+CHIP8_INLINE uint8_t draw_sprite(chip8* chip, const unsigned quirks, const chip8_machine machine, uint16_t addr, unsigned x, unsigned y, unsigned height) {
+	bool wide = height == 0 && machine >= CHIP8_MACHINE_SCHIP;
+	if (wide)
+		height = 16;
+	// XO-CHIP draws one sprite per selected plane, stored back to back from I
+	uint8_t collision = 0;
+	for (unsigned p = 0; p < (machine == CHIP8_MACHINE_XOCHIP ? CHIP8_PLANES : 1u); p++) {
+		if (!(chip->planes & (1u << p)))
+			continue;
+		if (chip->hires)
+			collision |= (quirks & CHIP8_QUIRK_CLIP) ? draw_hires_clip(chip, chip->display[p], addr, x, y, height, wide) : draw_hires_wrap(chip, chip->display[p], addr, x, y, height, wide);
+		else
+			collision |= (quirks & CHIP8_QUIRK_CLIP) ? draw_lores_clip(chip, chip->display[p], addr, x, y, height, wide) : draw_lores_wrap(chip, chip->display[p], addr, x, y, height, wide);
+		addr += wide ? 32 : height;
+	}
+	// only SUPER-CHIP counts rows in hi-res, XO-CHIP sets VF to 1 on any collision
+	return machine == CHIP8_MACHINE_XOCHIP ? collision != 0 : collision;
+}
+
+uint8_t chip8_draw(chip8* chip, uint16_t addr, uint8_t x, uint8_t y, unsigned height) {
+	return draw_sprite(chip, chip->quirks, chip->machine, addr, x, y, height);
+}
+
+/* Every RAM access in the interpreters goes through these. Addresses wrap around the machine's address
+space, 12 bits or XO-CHIP's 16, with a mask rather than a bounds check, so whatever PC and I hold a ROM
+can't reach outside ram[]. The machine is a constant in the specialized interpreters, so is the mask. */
+CHIP8_INLINE unsigned addr_mask(const chip8_machine machine) {
+	return machine == CHIP8_MACHINE_XOCHIP ? XOCHIP_RAM_SIZE - 1u : CHIP8_RAM_SIZE - 1u;
+}
+
+CHIP8_INLINE uint8_t mem_read(const chip8* chip, const chip8_machine machine, unsigned addr) {
+	return chip->ram[addr & addr_mask(machine)];
+}
+
+// debug is NULL, and the watchpoint check gone, everywhere but chip8_step_debug()
+CHIP8_INLINE void mem_write(chip8* chip, const chip8_machine machine, struct chip8_debug* const debug, unsigned addr, uint8_t value) {
+	addr &= addr_mask(machine);
+	chip->ram[addr] = value;
+	chip->dirty[addr / CHIP8_DIRTY_BLOCK / 64] |= 1ull << (addr / CHIP8_DIRTY_BLOCK % 64);
+	if (debug && chip8_debug_test(debug->watchpoints, addr)) {
+		debug->watch_addr = addr;
+		chip->events |= CHIP8_EVENT_WATCHPOINT;
+	}
+}
+
+CHIP8_INLINE uint16_t mem_read16(const chip8* chip, const chip8_machine machine, unsigned addr) {
+	return (mem_read(chip, machine, addr) << 8u) | mem_read(chip, machine, addr + 1);
+}
+
+// skip the next instruction, XO-CHIP skips over the whole of a 4 byte F000 nnnn
+CHIP8_INLINE void skip_next(chip8* chip, const chip8_machine machine) {
+	if (machine == CHIP8_MACHINE_XOCHIP && mem_read16(chip, machine, chip->pc) == 0xF000u)
+		chip->pc += 4;
+	else
+		chip->pc += 2;
+}
+
+// xorshift32, the core can't depend on raylib for Cxkk
+static inline uint8_t chip8_random(chip8* chip) {
+	uint32_t x = chip->rng;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	chip->rng = x;
+	return x >> 24;
+}
+
+// the register a flag-setting instruction wrote, VF on its own when it was the destination too
+CHIP8_INLINE uint8_t traced_with_flag(unsigned x) {
+	return x == 0xFu ? 0xFu : x | CHIP8_TRACE_REG_MORE;
+}
+
+// trace is NULL, and the record gone, everywhere but chip8_step_trace() and a tracing chip8_step_debug()
+CHIP8_INLINE void trace_append(const chip8* chip, struct chip8_trace* const trace, uint16_t pc, uint8_t reg) {
+	if (trace->head == trace->limit) {
+		trace->sync(trace);
+		if (trace->head == trace->limit) {
+			trace->dropped++;
+			return;
+		}
+	}
+	trace->ring[trace->head++ & trace->mask] = (struct chip8_trace_record){
+		.cycle = chip->cycles,
+		.pc = pc,
+		.opcode = chip->opcode,
+		.i = chip->idx_reg,
+		.reg = reg,
+		.value = reg == CHIP8_TRACE_REG_NONE ? 0 : chip->registers[reg & 0xFu],
+	};
+}
+
+/* The one interpreter body. quirks and machine are compile-time constants in every instantiation
+below, so the quirk and machine checks fold away. The instruction cases note the register they wrote
+in traced, which is dead code unless there is a trace. */
+CHIP8_INLINE double step_impl(chip8* chip, const unsigned quirks, const chip8_machine machine, struct chip8_debug* const debug, struct chip8_trace* const trace) {
+	double wait = 0.002;
+	const uint16_t pc = chip->pc;
+	uint8_t traced = CHIP8_TRACE_REG_NONE;
+	if (debug) {
+		if (chip8_debug_test(debug->breakpoints, chip->pc & addr_mask(machine)) && !debug->resume) {
+			chip->events |= CHIP8_EVENT_BREAKPOINT;
+			return 0.0;
+		}
+		debug->resume = false;
+	}
+	//Load opcode and increment PC to next instruction
+	//since PC points to a single byte of ram, we bitshift to the left by 8 bits and OR it with the next 8 bits to get the full 12bit opcode
+	chip->opcode = mem_read16(chip, machine, chip->pc);
+	chip->pc += 2;
+	//*** Emulate each opcode ***
+	switch (chip->opcode & 0xF000u) {
+		case 0x0000u:
+			switch (chip->opcode) {
+				case 0x00E0u:
+				//clear the display, on XO-CHIP only the selected planes
+					for (unsigned p = 0; p < CHIP8_PLANES; p++) {
+						if (chip->planes & (1u << p))
+							memset(chip->display[p], 0, sizeof(chip->display[p]));
+					}
+					chip->drawn = ~0ull;
+					chip->events |= CHIP8_EVENT_DISPLAY;
+					wait = 0.000109;
+					break;
+				case 0x00EEu:
+				// return from subroutine. Returning with an empty stack faults, see 2nnn
+					{
+						bool underflow = chip->idx_stack == 0;
+						uint16_t ret = chip->stack[(chip->idx_stack - 1u) & (CHIP8_STACK_SIZE - 1u)];
+						chip->fault = underflow ? CHIP8_FAULT_STACK_UNDERFLOW : chip->fault;
+						chip->idx_stack -= !underflow;
+						chip->pc = underflow ? chip->pc - 2u : ret;
+						wait = underflow ? 0.0 : 0.000105;
+					}
+				break;
+				default:
+					if (machine < CHIP8_MACHINE_SCHIP)
+						break;
+					//***SUPER-CHIP display control***
+					if ((chip->opcode & 0xFFF0u) == 0x00C0u || ((chip->opcode & 0xFFF0u) == 0x00D0u && machine == CHIP8_MACHINE_XOCHIP)) {
+						// 00Cn scroll down n pixels, XO-CHIP 00Dn scroll up n pixels
+						int n = (chip->opcode & 0xF0u) == 0xC0u ? (int)(chip->opcode & 0xFu) : -(int)(chip->opcode & 0xFu);
+						for (unsigned p = 0; p < CHIP8_PLANES; p++) {
+							if (chip->planes & (1u << p))
+								scroll_vertical(chip->display[p], chip->hires, n);
+						}
+						chip->drawn = ~0ull;
+						chip->events |= CHIP8_EVENT_DISPLAY;
+						wait = 0.000300;
+					} else if (chip->opcode == 0x00FBu || chip->opcode == 0x00FCu) {
+						// 00FB scroll right 4 pixels, 00FC scroll left 4 pixels
+						for (unsigned p = 0; p < CHIP8_PLANES; p++) {
+							if (chip->planes & (1u << p))
+								scroll_horizontal(chip->display[p], chip->hires, chip->opcode == 0x00FBu ? 4 : -4);
+						}
+						chip->drawn = ~0ull;
+						chip->events |= CHIP8_EVENT_DISPLAY;
+						wait = 0.000300;
+					} else if (chip->opcode == 0x00FDu) {
+						// exit the interpreter
+						chip->fault = CHIP8_FAULT_EXIT;
+						chip->pc -= 2;
+						return 0.0;
+					} else if (chip->opcode == 0x00FEu || chip->opcode == 0x00FFu) {
+						// 00FE lo-res, 00FF hi-res. Switching resolution clears the screen
+						chip->hires = chip->opcode == 0x00FFu;
+						memset(chip->display, 0, sizeof(chip->display));
+						chip->drawn = ~0ull;
+						chip->events |= CHIP8_EVENT_DISPLAY;
+						wait = 0.000109;
+					}
+					break;
+				}
+			break;
+		case 0x1000u: 
+			//this is the JUMP instruction. Jump to the address in the last 3 digits in HEX
+			chip->pc = chip->opcode & 0x0FFFu;
+			wait = 0.000105;
+			break;
+		case 0x2000u:
+			//This is the CALL instruction. Jump to the address indicated and also add a stack frame with a pointer to the previous instruction
+			//A full stack faults instead: the index is masked and the results selected, so the call path has no branch
+			{
+				bool overflow = chip->idx_stack >= CHIP8_STACK_SIZE;
+				uint16_t* slot = &chip->stack[chip->idx_stack & (CHIP8_STACK_SIZE - 1u)];
+				*slot = overflow ? *slot : chip->pc;
+				chip->fault = overflow ? CHIP8_FAULT_STACK_OVERFLOW : chip->fault;
+				chip->idx_stack += !overflow;
+				chip->pc = overflow ? chip->pc - 2u : chip->opcode & 0x0FFFu;
+				wait = overflow ? 0.0 : 0.000105;
+			}
+			break;
+		case 0x3000u:
+			//this is the SE Vx, byte instruction. It skips the next instruction if the value in the register specified by the second 4bits is equal to the value in the last 8 bits
+			if (chip->registers[(chip->opcode & 0x0F00u) >> 8u] == (chip->opcode & 0x00FFu))
+				skip_next(chip, machine);
+			wait = 0.000055;
+			break;
+		case 0x4000u:
+			//this does the opposite of above. It skips if they DO NOT equal
+			if (chip->registers[(chip->opcode & 0x0F00u) >> 8u] != (chip->opcode & 0x00FFu))
+				skip_next(chip, machine);
+			wait = 0.000055;
+			break;
+		case 0x5000u:
+			if ((chip->opcode & 0xFu) >= 2u && machine == CHIP8_MACHINE_XOCHIP) {
+				/* XO-CHIP 5xy2 saves and 5xy3 loads Vx through Vy at I, without changing I.
+				x may be greater than y, then the registers are visited in reverse order. */
+				uint8_t Vx = (chip->opcode & 0x0F00u) >> 8u;
+				uint8_t Vy = (chip->opcode & 0x00F0u) >> 4u;
+				int step = Vx <= Vy ? 1 : -1;
+				unsigned count = (Vx <= Vy ? Vy - Vx : Vx - Vy) + 1;
+				for (unsigned i = 0; i < count; i++) {
+					uint8_t reg = Vx + step * (int)i;
+					if ((chip->opcode & 0xFu) == 2u)
+						mem_write(chip, machine, debug, chip->idx_reg + i, chip->registers[reg]);
+					else if ((chip->opcode & 0xFu) == 3u)
+						chip->registers[reg] = mem_read(chip, machine, chip->idx_reg + i);
+				}
+				if ((chip->opcode & 0xFu) == 3u)
+					traced = count > 1 ? Vx | CHIP8_TRACE_REG_MORE : Vx;
+				wait = 0.000605;
+				break;
+			}
+			//skip if value at register indicated by second 4 bits is equal to value at register indicated by third 4 bits
+			if (chip->registers[(chip->opcode & 0x0F00u) >> 8u] == chip->registers[(chip->opcode & 0x00F0u) >> 4u])
+				skip_next(chip, machine);
+			wait = 0.000073;
+			break;
+		case 0x6000u:
+			//put the value in the last two bytes into the register indicated by the second 4 bits
+			chip->registers[(chip->opcode & 0x0F00u) >> 8u] = (chip->opcode & 0x00FFu);
+			traced = (chip->opcode & 0x0F00u) >> 8u;
+			wait = 0.000027;
+			break;
+		case 0x7000u:
+			//add the value in the last two bytes to the value in the register indicated by the second 4 bits and store the sum in that register
+			chip->registers[(chip->opcode & 0x0F00u) >> 8u] += (chip->opcode & 0x00FFu);
+			traced = (chip->opcode & 0x0F00u) >> 8u;
+			wait = 0.000045;
+			break;
+		case 0x8000u:
+			switch (chip->opcode & 0xFu) {
+				// 8xy0
+				// Set Vx = Vy
+				case 0x0u:
+					chip->registers[(chip->opcode & 0x0F00u) >> 8u] = chip->registers[(chip->opcode & 0x00F0u) >> 4u];
+					traced = (chip->opcode & 0x0F00u) >> 8u;
+					wait = 0.000200;
+					break;
+				// 8xy1
+				// Set Vx = Vx | Vy
+				case 0x1u:
+					chip->registers[(chip->opcode & 0x0F00u) >> 8u] |= chip->registers[(chip->opcode & 0x00F0u) >> 4u];
+					traced = (chip->opcode & 0x0F00u) >> 8u;
+					if (quirks & CHIP8_QUIRK_VF_RESET) {
+						chip->registers[0xF] = 0;
+						traced = traced_with_flag(traced);
+					}
+					wait = 0.000200;
+					break;
+				// 8xy2
+				// Set Vx = Vx & Vy
+				case 0x2u:
+					chip->registers[(chip->opcode & 0x0F00u) >> 8u] &= chip->registers[(chip->opcode & 0x00F0u) >> 4u];
+					traced = (chip->opcode & 0x0F00u) >> 8u;
+					if (quirks & CHIP8_QUIRK_VF_RESET) {
+						chip->registers[0xF] = 0;
+						traced = traced_with_flag(traced);
+					}
+					wait = 0.000200;
+					break;
+				case 0x3u:
+					chip->registers[(chip->opcode & 0x0F00u) >> 8u] ^= chip->registers[(chip->opcode & 0x00F0u) >> 4u];
+					traced = (chip->opcode & 0x0F00u) >> 8u;
+					if (quirks & CHIP8_QUIRK_VF_RESET) {
+						chip->registers[0xF] = 0;
+						traced = traced_with_flag(traced);
+					}
+					wait = 0.000200;
+					break;
+				case 0x4u:
+					/*Set Vx = Vx + Vy, set VF = carry.
+
+The values of Vx and Vy are added together. If the result is greater than 8 bits (i.e., > 255,) VF is set to 1, otherwise 0. Only the lowest 8 bits of the result are kept, and stored in Vx.
+
+This is an ADD with an overflow flag. If the sum is greater than what can fit into a byte (255), register VF will be set to 1 as a flag.*/
+					{
+					uint8_t Vx = (chip->opcode & 0x0F00u) >> 8u;
+					uint8_t Vy = (chip->opcode & 0x00F0u) >> 4u;
+					uint16_t sum = chip->registers[Vx] + chip->registers[Vy];
+					// the flag goes in last, so it wins when Vx is VF
+					chip->registers[Vx] = sum & 0xFFu;
+					chip->registers[0xF] = sum > 255;
+					traced = traced_with_flag(Vx);
+					}
+					wait = 0.000200;
+					break;
+				case 0x5u:
+					/* Set Vx = Vx - Vy, set VF = NOT borrow.
+
+If Vx >= Vy, then VF is set to 1, otherwise 0. Then Vy is subtracted from Vx, and the results stored in Vx. */
+					{
+					uint8_t Vx = (chip->opcode & 0x0F00u) >> 8u;
+					uint8_t Vy = (chip->opcode & 0x00F0u) >> 4u;
+					uint8_t no_borrow = chip->registers[Vx] >= chip->registers[Vy];
+					chip->registers[Vx] -= chip->registers[Vy];
+					chip->registers[0xF] = no_borrow;
+					traced = traced_with_flag(Vx);
+					}
+					wait = 0.000200;
+					break;
+				case 0x6u:
+				/* Set Vx = Vx SHR 1.
+
+If the least-significant bit of Vx is 1, then VF is set to 1, otherwise 0. Then Vx is divided by 2.
+
+A right shift is performed (division by 2), and the least significant bit is saved in Register VF.
+The COSMAC VIP shifts Vy and stores the result in Vx instead. */
+					{
+					uint8_t Vx = (chip->opcode & 0x0F00u) >> 8u;
+					uint8_t Vy = (chip->opcode & 0x00F0u) >> 4u;
+					uint8_t value = chip->registers[(quirks & CHIP8_QUIRK_SHIFT_VX) ? Vx : Vy];
+					chip->registers[Vx] = value >> 1;
+					chip->registers[0xF] = (value & 0x1u);
+					traced = traced_with_flag(Vx);
+					}
+					wait = 0.000200;
+					break;
+				case 0x7u:
+				/* Set Vx = Vy - Vx, set VF = NOT borrow.
+
+If Vy >= Vx, then VF is set to 1, otherwise 0. Then Vx is subtracted from Vy, and the results stored in Vx. */
+					{
+					uint8_t Vx = (chip->opcode & 0x0F00u) >> 8u;
+					uint8_t Vy = (chip->opcode & 0x00F0u) >> 4u;
+					uint8_t no_borrow = chip->registers[Vy] >= chip->registers[Vx];
+					chip->registers[Vx] = chip->registers[Vy] - chip->registers[Vx];
+					chip->registers[0xF] = no_borrow;
+					traced = traced_with_flag(Vx);
+					}
+					wait = 0.000200;
+					break;
+				case 0xE:
+					// Set Vx = Vx SHL 1 (or Vy SHL 1), VF = the bit shifted out
+					{
+					uint8_t Vx = (chip->opcode & 0x0F00u) >> 8u;
+					uint8_t Vy = (chip->opcode & 0x00F0u) >> 4u;
+					uint8_t value = chip->registers[(quirks & CHIP8_QUIRK_SHIFT_VX) ? Vx : Vy];
+					chip->registers[Vx] = value << 1;
+					chip->registers[0xF] = (value & 0x80u) >> 7u;
+					traced = traced_with_flag(Vx);
+					}
+					wait = 0.000200;
+					break;
+			}
+			break;
+
+		case 0x9000u:
+			//skip next instruction if register in second 4 bits does not equal register in third 4 bits
+			if (chip->registers[(chip->opcode & 0x0F00u) >> 8u] != chip->registers[(chip->opcode & 0x00F0U) >> 4u])
+				skip_next(chip, machine);
+			wait = 0.00073;
+			break;
+		case 0xA000u:
+			//set the index register to the value in the last 12bits
+			chip->idx_reg = chip->opcode & 0x0FFFu;
+			wait = 0.000055;
+			break;
+		case 0xB000u:
+			//jump to the address indicated by the last 12 bits + the value in register 0
+			//SUPER-CHIP reads it as Bxnn and adds Vx instead
+			chip->pc = chip->registers[(quirks & CHIP8_QUIRK_JUMP_VX) ? (chip->opcode & 0x0F00u) >> 8u : 0] + (chip->opcode & 0x0FFFu);
+			wait = 0.000105;
+			break;
+		case 0xC000u:
+			//generate a random number in the range of 0-255 and then AND that with the last byte of the opcode, then store that number in the register indicated by the second 4 bits
+			chip->registers[(chip->opcode & 0x0F00u) >> 8u] = (chip8_random(chip) & (chip->opcode & 0x00FFu));
+			traced = (chip->opcode & 0x0F00u) >> 8u;
+			wait = 0.000164;
+			break;
+		case 0xD000u:
+			//Dxyn
+			//Draw sprite with length n-bytes starting at location determined by registers xy
+			//On SUPER-CHIP, Dxy0 draws a 16x16 sprite
+			{
+				uint8_t Vx = (chip->opcode & 0x0F00u) >> 8u;
+				uint8_t Vy = (chip->opcode & 0x00F0u) >> 4u;
+				chip->registers[0xF] = draw_sprite(chip, quirks, machine, chip->idx_reg, chip->registers[Vx], chip->registers[Vy], chip->opcode & 0x000F);
+				traced = 0xF;
+			}
+			chip->events |= CHIP8_EVENT_DISPLAY;
+			wait = 0.001734;
+			break;
+		case 0xE000u:
+			switch (chip->opcode & 0xFF) {
+				case 0x9Eu:
+				// Skip next instruction if key with the value of Vx is pressed.
+					{
+						uint8_t Vx = (chip->opcode & 0x0F00u) >> 8u;
+						uint8_t key = chip->registers[Vx];
+						if (chip->keys & (1u << (key & 0xFu)))
+		  					skip_next(chip, machine);
+						chip->events |= CHIP8_EVENT_KEYPAD_READ;
+					}
+					wait = 0.000073;
+					break;
+				case 0xA1u:
+				// Skip if key is not pressed
+					{
+						uint8_t Vx = (chip->opcode & 0x0F00u) >> 8u;
+						uint8_t key = chip->registers[Vx];
+						if (!(chip->keys & (1u << (key & 0xFu))))
+		  					skip_next(chip, machine);
+						chip->events |= CHIP8_EVENT_KEYPAD_READ;
+					}
+					wait = 0.000073;
+					break;
+			}
+			break;
+		case 0xF000u:
+			switch (chip->opcode & 0xFF) {
+				case 0x00u:
+					// XO-CHIP F000 nnnn: Set I = nnnn, the address is the next 2 bytes
+					if (chip->opcode == 0xF000u && machine == CHIP8_MACHINE_XOCHIP) {
+						chip->idx_reg = mem_read16(chip, machine, chip->pc);
+						chip->pc += 2;
+						wait = 0.000055;
+					}
+					break;
+				case 0x01u:
+					// XO-CHIP Fn01: select the drawing planes, n is a bit mask
+					if (machine == CHIP8_MACHINE_XOCHIP) {
+						chip->planes = ((chip->opcode & 0x0F00u) >> 8u) & ((1u << CHIP8_PLANES) - 1);
+						wait = 0.000027;
+					}
+					break;
+				case 0x02u:
+					// XO-CHIP F002: load the 16 byte audio pattern from I
+					if (chip->opcode == 0xF002u && machine == CHIP8_MACHINE_XOCHIP) {
+						for (unsigned i = 0; i < sizeof(chip->pattern); i++)
+							chip->pattern[i] = mem_read(chip, machine, chip->idx_reg + i);
+						wait = 0.000605;
+					}
+					break;
+				case 0x3Au:
+					// XO-CHIP Fx3A: set the audio pattern playback pitch
+					if (machine == CHIP8_MACHINE_XOCHIP) {
+						chip->pitch = chip->registers[(chip->opcode & 0x0F00u) >> 8u];
+						wait = 0.000045;
+					}
+					break;
+				case 0x07u:
+					//set Vx = delay timer
+					chip->registers[(chip->opcode & 0x0F00u) >> 8u] = chip->timer_delay;
+					traced = (chip->opcode & 0x0F00u) >> 8u;
+					wait = 0.000073;
+					break;
+				case 0x0Au:
+				//Wait for a key press, store the value of the key in Vx.
+					{
+						uint8_t Vx = (chip->opcode & 0x0F00u) >> 8u;
+						bool keyFound = false;
+						chip->events |= CHIP8_EVENT_KEYPAD_READ;
+						for (uint_fast8_t i = 0; i < 16; i++) {
+							if (chip->keys & (1u << i)) {
+								chip->registers[Vx] = i;
+								traced = Vx;
+								keyFound = true;
+								break;
+							}
+						}
+						if (!keyFound)
+							chip->pc -= 2;
+					} wait = 0.000073; break;
+				case 0x15u:
+					// Set delay timer = Vx.
+					{
+						uint8_t Vx = (chip->opcode & 0x0F00u) >> 8u;
+						chip->timer_delay = chip->registers[Vx];
+						wait = 0.000045;
+					} break;
+				case 0x18:
+					chip->timer_sound = chip->registers[(chip->opcode & 0x0F00u) >> 8u];
+					wait = 0.000045;
+					break;
+				case 0x1Eu:
+					// Set I = I + Vx
+					chip->idx_reg += chip->registers[(chip->opcode & 0x0F00u) >> 8u];
+					wait = 0.000086;
+					break;
+				case 0x29u:
+					// Set I = location of sprite for digit Vx
+					{
+					uint8_t Vx = (chip->opcode & 0x0F00u) >> 8u;
+					uint8_t digit = chip->registers[Vx];
+					chip->idx_reg = FONT_START_ADDRESS + (5 * digit);
+					}
+					wait = 0.000096;
+					break;
+				case 0x30u:
+					// SUPER-CHIP: Set I = location of the 8x10 sprite for digit Vx
+					if (machine >= CHIP8_MACHINE_SCHIP) {
+						uint8_t digit = chip->registers[(chip->opcode & 0x0F00u) >> 8u] & 0xFu;
+						chip->idx_reg = BIG_FONT_START_ADDRESS + (10 * digit);
+						wait = 0.000096;
+					}
+					break;
+				case 0x33u:
+					/* Store BCD representation of Vx in memory locations I, I+1, and I+2.
+					The interpreter takes the decimal value of Vx, and places the hundreds digit in memory at location in I, the tens digit at location I+1, and the ones digit at location I+2. */
+					{
+						uint8_t Vx = (chip->opcode & 0x0F00u) >> 8u;
+						uint8_t value = chip->registers[Vx];
+						mem_write(chip, machine, debug, chip->idx_reg,     value / 100);
+						mem_write(chip, machine, debug, chip->idx_reg + 1, (value / 10) % 10);
+						mem_write(chip, machine, debug, chip->idx_reg + 2, value % 10);
+					} wait = 0.000927; break;
+				case 0x55u:
+					// Store registers V0 through Vx in memory starting at location I
+					{
+						uint8_t Vx = (chip->opcode & 0x0F00u) >> 8u;
+						for (uint8_t i = 0; i <= Vx; ++i) {
+							mem_write(chip, machine, debug, chip->idx_reg + i, chip->registers[i]);
+						}
+						if (quirks & CHIP8_QUIRK_MEMORY_INCREMENT)
+							chip->idx_reg += Vx + 1;
+					} wait = 0.000605; break;
+				case 0x65u:
+					// Read registers V0 through Vx from memory starting at location I
+					{
+						uint8_t Vx = (chip->opcode & 0x0F00u) >> 8u;
+						
+						for (uint_fast8_t i =0; i <= Vx; ++i) {
+							chip->registers[i] = mem_read(chip, machine, chip->idx_reg + i);
+						}
+						traced = Vx ? Vx | CHIP8_TRACE_REG_MORE : 0;
+						if (quirks & CHIP8_QUIRK_MEMORY_INCREMENT)
+							chip->idx_reg += Vx + 1;
+					} wait = 0.000605; break;
+				case 0x75u:
+					// SUPER-CHIP: Store V0 through Vx in the user flags
+					if (machine >= CHIP8_MACHINE_SCHIP) {
+						memcpy(chip->rpl, chip->registers, ((chip->opcode & 0x0F00u) >> 8u) + 1);
+						wait = 0.000605;
+					}
+					break;
+				case 0x85u:
+					// SUPER-CHIP: Read V0 through Vx from the user flags
+					if (machine >= CHIP8_MACHINE_SCHIP) {
+						uint8_t Vx = (chip->opcode & 0x0F00u) >> 8u;
+						memcpy(chip->registers, chip->rpl, Vx + 1);
+						traced = Vx ? Vx | CHIP8_TRACE_REG_MORE : 0;
+						wait = 0.000605;
+					}
+					break;
+			}
+	}
+	// a faulting instruction didn't execute
+	if (trace && chip->fault == CHIP8_FAULT_NONE)
+		trace_append(chip, trace, pc, traced);
+	chip->cycles += chip->fault == CHIP8_FAULT_NONE;
+	return wait;
+}
+
+double chip8_step(chip8* chip) {
+	return step_impl(chip, chip->quirks, chip->machine, NULL, NULL);
+}
+
+double chip8_step_debug(chip8* chip, struct chip8_debug* debug) {
+	return step_impl(chip, chip->quirks, chip->machine, debug, debug->trace);
+}
+
+double chip8_step_trace(chip8* chip, struct chip8_trace* trace) {
+	return step_impl(chip, chip->quirks, chip->machine, NULL, trace);
+}
+
+//***one specialized interpreter per machine and quirk set***
+#define CHIP8_FOR_EACH_QUIRK_SET(X, m) \
+	X(m, 00) X(m, 01) X(m, 02) X(m, 03) X(m, 04) X(m, 05) X(m, 06) X(m, 07) \
+	X(m, 08) X(m, 09) X(m, 0A) X(m, 0B) X(m, 0C) X(m, 0D) X(m, 0E) X(m, 0F) \
+	X(m, 10) X(m, 11) X(m, 12) X(m, 13) X(m, 14) X(m, 15) X(m, 16) X(m, 17) \
+	X(m, 18) X(m, 19) X(m, 1A) X(m, 1B) X(m, 1C) X(m, 1D) X(m, 1E) X(m, 1F)
+#define CHIP8_STEP_VARIANT(m, q) \
+	static double step_##m##_##q(chip8* chip) { return step_impl(chip, 0x##q##u, CHIP8_MACHINE_##m, NULL, NULL); }
+#define CHIP8_STEP_ENTRY(m, q) [0x##q] = step_##m##_##q,
+
+CHIP8_FOR_EACH_QUIRK_SET(CHIP8_STEP_VARIANT, CHIP8)
+CHIP8_FOR_EACH_QUIRK_SET(CHIP8_STEP_VARIANT, SCHIP)
+CHIP8_FOR_EACH_QUIRK_SET(CHIP8_STEP_VARIANT, XOCHIP)
+
+static const chip8_step_fn step_variants[][CHIP8_QUIRK_SETS] = {
+	[CHIP8_MACHINE_CHIP8] = { CHIP8_FOR_EACH_QUIRK_SET(CHIP8_STEP_ENTRY, CHIP8) },
+	[CHIP8_MACHINE_SCHIP] = { CHIP8_FOR_EACH_QUIRK_SET(CHIP8_STEP_ENTRY, SCHIP) },
+	[CHIP8_MACHINE_XOCHIP] = { CHIP8_FOR_EACH_QUIRK_SET(CHIP8_STEP_ENTRY, XOCHIP) },
+};
+
+chip8_step_fn chip8_step_for(const chip8* chip) {
+	return step_variants[chip->machine][chip->quirks & (CHIP8_QUIRK_SETS - 1)];
+}
+
+//***disassembler, Cowgod's mnemonics plus the SUPER-CHIP and XO-CHIP extensions***
+unsigned chip8_disassemble(const chip8* chip, uint16_t addr, char* buf, size_t size) {
+	const unsigned mask = chip->ram_size - 1u;
+	uint16_t op = (chip->ram[addr & mask] << 8u) | chip->ram[(addr + 1u) & mask];
+	unsigned x = (op >> 8) & 0xFu, y = (op >> 4) & 0xFu, n = op & 0xFu, kk = op & 0xFFu, nnn = op & 0xFFFu;
+	bool schip = chip->machine >= CHIP8_MACHINE_SCHIP;
+	bool xochip = chip->machine == CHIP8_MACHINE_XOCHIP;
+	static const char* const alu[16] = {
+		"LD", "OR", "AND", "XOR", "ADD", "SUB", "SHR", "SUBN", NULL, NULL, NULL, NULL, NULL, NULL, "SHL", NULL,
+	};
+	// Fx instructions, each from the first machine that has it
+	static const struct {
+		uint8_t kk;
+		chip8_machine machine;
+		const char* format;
+	} fx_ops[] = {
+		{0x01u, CHIP8_MACHINE_XOCHIP, "PLANE %X"},
+		{0x07u, CHIP8_MACHINE_CHIP8, "LD V%X, DT"},
+		{0x0Au, CHIP8_MACHINE_CHIP8, "LD V%X, K"},
+		{0x15u, CHIP8_MACHINE_CHIP8, "LD DT, V%X"},
+		{0x18u, CHIP8_MACHINE_CHIP8, "LD ST, V%X"},
+		{0x1Eu, CHIP8_MACHINE_CHIP8, "ADD I, V%X"},
+		{0x29u, CHIP8_MACHINE_CHIP8, "LD F, V%X"},
+		{0x30u, CHIP8_MACHINE_SCHIP, "LD HF, V%X"},
+		{0x33u, CHIP8_MACHINE_CHIP8, "LD B, V%X"},
+		{0x3Au, CHIP8_MACHINE_XOCHIP, "PITCH V%X"},
+		{0x55u, CHIP8_MACHINE_CHIP8, "LD [I], V%X"},
+		{0x65u, CHIP8_MACHINE_CHIP8, "LD V%X, [I]"},
+		{0x75u, CHIP8_MACHINE_SCHIP, "LD R, V%X"},
+		{0x85u, CHIP8_MACHINE_SCHIP, "LD V%X, R"},
+	};
+
+	switch (op & 0xF000u) {
+		case 0x0000u:
+			if (op == 0x00E0u)
+				snprintf(buf, size, "CLS");
+			else if (op == 0x00EEu)
+				snprintf(buf, size, "RET");
+			else if (schip && (op & 0xFFF0u) == 0x00C0u)
+				snprintf(buf, size, "SCD %u", n);
+			else if (xochip && (op & 0xFFF0u) == 0x00D0u)
+				snprintf(buf, size, "SCU %u", n);
+			else if (schip && op == 0x00FBu)
+				snprintf(buf, size, "SCR");
+			else if (schip && op == 0x00FCu)
+				snprintf(buf, size, "SCL");
+			else if (schip && op == 0x00FDu)
+				snprintf(buf, size, "EXIT");
+			else if (schip && op == 0x00FEu)
+				snprintf(buf, size, "LOW");
+			else if (schip && op == 0x00FFu)
+				snprintf(buf, size, "HIGH");
+			else
+				snprintf(buf, size, "SYS %03X", nnn);
+			return 2;
+		case 0x1000u:
+			snprintf(buf, size, "JP %03X", nnn);
+			return 2;
+		case 0x2000u:
+			snprintf(buf, size, "CALL %03X", nnn);
+			return 2;
+		case 0x3000u:
+			snprintf(buf, size, "SE V%X, %02X", x, kk);
+			return 2;
+		case 0x4000u:
+			snprintf(buf, size, "SNE V%X, %02X", x, kk);
+			return 2;
+		case 0x5000u:
+			if (n == 0)
+				snprintf(buf, size, "SE V%X, V%X", x, y);
+			else if (xochip && n == 2)
+				snprintf(buf, size, "SAVE V%X-V%X", x, y);
+			else if (xochip && n == 3)
+				snprintf(buf, size, "LOAD V%X-V%X", x, y);
+			else
+				break;
+			return 2;
+		case 0x6000u:
+			snprintf(buf, size, "LD V%X, %02X", x, kk);
+			return 2;
+		case 0x7000u:
+			snprintf(buf, size, "ADD V%X, %02X", x, kk);
+			return 2;
+		case 0x8000u:
+			if (!alu[n])
+				break;
+			snprintf(buf, size, "%s V%X, V%X", alu[n], x, y);
+			return 2;
+		case 0x9000u:
+			if (n != 0)
+				break;
+			snprintf(buf, size, "SNE V%X, V%X", x, y);
+			return 2;
+		case 0xA000u:
+			snprintf(buf, size, "LD I, %03X", nnn);
+			return 2;
+		case 0xB000u:
+			if (chip->quirks & CHIP8_QUIRK_JUMP_VX)
+				snprintf(buf, size, "JP V%X, %03X", x, nnn);
+			else
+				snprintf(buf, size, "JP V0, %03X", nnn);
+			return 2;
+		case 0xC000u:
+			snprintf(buf, size, "RND V%X, %02X", x, kk);
+			return 2;
+		case 0xD000u:
+			snprintf(buf, size, "DRW V%X, V%X, %u", x, y, n);
+			return 2;
+		case 0xE000u:
+			if (kk == 0x9Eu)
+				snprintf(buf, size, "SKP V%X", x);
+			else if (kk == 0xA1u)
+				snprintf(buf, size, "SKNP V%X", x);
+			else
+				break;
+			return 2;
+		case 0xF000u:
+			if (xochip && op == 0xF000u) {
+				snprintf(buf, size, "LD I, %04X", (chip->ram[(addr + 2u) & mask] << 8u) | chip->ram[(addr + 3u) & mask]);
+				return 4;
+			}
+			if (xochip && op == 0xF002u) {
+				snprintf(buf, size, "AUDIO");
+				return 2;
+			}
+			for (size_t i = 0; i < sizeof(fx_ops) / sizeof(fx_ops[0]); i++) {
+				if (fx_ops[i].kk == kk && chip->machine >= fx_ops[i].machine) {
+					snprintf(buf, size, fx_ops[i].format, x);
+					return 2;
+				}
+			}
+			break;
+	}
+	snprintf(buf, size, "DW %04X", op);
+	return 2;
+}
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
@@ -0,0 +1,213 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+#ifndef CHIP8_H
+#define CHIP8_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define CHIP8_WIDTH 64
+#define CHIP8_HEIGHT 32
+#define CHIP8_HIRES_WIDTH 128 // SUPER-CHIP
+#define CHIP8_HIRES_HEIGHT 64
+#define FONTSET_SIZE 80
+#define FONT_START_ADDRESS 0x80
+#define BIG_FONTSET_SIZE 160
+#define BIG_FONT_START_ADDRESS (FONT_START_ADDRESS + FONTSET_SIZE)
+#define START_ADDRESS 0x200
+#define CHIP8_RAM_SIZE 0x1000
+#define XOCHIP_RAM_SIZE 0x10000
+#define CHIP8_PLANES 2 // XO-CHIP bit planes, the other machines only use plane 0
+#define CHIP8_STACK_SIZE 16 // a power of two, stack indices wrap around it
+#define CHIP8_DIRTY_BLOCK 64 // bytes of RAM per bit in chip8.dirty, one cache line
+#define CHIP8_HASH_BAND 8 // display rows per hash in chip8.band_hash, so they fill one cache line
+
+// bits in chip8.events, set by chip8_step() and cleared by whoever consumes them
+#define CHIP8_EVENT_KEYPAD_READ 0x1u // Ex9E, ExA1 or Fx0A looked at the keypad
+#define CHIP8_EVENT_DISPLAY 0x2u // 00E0 or Dxyn changed the display
+#define CHIP8_EVENT_BREAKPOINT 0x4u // chip8_step_debug() stopped on a breakpoint, or its caller wants to stop
+#define CHIP8_EVENT_WATCHPOINT 0x8u // chip8_step_debug() wrote to a watched address
+
+typedef enum {
+	CHIP8_MACHINE_CHIP8,
+	CHIP8_MACHINE_SCHIP, // SUPER-CHIP 1.1: 128x64 hi-res mode, scrolling, 16x16 sprites, big font
+	CHIP8_MACHINE_XOCHIP, // XO-CHIP: SUPER-CHIP plus 64 KB of RAM, two bit planes and an audio pattern buffer
+} chip8_machine;
+
+/* Behaviours that differ between CHIP-8 interpreters. Every machine/quirk combination gets its own
+interpreter compiled with the quirks as constants, see chip8_step_for(). */
+#define CHIP8_QUIRK_VF_RESET 0x01u // 8xy1, 8xy2 and 8xy3 reset VF to 0
+#define CHIP8_QUIRK_MEMORY_INCREMENT 0x02u // Fx55 and Fx65 leave I pointing past the last register
+#define CHIP8_QUIRK_SHIFT_VX 0x04u // 8xy6 and 8xyE shift Vx in place instead of shifting Vy into Vx
+#define CHIP8_QUIRK_JUMP_VX 0x08u // Bxnn jumps to xnn + Vx instead of Bnnn jumping to nnn + V0
+#define CHIP8_QUIRK_CLIP 0x10u // sprites are clipped at the screen edges instead of wrapping
+#define CHIP8_QUIRK_SETS 0x20u // number of quirk combinations, one specialized interpreter each
+
+// what each machine does unless told otherwise, chip8 keeps this emulator's historical behaviour
+#define CHIP8_QUIRKS_CHIP8 (CHIP8_QUIRK_SHIFT_VX)
+#define CHIP8_QUIRKS_VIP (CHIP8_QUIRK_VF_RESET | CHIP8_QUIRK_MEMORY_INCREMENT | CHIP8_QUIRK_CLIP)
+#define CHIP8_QUIRKS_SCHIP (CHIP8_QUIRK_SHIFT_VX | CHIP8_QUIRK_JUMP_VX | CHIP8_QUIRK_CLIP)
+#define CHIP8_QUIRKS_XOCHIP (CHIP8_QUIRK_MEMORY_INCREMENT)
+
+typedef enum {
+	CHIP8_FAULT_NONE,
+	CHIP8_FAULT_STACK_UNDERFLOW,
+	CHIP8_FAULT_STACK_OVERFLOW,
+	CHIP8_FAULT_EXIT, // 00FD, not an error
+} chip8_fault;
+
+/* Packed 1 bit per pixel, MSB first. A hi-res row is 128 bits split across two words, left half
+in [0]. Lo-res only ever touches [0] of the first CHIP8_HEIGHT rows, so it keeps 64-bit operations. */
+typedef uint64_t chip8_plane[CHIP8_HIRES_HEIGHT][2];
+
+typedef struct Chip8_t {
+	// what every instruction but a draw touches comes first, in the first two cache lines
+	uint16_t stack[CHIP8_STACK_SIZE];
+	uint8_t registers[16];
+	uint16_t idx_reg;
+	uint16_t pc;
+	uint16_t opcode;
+	uint8_t idx_stack;
+	uint8_t timer_delay;
+	uint8_t timer_sound;
+	uint8_t machine;
+	uint8_t quirks; // CHIP8_QUIRK_* bits
+	bool hires;
+	uint8_t planes; // XO-CHIP planes selected by Fn01, bit n for plane n
+	uint8_t pitch; // XO-CHIP Fx3A
+	uint16_t keys; // bit n is set while hex key n is held, written by the host
+	uint8_t events;
+	uint8_t fault;
+	uint32_t rng;
+	uint64_t cycles;
+	uint32_t ram_size; // a power of two, addresses wrap around it
+	uint8_t rpl[16]; // SUPER-CHIP user flags for Fx75/Fx85
+	uint8_t pattern[16]; // XO-CHIP audio pattern buffer, loaded by F002
+	/* chip8_hash()'s display cache: bit y is set once row y of any plane may have changed since the hash
+	of its band of rows was taken. chip8_init() sets them all, every instruction that draws sets its rows. */
+	uint64_t drawn;
+	uint64_t band_hash[CHIP8_HIRES_HEIGHT / CHIP8_HASH_BAND];
+	chip8_plane display[CHIP8_PLANES];
+	/* Bit n is set once the interpreter wrote to RAM block n, CHIP8_DIRTY_BLOCK bytes at n * CHIP8_DIRTY_BLOCK.
+	chip8_init() clears it and chip8_load() doesn't set it, so everything else still holds what was loaded. */
+	uint64_t dirty[XOCHIP_RAM_SIZE / CHIP8_DIRTY_BLOCK / 64];
+	// last so only XO-CHIP instances pay for 64 KB, see chip8_create()
+	uint8_t ram[];
+} chip8;
+
+// bytes needed for a chip8 of this machine, RAM included
+size_t chip8_size(chip8_machine machine);
+// allocates and initializes a machine, NULL when out of memory. Free it with free()
+chip8* chip8_create(chip8_machine machine, uint32_t seed);
+/* Clears the machine, loads the fonts, selects the machine's default quirks and points PC at START_ADDRESS.
+chip must have room for chip8_size(machine) bytes. */
+void chip8_init(chip8* chip, chip8_machine machine, uint32_t seed);
+unsigned chip8_default_quirks(chip8_machine machine);
+// copies a program to START_ADDRESS, false (and nothing copied) when it does not fit in the machine's RAM
+bool chip8_load(chip8* chip, const uint8_t* program, size_t size);
+
+/* Execute one instruction.
+Returns how long the instruction took on the COSMAC VIP in seconds. On a fault, chip->fault is set,
+PC is left on the faulting instruction and nothing else changes. */
+typedef double (*chip8_step_fn)(chip8* chip);
+/* The interpreter specialized for chip->machine and chip->quirks. Look it up once whenever those
+change and call it for every instruction; it has no runtime quirk checks. */
+chip8_step_fn chip8_step_for(const chip8* chip);
+// generic interpreter checking machine and quirks at runtime, same results as chip8_step_for()
+double chip8_step(chip8* chip);
+/* Dxyn's drawing on its own, for callers keeping the registers elsewhere (batch.c): draws the sprite at
+addr at x, y with height rows and returns what VF becomes. Doesn't touch the registers, PC or events. */
+uint8_t chip8_draw(chip8* chip, uint16_t addr, uint8_t x, uint8_t y, unsigned height);
+
+#define CHIP8_TRACE_REG_NONE 0xFFu
+#define CHIP8_TRACE_REG_MORE 0x80u // set in reg when VF or a range of registers was written as well
+
+struct chip8_trace_record {
+	uint64_t cycle; // chip->cycles before the instruction
+	uint16_t pc;
+	uint16_t opcode;
+	uint16_t i; // I after the instruction
+	uint8_t reg; // register the instruction wrote, CHIP8_TRACE_REG_NONE if none
+	uint8_t value; // its new value
+};
+
+/* Where chip8_step_trace() puts a record of every instruction it executes, at ring[head & mask]. Once
+head reaches limit it calls sync, which hands the records so far on and moves limit; if head is still
+at limit the ring is full and the record is dropped instead. Only chip8_step_trace() and, when trace
+is set, chip8_step_debug() write records, the other interpreters are compiled without them. */
+struct chip8_trace {
+	struct chip8_trace_record* ring;
+	uint64_t mask;
+	uint64_t head;
+	uint64_t limit;
+	uint64_t dropped;
+	void (*sync)(struct chip8_trace* trace);
+};
+// the generic interpreter, recording each instruction in trace
+double chip8_step_trace(chip8* chip, struct chip8_trace* trace);
+
+/* Breakpoints and watchpoints, one bit per address. Only chip8_step_debug() looks at them, the other
+interpreters are compiled without the checks. */
+struct chip8_debug {
+	uint64_t breakpoints[XOCHIP_RAM_SIZE / 64];
+	uint64_t watchpoints[XOCHIP_RAM_SIZE / 64];
+	uint16_t watch_addr; // the watched address written last
+	bool resume; // run the instruction at a breakpoint instead of stopping on it, once
+	struct chip8_trace* trace; // also records the instructions when set
+};
+/* The generic interpreter plus breakpoint and watchpoint checks. A breakpoint at PC raises
+CHIP8_EVENT_BREAKPOINT without executing anything; a write to a watched address completes the
+instruction and raises CHIP8_EVENT_WATCHPOINT. */
+double chip8_step_debug(chip8* chip, struct chip8_debug* debug);
+static inline void chip8_debug_set(uint64_t* bitmap, uint16_t addr, bool set) {
+	if (set)
+		bitmap[addr >> 6] |= 1ull << (addr & 63);
+	else
+		bitmap[addr >> 6] &= ~(1ull << (addr & 63));
+}
+static inline bool chip8_debug_test(const uint64_t* bitmap, uint16_t addr) {
+	return (bitmap[addr >> 6] >> (addr & 63)) & 1u;
+}
+// mnemonic for one instruction, e.g. "DRW V1, V2, 5". Returns how many bytes it takes, 4 for XO-CHIP F000 nnnn
+unsigned chip8_disassemble(const chip8* chip, uint16_t addr, char* buf, size_t size);
+const char* chip8_fault_name(chip8_fault fault);
+// "chip8", "schip" or "xochip", returns false for anything else
+bool chip8_parse_machine(const char* name, chip8_machine* machine);
+const char* chip8_machine_name(chip8_machine machine);
+/* Comma separated profiles (chip8, vip, schip, xochip) and quirk names (vf_reset, memory_increment,
+shift_vx, jump_vx, clip). A profile replaces the quirks so far, a name sets that quirk, and a name with a
+leading '-' clears it, e.g. "vip,-clip". Returns false on an unknown name. */
+bool chip8_parse_quirks(const char* spec, unsigned* quirks);
+// writes spec syntax for quirks into buf
+void chip8_format_quirks(unsigned quirks, char* buf, size_t size);
+
+// pixel at x,y of the current resolution in one plane
+static inline bool chip8_pixel(const chip8_plane plane, unsigned x, unsigned y) {
+	return (plane[y][x >> 6] >> (63 - (x & 63))) & 1u;
+}
+
+#endif
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
@@ -0,0 +1,164 @@
+# Copyright (C) 2025 Eric Hernandez
+# MIT License, see LICENSE
+"""ctypes binding for the vectorized environment in env.h.
+
+Build the library with ./nob env, then:
+
+    env = VecEnv("roms/pong.ch8", 64, rewards=[("v", 14, 1, 1.0)])
+    obs = env.reset()
+    obs, rewards, terminated, truncated = env.step(actions)  # actions: keypad masks, uint16
+
+Observations, rewards and done flags are written by the C side straight into numpy arrays owned by
+the VecEnv, which every call returns again: copy them to keep a result past the next call.
+"""
+
+import ctypes
+import os
+
+import numpy as np
+
+RAM = 0
+REGISTER = 1
+TERMINATED = 0x1
+TRUNCATED = 0x2
+MAX_REWARDS = 4
+MACHINES = {"chip8": 0, "schip": 1, "xochip": 2}
+SOURCES = {"ram": RAM, "v": REGISTER}
+
+
+class _Value(ctypes.Structure):
+    _fields_ = [("source", ctypes.c_uint8), ("width", ctypes.c_uint8), ("addr", ctypes.c_uint16)]
+
+
+class _Reward(ctypes.Structure):
+    _fields_ = [("value", _Value), ("scale", ctypes.c_float)]
+
+
+class _Done(ctypes.Structure):
+    _fields_ = [("value", _Value), ("equals", ctypes.c_uint16)]
+
+
+class _Config(ctypes.Structure):
+    _fields_ = [
+        ("machine", ctypes.c_uint32),
+        ("quirks", ctypes.c_uint32),
+        ("hz", ctypes.c_uint32),
+        ("frame_skip", ctypes.c_uint32),
+        ("frame_stack", ctypes.c_uint32),
+        ("max_pool", ctypes.c_uint32),
+        ("max_frames", ctypes.c_uint32),
+        ("threads", ctypes.c_uint32),
+        ("seed", ctypes.c_uint32),
+        ("reward_count", ctypes.c_uint32),
+        ("rewards", _Reward * MAX_REWARDS),
+        ("done", _Done),
+    ]
+
+
+def _library(path):
+    lib = ctypes.CDLL(path or os.environ.get("CHIP8ENV_LIB") or os.path.join(os.path.dirname(os.path.abspath(__file__)), "libchip8env.so"))
+    p = ctypes.c_void_p
+    lib.chip8_env_config_default.argtypes = [ctypes.POINTER(_Config), ctypes.c_int]
+    lib.chip8_env_config_default.restype = None
+    lib.chip8_parse_quirks.argtypes = [ctypes.c_char_p, ctypes.POINTER(ctypes.c_uint)]
+    lib.chip8_parse_quirks.restype = ctypes.c_bool
+    lib.chip8_env_create.argtypes = [ctypes.POINTER(_Config), ctypes.c_char_p, ctypes.c_size_t, ctypes.c_uint]
+    lib.chip8_env_create.restype = p
+    lib.chip8_env_free.argtypes = [p]
+    lib.chip8_env_free.restype = None
+    lib.chip8_env_observation_size.argtypes = [p]
+    lib.chip8_env_observation_size.restype = ctypes.c_size_t
+    lib.chip8_env_frame_shape.argtypes = [p, ctypes.POINTER(ctypes.c_uint * 3)]
+    lib.chip8_env_frame_shape.restype = None
+    lib.chip8_env_reset.argtypes = [p, p]
+    lib.chip8_env_reset.restype = None
+    lib.chip8_env_step.argtypes = [p, p, p, p, p]
+    lib.chip8_env_step.restype = None
+    return lib
+
+
+def _value(source, addr, width):
+    if source not in SOURCES or width not in (1, 2):
+        raise ValueError(f"bad value: {source!r} {addr} {width}")
+    return _Value(SOURCES[source], width, addr)
+
+
+class VecEnv:
+    """num_envs instances of one ROM.
+
+    rewards: up to 4 (source, addr, width, scale), source "ram" or "v" (a register). The reward is
+    scale times how much the value went up during the step.
+    done: (source, addr, width, equals), the episode ends when the value equals equals.
+    quirks: a spec like the emulator's --quirks, e.g. "vip,-clip"; the machine's defaults otherwise.
+    """
+
+    def __init__(self, rom, num_envs, machine="chip8", quirks=None, hz=0, frame_skip=4, frame_stack=4,
+                 max_pool=False, max_frames=0, threads=0, seed=0, rewards=(), done=None, library=None):
+        self._lib = _library(library)
+        self._env = None
+        config = _Config()
+        self._lib.chip8_env_config_default(ctypes.byref(config), MACHINES[machine])
+        if quirks is not None:
+            bits = ctypes.c_uint(config.quirks)
+            if not self._lib.chip8_parse_quirks(quirks.encode(), ctypes.byref(bits)):
+                raise ValueError(f"bad quirks: {quirks!r}")
+            config.quirks = bits.value
+        config.hz = hz
+        config.frame_skip = frame_skip
+        config.frame_stack = frame_stack
+        config.max_pool = bool(max_pool)
+        config.max_frames = max_frames
+        config.threads = threads
+        config.seed = seed
+        rewards = list(rewards)
+        if len(rewards) > MAX_REWARDS:
+            raise ValueError(f"at most {MAX_REWARDS} rewards")
+        config.reward_count = len(rewards)
+        for i, (source, addr, width, scale) in enumerate(rewards):
+            config.rewards[i] = _Reward(_value(source, addr, width), scale)
+        if done is not None:
+            source, addr, width, equals = done
+            config.done = _Done(_value(source, addr, width), equals)
+
+        with open(rom, "rb") as f:
+            program = f.read()
+        self._env = self._lib.chip8_env_create(ctypes.byref(config), program, len(program), num_envs)
+        if not self._env:
+            raise ValueError("invalid configuration, or the ROM doesn't fit the machine")
+        shape = (ctypes.c_uint * 3)()
+        self._lib.chip8_env_frame_shape(self._env, ctypes.byref(shape))
+        planes, height, width = shape
+        self.num_envs = num_envs
+        # packed bits, np.unpackbits(obs, axis=-1) gives one byte per pixel
+        self.observation_shape = (frame_stack, planes, height, width // 8)
+        self.obs = np.zeros((num_envs,) + self.observation_shape, dtype=np.uint8)
+        assert self.obs[0].nbytes == self._lib.chip8_env_observation_size(self._env)
+        self.rewards = np.zeros(num_envs, dtype=np.float32)
+        self.dones = np.zeros(num_envs, dtype=np.uint8)
+
+    def reset(self):
+        self._lib.chip8_env_reset(self._env, self.obs.ctypes.data)
+        return self.obs
+
+    def step(self, actions):
+        """actions: num_envs keypad masks, bit k holds hex key k. An instance that was done after the
+        previous step starts a new episode instead and ignores its action."""
+        actions = np.ascontiguousarray(actions, dtype=np.uint16)
+        if actions.shape != (self.num_envs,):
+            raise ValueError(f"expected {self.num_envs} actions")
+        self._lib.chip8_env_step(self._env, actions.ctypes.data, self.obs.ctypes.data, self.rewards.ctypes.data, self.dones.ctypes.data)
+        return self.obs, self.rewards, (self.dones & TERMINATED) != 0, (self.dones & TRUNCATED) != 0
+
+    def close(self):
+        if self._env:
+            self._lib.chip8_env_free(self._env)
+            self._env = None
+
+    def __del__(self):
+        self.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
@@ -0,0 +1,507 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+/* Headless conformance suite: runs the test ROMs listed in a manifest (tests/conformance.txt) for a
+fixed number of instructions with scripted keypad input, and compares a hash of the packed framebuffer
+with the golden value recorded in the manifest. Tests run in parallel, one thread per CPU.
+A ROM whose name ends in .hex is a hex listing rather than a binary: pairs of hex digits, with
+whitespace and # comments anywhere. The hand-assembled ROMs in tests/unit/ are kept that way. */
+
+#include <argp.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "chip8.h"
+#include "rom.h"
+#include "romdb.h"
+
+#define CONFORM_MANIFEST "tests/conformance.txt"
+#define CONFORM_FRAME_CYCLES 200 // instructions between timer ticks and keypad script steps
+#define CONFORM_MAX_SETUP 16
+
+typedef enum {
+	RESULT_PASS,
+	RESULT_FAIL,
+	RESULT_NEW, // ran, but there is no golden hash to compare with
+	RESULT_MISSING, // the ROM isn't there
+	RESULT_ERROR,
+} test_result;
+
+struct poke {
+	uint16_t addr;
+	uint8_t value;
+};
+
+struct key_event {
+	uint32_t frame;
+	uint16_t keys;
+};
+
+struct test {
+	char name[64];
+	char rom[256];
+	chip8_machine machine;
+	unsigned quirks;
+	uint64_t cycles;
+	struct poke pokes[CONFORM_MAX_SETUP];
+	int poke_count;
+	struct key_event keys[CONFORM_MAX_SETUP];
+	int key_count;
+	bool has_golden;
+	uint64_t golden;
+	size_t golden_offset, golden_len; // where GOLDEN sits in the manifest text, for --bless
+	// filled in by the run
+	test_result result;
+	uint64_t hash;
+	const char* error;
+};
+
+struct suite {
+	char* text; // the whole manifest
+	size_t text_len;
+	struct test* tests;
+	int count;
+	const char* rom_dir;
+	atomic_int next;
+};
+
+//***manifest***
+// next whitespace separated field of a line, NULL at the end of it
+static const char* next_field(const char** cursor, size_t* len) {
+	const char* p = *cursor;
+	p += strspn(p, " \t");
+	if (*p == '\0' || *p == '\n' || *p == '#')
+		return NULL;
+	*len = strcspn(p, " \t\n");
+	*cursor = p + *len;
+	return p;
+}
+
+static bool parse_setup(struct test* test, char* setup) {
+	if (strcmp(setup, "-") == 0)
+		return true;
+	char* save = NULL;
+	for (char* item = strtok_r(setup, ",", &save); item; item = strtok_r(NULL, ",", &save)) {
+		char* end;
+		if (strncmp(item, "keys@", 5) == 0) {
+			if (test->key_count == CONFORM_MAX_SETUP)
+				return false;
+			struct key_event* event = &test->keys[test->key_count++];
+			event->frame = strtoul(item + 5, &end, 10);
+			if (*end != '=')
+				return false;
+			event->keys = strtoul(end + 1, &end, 16);
+		} else {
+			if (test->poke_count == CONFORM_MAX_SETUP)
+				return false;
+			struct poke* poke = &test->pokes[test->poke_count++];
+			poke->addr = strtoul(item, &end, 16);
+			if (*end != '=')
+				return false;
+			poke->value = strtoul(end + 1, &end, 16);
+		}
+		if (*end)
+			return false;
+	}
+	return true;
+}
+
+static bool parse_test(struct suite* suite, const char* line, struct test* test) {
+	const char* fields[7];
+	size_t lens[7];
+	const char* cursor = line;
+	for (int i = 0; i < 7; i++) {
+		fields[i] = next_field(&cursor, &lens[i]);
+		if (!fields[i])
+			return false;
+	}
+	char buf[7][256];
+	for (int i = 0; i < 7; i++) {
+		if (lens[i] >= sizeof(buf[i]))
+			return false;
+		memcpy(buf[i], fields[i], lens[i]);
+		buf[i][lens[i]] = '\0';
+	}
+
+	*test = (struct test){0};
+	if (lens[0] >= sizeof(test->name))
+		return false;
+	memcpy(test->name, buf[0], lens[0] + 1);
+	memcpy(test->rom, buf[1], lens[1] + 1);
+	if (!chip8_parse_machine(buf[2], &test->machine))
+		return false;
+	test->quirks = chip8_default_quirks(test->machine);
+	if (strcmp(buf[3], "-") != 0 && !chip8_parse_quirks(buf[3], &test->quirks))
+		return false;
+	char* end;
+	test->cycles = strtoull(buf[4], &end, 10);
+	if (*end)
+		return false;
+	if (!parse_setup(test, buf[5]))
+		return false;
+	test->golden_offset = fields[6] - suite->text;
+	test->golden_len = lens[6];
+	if (strcmp(buf[6], "-") != 0) {
+		test->golden = strtoull(buf[6], &end, 16);
+		if (*end || lens[6] != 16)
+			return false;
+		test->has_golden = true;
+	}
+	return true;
+}
+
+static bool load_manifest(struct suite* suite, const char* path) {
+	FILE* file = fopen(path, "rb");
+	if (!file) {
+		fprintf(stderr, "File %s not found\n", path);
+		return false;
+	}
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	suite->text = malloc(size + 1);
+	if (size < 0 || !suite->text || fread(suite->text, 1, size, file) != (size_t)size) {
+		fprintf(stderr, "error reading %s\n", path);
+		fclose(file);
+		return false;
+	}
+	fclose(file);
+	suite->text[size] = '\0';
+	suite->text_len = size;
+
+	int lines = 1;
+	for (long i = 0; i < size; i++)
+		lines += suite->text[i] == '\n';
+	suite->tests = calloc(lines, sizeof(*suite->tests));
+	if (!suite->tests) {
+		fprintf(stderr, "Could not allocate memory\n");
+		return false;
+	}
+	int line_no = 0;
+	const char* next = suite->text;
+	while (next) {
+		const char* line = next;
+		const char* newline = strchr(line, '\n');
+		next = newline ? newline + 1 : NULL;
+		line_no++;
+		const char* cursor = line;
+		size_t len;
+		if (!next_field(&cursor, &len))
+			continue; // blank or comment
+		if (!parse_test(suite, line, &suite->tests[suite->count])) {
+			fprintf(stderr, "%s:%d: malformed test\n", path, line_no);
+			return false;
+		}
+		suite->count++;
+	}
+	return true;
+}
+
+//***running***
+static int hex_digit(uint8_t c) {
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
+// decodes a hex listing in place, false on anything but digit pairs, whitespace and comments
+static bool decode_hex(uint8_t* text, size_t size, size_t* length) {
+	size_t out = 0;
+	int high = -1;
+	for (size_t i = 0; i < size; i++) {
+		if (text[i] == '#') {
+			while (i < size && text[i] != '\n')
+				i++;
+			continue;
+		}
+		if (text[i] == ' ' || text[i] == '\t' || text[i] == '\n' || text[i] == '\r') {
+			if (high >= 0)
+				return false;
+			continue;
+		}
+		int digit = hex_digit(text[i]);
+		if (digit < 0)
+			return false;
+		if (high < 0) {
+			high = digit;
+		} else {
+			text[out++] = high << 4 | digit;
+			high = -1;
+		}
+	}
+	*length = out;
+	return high < 0;
+}
+
+static bool is_hex_listing(const char* name) {
+	size_t len = strlen(name);
+	return len > 4 && strcmp(name + len - 4, ".hex") == 0;
+}
+
+static void run_test(const struct suite* suite, struct test* test) {
+	char path[512];
+	snprintf(path, sizeof(path), "%s/%s", suite->rom_dir, test->rom);
+	struct rom rom;
+	rom_status status = rom_open(&rom, path, XOCHIP_RAM_SIZE - START_ADDRESS);
+	if (status != ROM_OK) {
+		test->result = status == ROM_NOT_FOUND ? RESULT_MISSING : RESULT_ERROR;
+		test->error = rom_status_name(status);
+		return;
+	}
+	const uint8_t* program = rom.data;
+	size_t program_size = rom.size;
+	uint8_t* listing = NULL;
+	if (is_hex_listing(test->rom)) {
+		listing = malloc(rom.size ? rom.size : 1);
+		if (listing)
+			memcpy(listing, rom.data, rom.size);
+		if (!listing || !decode_hex(listing, rom.size, &program_size)) {
+			test->result = RESULT_ERROR;
+			test->error = listing ? "is not a valid hex listing" : "could not allocate memory";
+			free(listing);
+			rom_close(&rom);
+			return;
+		}
+		program = listing;
+	}
+	chip8* chip = chip8_create(test->machine, 1);
+	if (!chip || !chip8_load(chip, program, program_size)) {
+		test->result = RESULT_ERROR;
+		test->error = chip ? "is too big for the machine" : "could not allocate memory";
+		free(chip);
+		free(listing);
+		rom_close(&rom);
+		return;
+	}
+	free(listing);
+	rom_close(&rom);
+	chip->quirks = test->quirks;
+	for (int i = 0; i < test->poke_count; i++)
+		chip->ram[test->pokes[i].addr & (chip->ram_size - 1)] = test->pokes[i].value;
+
+	chip8_step_fn step = chip8_step_for(chip);
+	for (uint64_t n = 0; n < test->cycles && !chip->fault; n++) {
+		if (n % CONFORM_FRAME_CYCLES == 0) {
+			uint64_t frame = n / CONFORM_FRAME_CYCLES;
+			if (frame > 0) {
+				if (chip->timer_delay > 0)
+					chip->timer_delay--;
+				if (chip->timer_sound > 0)
+					chip->timer_sound--;
+			}
+			for (int i = 0; i < test->key_count; i++) {
+				if (test->keys[i].frame == frame)
+					chip->keys = test->keys[i].keys;
+			}
+		}
+		step(chip);
+	}
+	if (chip->fault && chip->fault != CHIP8_FAULT_EXIT) {
+		test->result = RESULT_ERROR;
+		test->error = chip8_fault_name(chip->fault);
+	} else {
+		test->hash = romdb_hash(chip->display, sizeof(chip->display));
+		if (!test->has_golden)
+			test->result = RESULT_NEW;
+		else
+			test->result = test->hash == test->golden ? RESULT_PASS : RESULT_FAIL;
+	}
+	free(chip);
+}
+
+static void* worker(void* data) {
+	struct suite* suite = data;
+	int i;
+	while ((i = atomic_fetch_add(&suite->next, 1)) < suite->count)
+		run_test(suite, &suite->tests[i]);
+	return NULL;
+}
+
+// rewrites the manifest with the hashes of this run as the goldens
+static bool bless(const struct suite* suite, const char* path) {
+	char tmp[4096];
+	snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+	FILE* out = fopen(tmp, "wb");
+	if (!out)
+		return false;
+	size_t pos = 0;
+	for (int i = 0; i < suite->count; i++) {
+		const struct test* test = &suite->tests[i];
+		if (test->result != RESULT_PASS && test->result != RESULT_FAIL && test->result != RESULT_NEW)
+			continue;
+		fwrite(suite->text + pos, 1, test->golden_offset - pos, out);
+		fprintf(out, "%016" PRIx64, test->hash);
+		pos = test->golden_offset + test->golden_len;
+	}
+	fwrite(suite->text + pos, 1, suite->text_len - pos, out);
+	if (fclose(out) != 0)
+		return false;
+	return rename(tmp, path) == 0;
+}
+
+//***arguments***
+struct arguments {
+	const char* manifest;
+	const char* rom_dir;
+	long jobs;
+	bool bless;
+	bool allow_missing;
+};
+
+enum {
+	OPT_ROMS = 256,
+	OPT_BLESS,
+	OPT_ALLOW_MISSING,
+};
+
+static struct argp_option options[] = {
+	{"roms", OPT_ROMS, "DIR", 0, "Directory with the test ROMs. Defaults to roms/ next to the manifest", 0},
+	{"jobs", 'j', "COUNT", 0, "Tests run in parallel. Defaults to the number of CPUs", 0},
+	{"bless", OPT_BLESS, 0, 0, "Record this run's hashes as the goldens in the manifest", 0},
+	{"allow-missing", OPT_ALLOW_MISSING, 0, 0, "Don't fail on tests whose ROM is missing or that have no golden yet", 0},
+	{0}
+};
+
+static error_t parse_opt(int key, char* arg, struct argp_state* state) {
+	struct arguments* arguments = state->input;
+	switch (key) {
+		case OPT_ROMS:
+			arguments->rom_dir = arg;
+			break;
+		case 'j':
+			arguments->jobs = atol(arg);
+			if (arguments->jobs < 1)
+				argp_error(state, "jobs must be at least 1");
+			break;
+		case OPT_BLESS:
+			arguments->bless = true;
+			break;
+		case OPT_ALLOW_MISSING:
+			arguments->allow_missing = true;
+			break;
+		case ARGP_KEY_ARG:
+			if (state->arg_num >= 1)
+				argp_usage(state);
+			arguments->manifest = arg;
+			break;
+		default:
+			return ARGP_ERR_UNKNOWN;
+	}
+	return 0;
+}
+
+static struct argp argp = {
+	.options = options,
+	.parser = parse_opt,
+	.args_doc = "[MANIFEST]",
+	.doc = "Runs the CHIP-8 conformance test ROMs and checks their framebuffers against golden hashes",
+};
+
+int main(int argc, char* argv[]) {
+	struct arguments arguments = {
+		.manifest = CONFORM_MANIFEST,
+		.jobs = sysconf(_SC_NPROCESSORS_ONLN),
+	};
+	argp_parse(&argp, argc, argv, 0, 0, &arguments);
+
+	struct suite suite = {0};
+	if (!load_manifest(&suite, arguments.manifest))
+		return 1;
+	char rom_dir[4096];
+	if (!arguments.rom_dir) {
+		const char* slash = strrchr(arguments.manifest, '/');
+		int dir_len = slash ? (int)(slash - arguments.manifest) : 1;
+		snprintf(rom_dir, sizeof(rom_dir), "%.*s/roms", dir_len, slash ? arguments.manifest : ".");
+		arguments.rom_dir = rom_dir;
+	}
+	suite.rom_dir = arguments.rom_dir;
+	atomic_init(&suite.next, 0);
+
+	if (arguments.jobs > suite.count)
+		arguments.jobs = suite.count;
+	pthread_t* threads = calloc(arguments.jobs > 0 ? arguments.jobs : 1, sizeof(*threads));
+	if (!threads) {
+		fprintf(stderr, "Could not allocate memory\n");
+		return 1;
+	}
+	long started = 0;
+	for (; started < arguments.jobs; started++) {
+		if (pthread_create(&threads[started], NULL, worker, &suite) != 0)
+			break;
+	}
+	if (started == 0)
+		worker(&suite);
+	for (long i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+	free(threads);
+
+	//***report in manifest order***
+	int counts[RESULT_ERROR + 1] = {0};
+	for (int i = 0; i < suite.count; i++) {
+		const struct test* test = &suite.tests[i];
+		counts[test->result]++;
+		switch (test->result) {
+			case RESULT_PASS:
+				printf("PASS    %s\n", test->name);
+				break;
+			case RESULT_FAIL:
+				printf("FAIL    %s: framebuffer %016" PRIx64 ", expected %016" PRIx64 "\n", test->name, test->hash, test->golden);
+				break;
+			case RESULT_NEW:
+				printf("NEW     %s: framebuffer %016" PRIx64 ", no golden recorded\n", test->name, test->hash);
+				break;
+			case RESULT_MISSING:
+				printf("MISSING %s: %s/%s %s\n", test->name, suite.rom_dir, test->rom, test->error);
+				break;
+			case RESULT_ERROR:
+				printf("ERROR   %s: %s\n", test->name, test->error);
+				break;
+		}
+	}
+	printf("%d tests: %d passed, %d failed, %d without golden, %d missing, %d errors\n", suite.count,
+		counts[RESULT_PASS], counts[RESULT_FAIL], counts[RESULT_NEW], counts[RESULT_MISSING], counts[RESULT_ERROR]);
+
+	if (arguments.bless) {
+		if (!bless(&suite, arguments.manifest)) {
+			fprintf(stderr, "Could not write %s\n", arguments.manifest);
+			return 1;
+		}
+		printf("goldens recorded in %s\n", arguments.manifest);
+		return counts[RESULT_ERROR] != 0;
+	}
+	// a test that didn't get to compare a screen proves nothing, so it fails unless asked not to
+	bool unchecked = counts[RESULT_NEW] != 0 || counts[RESULT_MISSING] != 0;
+	return counts[RESULT_FAIL] != 0 || counts[RESULT_ERROR] != 0 || (unchecked && !arguments.allow_missing);
+}
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
@@ -0,0 +1,309 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "debugger.h"
+
+struct debugger {
+	chip8* chip;
+	struct chip8_debug debug;
+	pthread_mutex_t lock;
+	pthread_cond_t changed;
+	bool stopped; // the emulation thread is waiting in debugger_stop()
+	bool quit;
+	atomic_bool pause; // stop before the next instruction
+	// set by the console while stopped, read by the emulation thread once it runs again
+	uint64_t steps; // instructions left to single step
+	bool stepping_over;
+	uint16_t over_pc;
+	uint8_t over_depth;
+	const char* reason;
+};
+
+// there is one machine and one terminal
+static struct debugger debugger = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.changed = PTHREAD_COND_INITIALIZER,
+};
+
+double debugger_step(chip8* chip) {
+	struct debugger* d = &debugger;
+	if (atomic_load_explicit(&d->pause, memory_order_relaxed)) {
+		d->reason = "paused";
+		chip->events |= CHIP8_EVENT_BREAKPOINT;
+		return 0.0;
+	}
+	double wait = chip8_step_debug(chip, &d->debug);
+	if (chip->events & CHIP8_EVENT_BREAKPOINT) {
+		d->reason = "breakpoint";
+	} else if (chip->events & CHIP8_EVENT_WATCHPOINT) {
+		d->reason = "watchpoint";
+	} else if ((d->steps && --d->steps == 0)
+		|| (d->stepping_over && chip->pc == d->over_pc && chip->idx_stack == d->over_depth)) {
+		d->reason = "step";
+		chip->events |= CHIP8_EVENT_BREAKPOINT;
+	}
+	return wait;
+}
+
+//***views***
+static void print_location(const chip8* chip, uint16_t addr, bool mark) {
+	char text[32];
+	unsigned len = chip8_disassemble(chip, addr, text, sizeof(text));
+	const unsigned mask = chip->ram_size - 1u;
+	fprintf(stdout, "%c%c %04X  ", mark && addr == chip->pc ? '>' : ' ',
+		chip8_debug_test(debugger.debug.breakpoints, addr) ? '*' : ' ', addr);
+	for (unsigned i = 0; i < 4; i++) {
+		if (i < len)
+			fprintf(stdout, "%02X", chip->ram[(addr + i) & mask]);
+		else
+			fprintf(stdout, "  ");
+	}
+	fprintf(stdout, "  %s\n", text);
+}
+
+static void print_registers(const chip8* chip) {
+	for (int i = 0; i < 16; i++)
+		fprintf(stdout, "V%X %02X%s", i, chip->registers[i], i % 8 == 7 ? "\n" : "  ");
+	fprintf(stdout, "PC %04X  I %04X  SP %u  DT %02X  ST %02X  keys %04X  cycles %" PRIu64 "\n",
+		chip->pc, chip->idx_reg, chip->idx_stack, chip->timer_delay, chip->timer_sound, chip->keys, chip->cycles);
+}
+
+static void print_stack(const chip8* chip) {
+	if (chip->idx_stack == 0)
+		fprintf(stdout, "stack is empty\n");
+	for (int i = chip->idx_stack - 1; i >= 0; i--)
+		fprintf(stdout, "#%-2d %04X\n", chip->idx_stack - 1 - i, chip->stack[i & (CHIP8_STACK_SIZE - 1)]);
+}
+
+static void print_memory(const chip8* chip, uint16_t addr, unsigned len) {
+	const unsigned mask = chip->ram_size - 1u;
+	for (unsigned row = 0; row < len; row += 16) {
+		fprintf(stdout, "%04X ", (addr + row) & mask);
+		for (unsigned i = row; i < row + 16 && i < len; i++)
+			fprintf(stdout, " %02X", chip->ram[(addr + i) & mask]);
+		fprintf(stdout, "\n");
+	}
+}
+
+static void print_bitmap(const uint64_t* bitmap, uint32_t size, const char* what) {
+	bool any = false;
+	for (uint32_t addr = 0; addr < size; addr++) {
+		if (chip8_debug_test(bitmap, addr)) {
+			fprintf(stdout, "%s%04X", any ? " " : "", addr);
+			any = true;
+		}
+	}
+	fprintf(stdout, any ? "\n" : "no %s\n", what);
+}
+
+static const char help[] =
+	"c                 continue\n"
+	"s [N]             step N instructions (1)\n"
+	"n                 step over a CALL\n"
+	"b [ADDR]          set a breakpoint, or list them\n"
+	"d ADDR            delete a breakpoint\n"
+	"w [ADDR [LEN]]    watch writes to LEN bytes (1), or list the watched addresses\n"
+	"u ADDR [LEN]      stop watching\n"
+	"r                 registers\n"
+	"k                 call stack\n"
+	"m [ADDR [LEN]]    memory (I, 64 bytes)\n"
+	"l [ADDR [COUNT]]  disassembly (PC, 10 instructions)\n"
+	"q                 quit\n"
+	"an empty line repeats the last command, addresses are hex\n";
+
+// runs one console command on the stopped machine, true when it lets the machine run again
+static bool command(struct debugger* d, char* line) {
+	chip8* chip = d->chip;
+	const unsigned mask = chip->ram_size - 1u;
+	char* save = NULL;
+	char* cmd = strtok_r(line, " \t\n", &save);
+	char* arg1 = strtok_r(NULL, " \t\n", &save);
+	char* arg2 = strtok_r(NULL, " \t\n", &save);
+	if (!cmd)
+		return false;
+
+	switch (cmd[0]) {
+		case 'c':
+			return true;
+		case 's':
+			d->steps = arg1 ? strtoull(arg1, NULL, 10) : 1;
+			if (d->steps == 0)
+				d->steps = 1;
+			return true;
+		case 'n':
+			if ((((chip->ram[chip->pc & mask] << 8) | chip->ram[(chip->pc + 1) & mask]) & 0xF000u) == 0x2000u) {
+				d->stepping_over = true;
+				d->over_pc = (chip->pc + 2) & mask;
+				d->over_depth = chip->idx_stack;
+			} else {
+				d->steps = 1;
+			}
+			return true;
+		case 'b':
+			if (arg1)
+				chip8_debug_set(d->debug.breakpoints, strtoul(arg1, NULL, 16) & mask, true);
+			else
+				print_bitmap(d->debug.breakpoints, chip->ram_size, "breakpoints");
+			break;
+		case 'd':
+			if (arg1)
+				chip8_debug_set(d->debug.breakpoints, strtoul(arg1, NULL, 16) & mask, false);
+			break;
+		case 'w':
+		case 'u':
+			if (!arg1) {
+				print_bitmap(d->debug.watchpoints, chip->ram_size, "watchpoints");
+				break;
+			}
+			{
+				unsigned addr = strtoul(arg1, NULL, 16);
+				unsigned len = arg2 ? strtoul(arg2, NULL, 0) : 1;
+				for (unsigned i = 0; i < len && i <= mask; i++)
+					chip8_debug_set(d->debug.watchpoints, (addr + i) & mask, cmd[0] == 'w');
+			}
+			break;
+		case 'r':
+			print_registers(chip);
+			break;
+		case 'k':
+			print_stack(chip);
+			break;
+		case 'm':
+			print_memory(chip, arg1 ? strtoul(arg1, NULL, 16) & mask : chip->idx_reg,
+				arg2 ? strtoul(arg2, NULL, 0) : 64);
+			break;
+		case 'l':
+			{
+				uint16_t addr = arg1 ? strtoul(arg1, NULL, 16) & mask : chip->pc;
+				unsigned count = arg2 ? strtoul(arg2, NULL, 0) : 10;
+				char text[32];
+				for (unsigned i = 0; i < count; i++) {
+					print_location(chip, addr, true);
+					addr = (addr + chip8_disassemble(chip, addr, text, sizeof(text))) & mask;
+				}
+			}
+			break;
+		case 'q':
+			d->quit = true;
+			return true;
+		default:
+			fputs(help, stdout);
+			break;
+	}
+	return false;
+}
+
+static void* console(void* arg) {
+	struct debugger* d = arg;
+	char line[256], last[256] = "";
+	while (fgets(line, sizeof(line), stdin)) {
+		if (line[strspn(line, " \t\n")] == '\0')
+			memcpy(line, last, sizeof(line));
+		else
+			memcpy(last, line, sizeof(last));
+
+		pthread_mutex_lock(&d->lock);
+		// commands only ever see a stopped machine
+		if (!d->stopped && !d->quit) {
+			atomic_store_explicit(&d->pause, true, memory_order_relaxed);
+			while (!d->stopped && !d->quit)
+				pthread_cond_wait(&d->changed, &d->lock);
+		}
+		if (d->quit) {
+			pthread_mutex_unlock(&d->lock);
+			break;
+		}
+		if (command(d, line)) {
+			d->stopped = false;
+			pthread_cond_broadcast(&d->changed);
+		} else {
+			fprintf(stdout, "(chip8) ");
+			fflush(stdout);
+		}
+		bool quit = d->quit;
+		pthread_mutex_unlock(&d->lock);
+		if (quit)
+			break;
+	}
+	// the terminal went away, let the machine run on
+	pthread_mutex_lock(&d->lock);
+	d->stopped = false;
+	pthread_cond_broadcast(&d->changed);
+	pthread_mutex_unlock(&d->lock);
+	return NULL;
+}
+
+bool debugger_init(chip8* chip, struct chip8_trace* trace) {
+	debugger.chip = chip;
+	debugger.debug.trace = trace;
+	atomic_store(&debugger.pause, true);
+	pthread_t thread;
+	if (pthread_create(&thread, NULL, console, &debugger) != 0)
+		return false;
+	// it may be blocked reading the terminal at exit
+	pthread_detach(thread);
+	return true;
+}
+
+bool debugger_stop(chip8* chip) {
+	struct debugger* d = &debugger;
+	pthread_mutex_lock(&d->lock);
+	atomic_store_explicit(&d->pause, false, memory_order_relaxed);
+	d->steps = 0;
+	d->stepping_over = false;
+	if (!d->quit) {
+		if (chip->events & CHIP8_EVENT_WATCHPOINT)
+			fprintf(stdout, "\n%s on %04X\n", d->reason, d->debug.watch_addr);
+		else
+			fprintf(stdout, "\n%s\n", d->reason);
+		print_location(chip, chip->pc, true);
+		fprintf(stdout, "(chip8) ");
+		fflush(stdout);
+	}
+	chip->events &= ~(CHIP8_EVENT_BREAKPOINT | CHIP8_EVENT_WATCHPOINT);
+	d->stopped = true;
+	pthread_cond_broadcast(&d->changed);
+	while (d->stopped && !d->quit)
+		pthread_cond_wait(&d->changed, &d->lock);
+	d->stopped = false;
+	// carry on past a breakpoint at PC
+	d->debug.resume = true;
+	bool keep_running = !d->quit;
+	pthread_mutex_unlock(&d->lock);
+	return keep_running;
+}
+
+void debugger_release(void) {
+	pthread_mutex_lock(&debugger.lock);
+	debugger.quit = true;
+	pthread_cond_broadcast(&debugger.changed);
+	pthread_mutex_unlock(&debugger.lock);
+}
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
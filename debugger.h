@@ -0,0 +1,46 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+#ifndef DEBUGGER_H
+#define DEBUGGER_H
+
+#include <stdbool.h>
+#include "chip8.h"
+
+/* Interactive debugger on the terminal, for --debug.
+The emulation thread runs debugger_step() instead of the specialized interpreter. Whenever an
+instruction raises CHIP8_EVENT_BREAKPOINT or CHIP8_EVENT_WATCHPOINT it calls debugger_stop(), which
+blocks while the console thread inspects the machine and takes commands. Type "help" for the list. */
+
+// starts the console, the machine stops before its first instruction. trace, if not NULL, records what runs
+bool debugger_init(chip8* chip, struct chip8_trace* trace);
+// a chip8_step_fn for the emulation thread
+double debugger_step(chip8* chip);
+// waits for the console to continue, false when it asked to quit
+bool debugger_stop(chip8* chip);
+// lets a stopped emulation thread return, for shutting down
+void debugger_release(void);
+
+#endif
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
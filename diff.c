@@ -0,0 +1,470 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+/* Lockstep differential runner: runs every ROM of a corpus on two interpreters with the same keypad
+script and compares the whole machine every --interval instructions. On a divergence it bisects back
+from the last matching checkpoint to the first instruction whose result differs and dumps both states.
+ROMs are spread over --jobs threads. */
+
+#include <argp.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "batch.h"
+#include "chip8.h"
+#include "rom.h"
+#include "romdb.h"
+
+#define DIFF_INSTRUCTIONS 1000000
+#define DIFF_INTERVAL 1000
+#define DIFF_FRAME_CYCLES 100 // instructions between timer ticks and keypad changes
+
+//***engines***
+struct engine {
+	const char* name;
+	chip8_step_fn (*select)(const chip8* chip); // NULL for the batch core
+};
+
+static chip8_step_fn select_specialized(const chip8* chip) {
+	return chip8_step_for(chip);
+}
+
+static chip8_step_fn select_generic(const chip8* chip) {
+	(void)chip;
+	return chip8_step;
+}
+
+/* batch runs the ROM as one block of chip8_batch lanes and compares lane 0. The other lanes get keypad
+scripts of their own and their own random numbers, so the block splits over PCs the way rollouts do. */
+static const struct engine engines[] = {
+	{"specialized", select_specialized},
+	{"generic", select_generic},
+	{"batch", NULL},
+};
+
+static const struct engine* find_engine(const char* name) {
+	for (size_t i = 0; i < sizeof(engines) / sizeof(engines[0]); i++) {
+		if (strcmp(engines[i].name, name) == 0)
+			return &engines[i];
+	}
+	return NULL;
+}
+
+//***arguments***
+struct arguments {
+	char** roms;
+	int rom_count;
+	chip8_machine machine;
+	const char* quirks;
+	uint64_t instructions;
+	uint64_t interval;
+	long jobs;
+	uint32_t seed;
+	const struct engine* a;
+	const struct engine* b;
+};
+
+enum {
+	OPT_ENGINE_A = 256,
+	OPT_ENGINE_B,
+};
+
+static struct argp_option options[] = {
+	{"machine", 'm', "NAME", 0, "Machine to run the ROMs on: chip8, schip or xochip. Defaults to chip8", 0},
+	{"quirks", 'q', "LIST", 0, "Quirks, same syntax as the emulator's --quirks. Defaults to the machine's profile", 0},
+	{"instructions", 'n', "COUNT", 0, "Instructions to run each ROM for. Defaults to 1000000", 0},
+	{"interval", 'i', "COUNT", 0, "Instructions between state comparisons. Defaults to 1000", 0},
+	{"jobs", 'j', "COUNT", 0, "ROMs run in parallel. Defaults to the number of CPUs", 0},
+	{"seed", 's', "NUMBER", 0, "Seed for the keypad script and Cxkk. Defaults to 1", 0},
+	{"engine-a", OPT_ENGINE_A, "NAME", 0, "First interpreter: specialized, generic or batch. Defaults to specialized", 0},
+	{"engine-b", OPT_ENGINE_B, "NAME", 0, "Second interpreter. Defaults to generic", 0},
+	{0}
+};
+
+static error_t parse_opt(int key, char* arg, struct argp_state* state) {
+	struct arguments* arguments = state->input;
+	switch (key) {
+		case 'm':
+			if (!chip8_parse_machine(arg, &arguments->machine))
+				argp_error(state, "unknown machine '%s'", arg);
+			break;
+		case 'q':
+			arguments->quirks = arg;
+			break;
+		case 'n':
+			arguments->instructions = strtoull(arg, NULL, 10);
+			break;
+		case 'i':
+			arguments->interval = strtoull(arg, NULL, 10);
+			if (arguments->interval == 0)
+				argp_error(state, "interval must be at least 1");
+			break;
+		case 'j':
+			arguments->jobs = atol(arg);
+			if (arguments->jobs < 1)
+				argp_error(state, "jobs must be at least 1");
+			break;
+		case 's':
+			arguments->seed = strtoul(arg, NULL, 0);
+			break;
+		case OPT_ENGINE_A:
+		case OPT_ENGINE_B:
+			{
+				const struct engine* engine = find_engine(arg);
+				if (!engine)
+					argp_error(state, "unknown engine '%s'", arg);
+				if (key == OPT_ENGINE_A)
+					arguments->a = engine;
+				else
+					arguments->b = engine;
+			}
+			break;
+		case ARGP_KEY_ARGS:
+			arguments->roms = state->argv + state->next;
+			arguments->rom_count = state->argc - state->next;
+			break;
+		case ARGP_KEY_NO_ARGS:
+			argp_usage(state);
+			break;
+		default:
+			return ARGP_ERR_UNKNOWN;
+	}
+	return 0;
+}
+
+static struct argp argp = {
+	.options = options,
+	.parser = parse_opt,
+	.args_doc = "ROM...",
+	.doc = "Runs ROMs on two CHIP-8 interpreters in lockstep and reports where they disagree",
+};
+
+//***lockstep***
+struct side {
+	chip8* chip;
+	chip8* snapshot; // state at the last checkpoint where both sides matched
+	chip8_step_fn step;
+	const char* name;
+	// the batch engine, chip is a copy of lane 0 after every advance
+	chip8_batch* batch;
+	uint8_t* lanes; // every lane at the last checkpoint, chip8_size() apart
+};
+
+static inline uint32_t mix32(uint32_t x) {
+	x ^= x >> 16;
+	x *= 0x7FEB352Du;
+	x ^= x >> 15;
+	x *= 0x846CA68Bu;
+	x ^= x >> 16;
+	return x;
+}
+
+// hold one key or none, changing every 8 frames
+static uint16_t script_keys(uint64_t frame, uint32_t seed) {
+	uint32_t h = mix32(seed ^ (uint32_t)(frame >> 3));
+	return (h & 0x10u) ? 1u << (h & 0xFu) : 0;
+}
+
+/* The input is a function of the instruction count alone, so both sides, and every replay while
+bisecting, see the same keypad and timers at the same instruction. */
+static void feed(chip8* chip, uint64_t n, uint32_t seed) {
+	if (n % DIFF_FRAME_CYCLES)
+		return;
+	uint64_t frame = n / DIFF_FRAME_CYCLES;
+	if (frame > 0) {
+		if (chip->timer_delay > 0)
+			chip->timer_delay--;
+		if (chip->timer_sound > 0)
+			chip->timer_sound--;
+	}
+	chip->keys = script_keys(frame, seed);
+}
+
+// the same input for every lane, lane n following the script of seed + n, in runs up to the next frame
+static void advance_batch(struct side* side, uint64_t n, uint64_t count, uint32_t seed) {
+	chip8_batch* batch = side->batch;
+	for (uint64_t i = 0; i < count && !batch->fault[0];) {
+		uint64_t at = n + i;
+		if (at % DIFF_FRAME_CYCLES == 0) {
+			uint64_t frame = at / DIFF_FRAME_CYCLES;
+			if (frame > 0)
+				chip8_batch_tick(batch);
+			for (unsigned l = 0; l < batch->count; l++)
+				batch->keys[l] = script_keys(frame, seed + l);
+		}
+		uint64_t run = DIFF_FRAME_CYCLES - at % DIFF_FRAME_CYCLES;
+		if (run > count - i)
+			run = count - i;
+		chip8_batch_run(batch, run);
+		i += run;
+	}
+	chip8_batch_get(batch, 0, side->chip);
+}
+
+// runs count instructions starting at instruction n, fewer if the machine faults
+static void advance(struct side* side, uint64_t n, uint64_t count, uint32_t seed) {
+	if (side->batch) {
+		advance_batch(side, n, count, seed);
+		return;
+	}
+	chip8* chip = side->chip;
+	for (uint64_t i = 0; i < count && !chip->fault; i++) {
+		feed(chip, n + i, seed);
+		side->step(chip);
+	}
+}
+
+static void checkpoint(struct side* side, size_t size) {
+	memcpy(side->snapshot, side->chip, size);
+	if (side->batch) {
+		for (unsigned l = 0; l < side->batch->count; l++)
+			chip8_batch_get(side->batch, l, (chip8*)(side->lanes + l * size));
+	}
+}
+
+static void restore(struct side* side, size_t size) {
+	memcpy(side->chip, side->snapshot, size);
+	if (side->batch) {
+		for (unsigned l = 0; l < side->batch->count; l++)
+			chip8_batch_put(side->batch, l, (const chip8*)(side->lanes + l * size));
+	}
+}
+
+static void dump_state(FILE* out, const struct side* side) {
+	const chip8* chip = side->chip;
+	fprintf(out, "  %-11s PC %03X  I %04X  SP %u  DT %02X  ST %02X  opcode %04X  fault %s\n",
+		side->name, chip->pc, chip->idx_reg, chip->idx_stack, chip->timer_delay, chip->timer_sound,
+		chip->opcode, chip8_fault_name(chip->fault));
+	fprintf(out, "              V");
+	for (int i = 0; i < 16; i++)
+		fprintf(out, " %02X", chip->registers[i]);
+	fprintf(out, "\n              stack");
+	for (int i = 0; i < CHIP8_STACK_SIZE; i++)
+		fprintf(out, " %03X", chip->stack[i]);
+	fprintf(out, "\n              RAM %016" PRIx64 "  display %016" PRIx64 "  hires %d  planes %X\n",
+		romdb_hash(chip->ram, chip->ram_size), romdb_hash(chip->display, sizeof(chip->display)),
+		chip->hires, chip->planes);
+}
+
+static void dump_difference(FILE* out, const chip8* a, const chip8* b) {
+	for (uint32_t addr = 0; addr < a->ram_size; addr++) {
+		if (a->ram[addr] != b->ram[addr]) {
+			fprintf(out, "  first RAM difference at %04X: %02X vs %02X\n", addr, a->ram[addr], b->ram[addr]);
+			break;
+		}
+	}
+	if (memcmp(a->display, b->display, sizeof(a->display)) != 0)
+		fprintf(out, "  framebuffers differ\n");
+}
+
+// 0 when both sides agree, 1 on a divergence, -1 when the ROM could not be run
+static int run_rom(const char* path, const struct arguments* args, FILE* out) {
+	struct rom rom;
+	rom_status status = rom_open(&rom, path, XOCHIP_RAM_SIZE - START_ADDRESS);
+	if (status != ROM_OK) {
+		fprintf(out, "%s: %s\n", path, rom_status_name(status));
+		return -1;
+	}
+
+	size_t size = chip8_size(args->machine);
+	struct side sides[2] = {
+		{.chip = malloc(size), .snapshot = malloc(size), .name = args->a->name},
+		{.chip = malloc(size), .snapshot = malloc(size), .name = args->b->name},
+	};
+	const struct engine* engine[2] = {args->a, args->b};
+	int result = -1;
+	for (int s = 0; s < 2; s++) {
+		if (!sides[s].chip || !sides[s].snapshot) {
+			fprintf(out, "%s: could not allocate memory\n", path);
+			goto done;
+		}
+		chip8_init(sides[s].chip, args->machine, args->seed);
+		if (args->quirks) { // validated in main
+			unsigned quirks = sides[s].chip->quirks;
+			chip8_parse_quirks(args->quirks, &quirks);
+			sides[s].chip->quirks = quirks;
+		}
+		if (!chip8_load(sides[s].chip, rom.data, rom.size)) {
+			fprintf(out, "%s: too big for the %s machine\n", path, chip8_machine_name(args->machine));
+			goto done;
+		}
+		if (engine[s]->select) {
+			sides[s].step = engine[s]->select(sides[s].chip);
+			continue;
+		}
+		// lane 0 starts out the same as the machine above, it fits since the machine took it
+		sides[s].batch = chip8_batch_create(args->machine, sides[s].chip->quirks, CHIP8_BATCH_BLOCK, args->seed);
+		sides[s].lanes = malloc(CHIP8_BATCH_BLOCK * size);
+		if (!sides[s].batch || !sides[s].lanes) {
+			fprintf(out, "%s: could not allocate memory\n", path);
+			goto done;
+		}
+		chip8_batch_load(sides[s].batch, rom.data, rom.size);
+	}
+
+	uint64_t n = 0;
+	result = 0;
+	while (n < args->instructions) {
+		uint64_t chunk = args->instructions - n < args->interval ? args->instructions - n : args->interval;
+		for (int s = 0; s < 2; s++) {
+			checkpoint(&sides[s], size);
+			advance(&sides[s], n, chunk, args->seed);
+		}
+		if (memcmp(sides[0].chip, sides[1].chip, size) == 0) {
+			n += chunk;
+			if (sides[0].chip->fault)
+				break;
+			continue;
+		}
+
+		//***bisect for the first instruction after the checkpoint that leaves the sides different***
+		uint64_t lo = 0, hi = chunk;
+		while (hi - lo > 1) {
+			uint64_t mid = lo + (hi - lo) / 2;
+			for (int s = 0; s < 2; s++) {
+				restore(&sides[s], size);
+				advance(&sides[s], n, mid, args->seed);
+			}
+			if (memcmp(sides[0].chip, sides[1].chip, size) == 0)
+				lo = mid;
+			else
+				hi = mid;
+		}
+		for (int s = 0; s < 2; s++) {
+			restore(&sides[s], size);
+			advance(&sides[s], n, lo, args->seed);
+		}
+		const chip8* chip = sides[0].chip;
+		uint16_t pc = chip->pc;
+		uint16_t opcode = (chip->ram[pc & (chip->ram_size - 1)] << 8) | chip->ram[(pc + 1) & (chip->ram_size - 1)];
+		fprintf(out, "%s: DIVERGED on instruction #%" PRIu64 ", PC %03X opcode %04X\n", path, n + lo + 1, pc, opcode);
+		fprintf(out, " before:\n");
+		dump_state(out, &sides[0]);
+		for (int s = 0; s < 2; s++)
+			advance(&sides[s], n + lo, 1, args->seed);
+		fprintf(out, " after:\n");
+		dump_state(out, &sides[0]);
+		dump_state(out, &sides[1]);
+		dump_difference(out, sides[0].chip, sides[1].chip);
+		result = 1;
+		break;
+	}
+	if (result == 0)
+		fprintf(out, "%s: ok, %" PRIu64 " instructions%s\n", path, sides[0].chip->cycles,
+			sides[0].chip->fault ? ", then a fault" : "");
+
+done:
+	for (int s = 0; s < 2; s++) {
+		free(sides[s].chip);
+		free(sides[s].snapshot);
+		chip8_batch_free(sides[s].batch);
+		free(sides[s].lanes);
+	}
+	rom_close(&rom);
+	return result;
+}
+
+//***corpus***
+struct corpus {
+	const struct arguments* args;
+	atomic_int next;
+	atomic_int diverged;
+	atomic_int failed;
+};
+
+static void* worker(void* data) {
+	struct corpus* corpus = data;
+	int i;
+	while ((i = atomic_fetch_add(&corpus->next, 1)) < corpus->args->rom_count) {
+		// each report is printed in one piece so the threads' output doesn't interleave
+		char* report = NULL;
+		size_t report_size = 0;
+		FILE* out = open_memstream(&report, &report_size);
+		if (!out) {
+			atomic_fetch_add(&corpus->failed, 1);
+			continue;
+		}
+		int result = run_rom(corpus->args->roms[i], corpus->args, out);
+		fclose(out);
+		fputs(report, stdout);
+		free(report);
+		if (result > 0)
+			atomic_fetch_add(&corpus->diverged, 1);
+		else if (result < 0)
+			atomic_fetch_add(&corpus->failed, 1);
+	}
+	return NULL;
+}
+
+int main(int argc, char* argv[]) {
+	struct arguments arguments = {
+		.machine = CHIP8_MACHINE_CHIP8,
+		.instructions = DIFF_INSTRUCTIONS,
+		.interval = DIFF_INTERVAL,
+		.jobs = sysconf(_SC_NPROCESSORS_ONLN),
+		.seed = 1,
+		.a = &engines[0],
+		.b = &engines[1],
+	};
+	argp_parse(&argp, argc, argv, 0, 0, &arguments);
+	if (arguments.quirks && !chip8_parse_quirks(arguments.quirks, &(unsigned){0})) {
+		fprintf(stderr, "Unknown quirk in '%s'\n", arguments.quirks);
+		return 1;
+	}
+	if (arguments.jobs < 1)
+		arguments.jobs = 1;
+	if (arguments.jobs > arguments.rom_count)
+		arguments.jobs = arguments.rom_count;
+
+	struct corpus corpus = {.args = &arguments};
+	atomic_init(&corpus.next, 0);
+	atomic_init(&corpus.diverged, 0);
+	atomic_init(&corpus.failed, 0);
+	pthread_t* threads = calloc(arguments.jobs, sizeof(*threads));
+	if (!threads) {
+		fprintf(stderr, "Could not allocate memory\n");
+		return 1;
+	}
+	long started = 0;
+	for (; started < arguments.jobs; started++) {
+		if (pthread_create(&threads[started], NULL, worker, &corpus) != 0)
+			break;
+	}
+	if (started == 0)
+		worker(&corpus);
+	for (long i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+	free(threads);
+
+	int diverged = atomic_load(&corpus.diverged), failed = atomic_load(&corpus.failed);
+	printf("%d ROMs, %d diverged, %d could not be run\n", arguments.rom_count, diverged, failed);
+	return diverged || failed;
+}
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
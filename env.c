@@ -0,0 +1,407 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "env.h"
+
+#define ENV_FRAME_HZ 60 // the delay and sound timers tick once per frame
+#define ENV_CHUNK 8 // instances a thread takes at once
+
+struct env_instance {
+	chip8* chip;
+	chip8_step_fn step;
+	double budget; // emulated seconds carried over to the next frame
+	uint32_t frames; // in this episode
+	uint32_t episode;
+	uint32_t newest; // slot in history of the latest frame
+	uint8_t* history; // the last frame_stack frames as a ring, copied out oldest first each step
+	uint8_t done; // after the last step, the next one resets
+} __attribute__((aligned(64))); // threads write neighbouring instances
+
+struct chip8_env {
+	chip8_env_config config;
+	unsigned count;
+	unsigned shape[3]; // planes, height, width
+	size_t frame_bytes;
+	size_t obs_bytes;
+	uint8_t* program;
+	size_t size;
+	struct env_instance* instances;
+	uint8_t* history; // every instance's ring, obs_bytes each
+	// the call in progress, shared with the pool
+	bool resetting;
+	const uint16_t* actions;
+	uint8_t* obs;
+	float* rewards;
+	uint8_t* dones;
+	atomic_uint next;
+	// the pool, woken once per call by bumping generation
+	pthread_t* threads;
+	unsigned thread_count;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	pthread_cond_t idle;
+	unsigned generation;
+	unsigned busy; // helpers still working on this generation
+	bool quit;
+};
+
+//***observations***
+static inline void store_be64(uint8_t* out, uint64_t word, bool merge) {
+	for (unsigned b = 0; b < 8; b++) {
+		uint8_t byte = word >> (56 - 8 * b);
+		out[b] = merge ? out[b] | byte : byte;
+	}
+}
+
+// every bit of x twice, for lo-res rows on a hi-res frame
+static inline uint64_t double_bits(uint32_t x) {
+	uint64_t v = x;
+	v = (v | (v << 16)) & 0x0000FFFF0000FFFFull;
+	v = (v | (v << 8)) & 0x00FF00FF00FF00FFull;
+	v = (v | (v << 4)) & 0x0F0F0F0F0F0F0F0Full;
+	v = (v | (v << 2)) & 0x3333333333333333ull;
+	v = (v | (v << 1)) & 0x5555555555555555ull;
+	return v | (v << 1);
+}
+
+// packs the display into out, or ORs it into what is there when merge is set
+static void pack_frame(const chip8_env* env, const chip8* chip, uint8_t* out, bool merge) {
+	const unsigned planes = env->shape[0], height = env->shape[1], width = env->shape[2];
+	for (unsigned p = 0; p < planes; p++) {
+		for (unsigned y = 0; y < height; y++) {
+			if (width == CHIP8_WIDTH) {
+				store_be64(out, chip->display[p][y][0], merge);
+			} else if (chip->hires) {
+				store_be64(out, chip->display[p][y][0], merge);
+				store_be64(out + 8, chip->display[p][y][1], merge);
+			} else {
+				uint64_t row = chip->display[p][y / 2][0];
+				store_be64(out, double_bits(row >> 32), merge);
+				store_be64(out + 8, double_bits(row & 0xFFFFFFFFu), merge);
+			}
+			out += width / 8;
+		}
+	}
+}
+
+//***instances***
+static uint32_t episode_seed(uint32_t seed, unsigned n, uint32_t episode) {
+	// splitmix64, so neighbouring instances and episodes get unrelated RNG streams
+	uint64_t z = ((uint64_t)seed << 32 | n) + (uint64_t)episode * 0x9E3779B97F4A7C15ull;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return (uint32_t)(z ^ (z >> 31));
+}
+
+static uint16_t read_value(const chip8* chip, const chip8_env_value* value) {
+	if (value->source == CHIP8_ENV_REGISTER) {
+		uint8_t hi = chip->registers[value->addr & 0xFu];
+		return value->width == 2 ? (hi << 8) | chip->registers[(value->addr + 1u) & 0xFu] : hi;
+	}
+	uint32_t mask = chip->ram_size - 1;
+	uint8_t hi = chip->ram[value->addr & mask];
+	return value->width == 2 ? (hi << 8) | chip->ram[(value->addr + 1u) & mask] : hi;
+}
+
+// how much the value went up from before, wrapping at its width so a rolled over counter still counts
+static int32_t value_delta(const chip8_env_value* value, uint16_t before, uint16_t after) {
+	return value->width == 2 ? (int16_t)(uint16_t)(after - before) : (int8_t)(uint8_t)(after - before);
+}
+
+static void reset_instance(chip8_env* env, unsigned n, uint8_t* obs) {
+	struct env_instance* inst = &env->instances[n];
+	chip8* chip = inst->chip;
+	chip8_init(chip, env->config.machine, episode_seed(env->config.seed, n, inst->episode++));
+	chip->quirks = env->config.quirks;
+	chip8_load(chip, env->program, env->size); // checked to fit in chip8_env_create()
+	inst->step = chip8_step_for(chip);
+	inst->budget = 0.0;
+	inst->frames = 0;
+	inst->done = 0;
+	inst->newest = 0;
+	// the first observation repeats the starting frame for the whole stack
+	pack_frame(env, chip, inst->history, false);
+	for (unsigned f = 1; f < env->config.frame_stack; f++)
+		memcpy(inst->history + f * env->frame_bytes, inst->history, env->frame_bytes);
+	memcpy(obs, inst->history, env->obs_bytes);
+}
+
+// the ring into obs, oldest frame first
+static void copy_frames(const chip8_env* env, const struct env_instance* inst, uint8_t* obs) {
+	size_t split = (inst->newest + 1) * env->frame_bytes;
+	memcpy(obs, inst->history + split, env->obs_bytes - split);
+	memcpy(obs + env->obs_bytes - split, inst->history, split);
+}
+
+// one 60hz frame like the emulator's, false when the machine faulted or exited
+static bool run_frame(const chip8_env* env, struct env_instance* inst) {
+	chip8* chip = inst->chip;
+	inst->budget += 1.0 / ENV_FRAME_HZ;
+	while (inst->budget > 0.0) {
+		double wait = inst->step(chip);
+		if (chip->fault)
+			return false;
+		inst->budget -= env->config.hz ? 1.0 / env->config.hz : wait;
+	}
+	chip->events = 0;
+	if (chip->timer_delay > 0)
+		chip->timer_delay--;
+	if (chip->timer_sound > 0)
+		chip->timer_sound--;
+	inst->frames++;
+	return true;
+}
+
+static void step_instance(chip8_env* env, unsigned n) {
+	const chip8_env_config* config = &env->config;
+	struct env_instance* inst = &env->instances[n];
+	chip8* chip = inst->chip;
+	uint8_t* obs = env->obs + n * env->obs_bytes;
+	if (env->resetting || inst->done) {
+		reset_instance(env, n, obs);
+		if (!env->resetting) {
+			env->rewards[n] = 0.0f;
+			env->dones[n] = 0;
+		}
+		return;
+	}
+
+	uint16_t before[CHIP8_ENV_MAX_REWARDS];
+	for (unsigned r = 0; r < config->reward_count; r++)
+		before[r] = read_value(chip, &config->rewards[r].value);
+	chip->keys = env->actions[n];
+	uint8_t done = 0;
+	// the oldest frame's slot takes the new one
+	inst->newest = (inst->newest + 1) % config->frame_stack;
+	uint8_t* newest = inst->history + inst->newest * env->frame_bytes;
+	for (unsigned f = 0; f < config->frame_skip; f++) {
+		if (!run_frame(env, inst)) {
+			done |= CHIP8_ENV_TERMINATED;
+			break;
+		}
+		if (config->max_pool && f + 2 == config->frame_skip)
+			pack_frame(env, chip, newest, false);
+	}
+	// a single frame step or an early fault has nothing to pool with
+	pack_frame(env, chip, newest, config->max_pool && config->frame_skip > 1 && !done);
+	copy_frames(env, inst, obs);
+
+	float reward = 0.0f;
+	for (unsigned r = 0; r < config->reward_count; r++) {
+		const chip8_env_reward* spec = &config->rewards[r];
+		reward += spec->scale * value_delta(&spec->value, before[r], read_value(chip, &spec->value));
+	}
+	if (config->done.value.width && read_value(chip, &config->done.value) == config->done.equals)
+		done |= CHIP8_ENV_TERMINATED;
+	if (config->max_frames && inst->frames >= config->max_frames)
+		done |= CHIP8_ENV_TRUNCATED;
+	inst->done = done;
+	env->rewards[n] = reward;
+	env->dones[n] = done;
+}
+
+//***thread pool***
+static void run_share(chip8_env* env) {
+	unsigned first;
+	while ((first = atomic_fetch_add_explicit(&env->next, ENV_CHUNK, memory_order_relaxed)) < env->count) {
+		unsigned last = first + ENV_CHUNK < env->count ? first + ENV_CHUNK : env->count;
+		for (unsigned n = first; n < last; n++)
+			step_instance(env, n);
+	}
+}
+
+static void* worker(void* arg) {
+	chip8_env* env = arg;
+	unsigned seen = 0; // every helper starts before the first call
+	pthread_mutex_lock(&env->lock);
+	for (;;) {
+		while (env->generation == seen && !env->quit)
+			pthread_cond_wait(&env->wake, &env->lock);
+		if (env->quit)
+			break;
+		seen = env->generation;
+		pthread_mutex_unlock(&env->lock);
+		run_share(env);
+		pthread_mutex_lock(&env->lock);
+		if (--env->busy == 0)
+			pthread_cond_signal(&env->idle);
+	}
+	pthread_mutex_unlock(&env->lock);
+	return NULL;
+}
+
+// every instance through step_instance(), the calling thread takes a share too
+static void run_all(chip8_env* env) {
+	atomic_store_explicit(&env->next, 0, memory_order_relaxed);
+	if (env->thread_count == 0) {
+		run_share(env);
+		return;
+	}
+	pthread_mutex_lock(&env->lock);
+	env->generation++;
+	env->busy = env->thread_count;
+	pthread_cond_broadcast(&env->wake);
+	pthread_mutex_unlock(&env->lock);
+	run_share(env);
+	pthread_mutex_lock(&env->lock);
+	while (env->busy)
+		pthread_cond_wait(&env->idle, &env->lock);
+	pthread_mutex_unlock(&env->lock);
+}
+
+//***api***
+void chip8_env_config_default(chip8_env_config* config, chip8_machine machine) {
+	memset(config, 0, sizeof(*config));
+	config->machine = machine;
+	config->quirks = chip8_default_quirks(machine);
+	config->frame_skip = 4;
+	config->frame_stack = 4;
+}
+
+static bool valid_value(const chip8_env_value* value) {
+	return (value->source == CHIP8_ENV_RAM || value->source == CHIP8_ENV_REGISTER) && value->width >= 1 && value->width <= 2;
+}
+
+chip8_env* chip8_env_create(const chip8_env_config* config, const uint8_t* program, size_t size, unsigned count) {
+	if (config->machine > CHIP8_MACHINE_XOCHIP || config->frame_skip < 1 || config->frame_stack < 1 || count < 1)
+		return NULL;
+	if (config->reward_count > CHIP8_ENV_MAX_REWARDS)
+		return NULL;
+	for (unsigned r = 0; r < config->reward_count; r++) {
+		if (!valid_value(&config->rewards[r].value))
+			return NULL;
+	}
+	if (config->done.value.width && !valid_value(&config->done.value))
+		return NULL;
+
+	chip8_env* env = calloc(1, sizeof(*env));
+	if (!env)
+		return NULL;
+	env->config = *config;
+	env->count = count;
+	env->shape[0] = config->machine == CHIP8_MACHINE_XOCHIP ? CHIP8_PLANES : 1;
+	env->shape[1] = config->machine == CHIP8_MACHINE_CHIP8 ? CHIP8_HEIGHT : CHIP8_HIRES_HEIGHT;
+	env->shape[2] = config->machine == CHIP8_MACHINE_CHIP8 ? CHIP8_WIDTH : CHIP8_HIRES_WIDTH;
+	env->frame_bytes = env->shape[0] * env->shape[1] * env->shape[2] / 8;
+	env->obs_bytes = config->frame_stack * env->frame_bytes;
+	pthread_mutex_init(&env->lock, NULL);
+	pthread_cond_init(&env->wake, NULL);
+	pthread_cond_init(&env->idle, NULL);
+	env->program = malloc(size ? size : 1);
+	env->instances = aligned_alloc(64, count * sizeof(*env->instances));
+	env->history = malloc(count * env->obs_bytes);
+	if (!env->program || !env->instances || !env->history) {
+		chip8_env_free(env);
+		return NULL;
+	}
+	memcpy(env->program, program, size);
+	env->size = size;
+	memset(env->instances, 0, count * sizeof(*env->instances));
+	for (unsigned n = 0; n < count; n++) {
+		chip8* chip = chip8_create(config->machine, 0);
+		env->instances[n].chip = chip;
+		env->instances[n].history = env->history + n * env->obs_bytes;
+		if (!chip || !chip8_load(chip, program, size)) {
+			chip8_env_free(env);
+			return NULL;
+		}
+	}
+
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	unsigned threads = config->threads ? config->threads : (cpus > 0 ? (unsigned)cpus : 1);
+	if (threads > (count + ENV_CHUNK - 1) / ENV_CHUNK)
+		threads = (count + ENV_CHUNK - 1) / ENV_CHUNK;
+	// the caller's thread is one of them, a pool that couldn't start fully just has fewer helpers
+	if (threads > 1) {
+		env->threads = calloc(threads - 1, sizeof(*env->threads));
+		if (!env->threads) {
+			chip8_env_free(env);
+			return NULL;
+		}
+		while (env->thread_count < threads - 1 && pthread_create(&env->threads[env->thread_count], NULL, worker, env) == 0)
+			env->thread_count++;
+	}
+	return env;
+}
+
+void chip8_env_free(chip8_env* env) {
+	if (!env)
+		return;
+	pthread_mutex_lock(&env->lock);
+	env->quit = true;
+	pthread_cond_broadcast(&env->wake);
+	pthread_mutex_unlock(&env->lock);
+	for (unsigned t = 0; t < env->thread_count; t++)
+		pthread_join(env->threads[t], NULL);
+	free(env->threads);
+	if (env->instances) {
+		for (unsigned n = 0; n < env->count; n++)
+			free(env->instances[n].chip);
+	}
+	free(env->instances);
+	free(env->history);
+	free(env->program);
+	pthread_cond_destroy(&env->idle);
+	pthread_cond_destroy(&env->wake);
+	pthread_mutex_destroy(&env->lock);
+	free(env);
+}
+
+unsigned chip8_env_count(const chip8_env* env) {
+	return env->count;
+}
+
+size_t chip8_env_observation_size(const chip8_env* env) {
+	return env->obs_bytes;
+}
+
+void chip8_env_frame_shape(const chip8_env* env, unsigned shape[3]) {
+	memcpy(shape, env->shape, sizeof(env->shape));
+}
+
+void chip8_env_reset(chip8_env* env, uint8_t* obs) {
+	env->resetting = true;
+	env->obs = obs;
+	run_all(env);
+	env->resetting = false;
+}
+
+void chip8_env_step(chip8_env* env, const uint16_t* actions, uint8_t* obs, float* rewards, uint8_t* dones) {
+	env->actions = actions;
+	env->obs = obs;
+	env->rewards = rewards;
+	env->dones = dones;
+	run_all(env);
+}
+
+const chip8* chip8_env_instance(const chip8_env* env, unsigned n) {
+	return env->instances[n].chip;
+}
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
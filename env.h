@@ -0,0 +1,110 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+#ifndef CHIP8_ENV_H
+#define CHIP8_ENV_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "chip8.h"
+
+/* A vector of CHIP-8 games as reinforcement learning environments. Every instance runs the same ROM
+with its own seed; a step holds each instance's keypad mask for frame_skip 60hz frames and writes
+observations, rewards and done flags straight into arrays owned by the caller, indexed by instance.
+Instances are spread over a pool of threads that lives as long as the environment.
+
+An observation is frame_stack frames, oldest first. A frame is the display packed 1 bit per pixel, MSB
+first, one plane after the other and each plane row by row: 64x32 on CHIP-8, 128x64 on SUPER-CHIP and
+XO-CHIP (lo-res doubled up), and two planes on XO-CHIP only. Each instance keeps its own stack of
+frames and copies it out whole, so obs is only written, never read: any buffer will do on every call.
+
+Rewards and the done condition read values the game keeps in RAM or in a register. The fixed width
+types keep the layout the same from C and from the Python binding in chip8env.py. */
+#define CHIP8_ENV_MAX_REWARDS 4
+
+// where a chip8_env_value lives
+#define CHIP8_ENV_RAM 0
+#define CHIP8_ENV_REGISTER 1
+
+// bits in the done flags
+#define CHIP8_ENV_TERMINATED 0x1u // the done condition held, or the machine faulted or exited
+#define CHIP8_ENV_TRUNCATED 0x2u // max_frames ran out
+
+typedef struct chip8_env_value {
+	uint8_t source; // CHIP8_ENV_RAM or CHIP8_ENV_REGISTER
+	uint8_t width; // bytes, 1 or 2 (big endian, like every other CHIP-8 word). 0 when unused
+	uint16_t addr; // RAM address or register number
+} chip8_env_value;
+
+// scale times how much the value went up during the step, differences wrap at the value's width
+typedef struct chip8_env_reward {
+	chip8_env_value value;
+	float scale;
+} chip8_env_reward;
+
+// the episode ends once the value equals this, e.g. a lives counter reaching 0
+typedef struct chip8_env_done {
+	chip8_env_value value;
+	uint16_t equals;
+} chip8_env_done;
+
+typedef struct chip8_env_config {
+	uint32_t machine; // chip8_machine
+	uint32_t quirks; // CHIP8_QUIRK_* bits
+	uint32_t hz; // instructions per second, 0 for the COSMAC VIP timings like the emulator's default
+	uint32_t frame_skip; // 60hz frames per step, at least 1
+	uint32_t frame_stack; // frames per observation, at least 1
+	uint32_t max_pool; // nonzero ORs the last two frames of a step together, which hides XOR sprite flicker
+	uint32_t max_frames; // an episode is truncated after this many frames, 0 for never
+	uint32_t threads; // 0 for one per CPU
+	uint32_t seed; // instance n of episode e gets its own seed derived from this, n and e
+	uint32_t reward_count;
+	chip8_env_reward rewards[CHIP8_ENV_MAX_REWARDS];
+	chip8_env_done done; // done.value.width 0 for none
+} chip8_env_config;
+
+typedef struct chip8_env chip8_env;
+
+// the defaults for machine: its quirks, VIP timing, 4 frames skipped and stacked, no rewards
+void chip8_env_config_default(chip8_env_config* config, chip8_machine machine);
+/* count instances of program, call chip8_env_reset() before the first step. The program is copied.
+NULL when the config is invalid, the program doesn't fit or out of memory. */
+chip8_env* chip8_env_create(const chip8_env_config* config, const uint8_t* program, size_t size, unsigned count);
+void chip8_env_free(chip8_env* env);
+unsigned chip8_env_count(const chip8_env* env);
+// bytes of one instance's observation: frame_stack * planes * height * width / 8
+size_t chip8_env_observation_size(const chip8_env* env);
+// planes, height and width in pixels of one frame
+void chip8_env_frame_shape(const chip8_env* env, unsigned shape[3]);
+// starts a new episode on every instance. obs holds count observations
+void chip8_env_reset(chip8_env* env, uint8_t* obs);
+/* Holds actions[n], a keypad mask with bit k for hex key k, on instance n for one step. An instance
+that was done after the previous step starts a new episode instead, ignoring its action and returning
+the first observation with reward 0. obs, rewards and dones hold count entries each. */
+void chip8_env_step(chip8_env* env, const uint16_t* actions, uint8_t* obs, float* rewards, uint8_t* dones);
+// the machine behind instance n, for inspection between steps
+const chip8* chip8_env_instance(const chip8_env* env, unsigned n);
+
+#endif
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
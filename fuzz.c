@@ -0,0 +1,118 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+/* Fuzzing harness for the headless core, built by ./nob fuzz (libFuzzer) or ./nob fuzz-afl (AFL++).
+Input layout:
+	byte 0      machine (mod 3)
+	byte 1      quirk bits
+	byte 2      number of keypad frames in the script, n
+	n * 2 bytes keypad state for each frame, little endian, replayed in a loop
+	rest        the ROM, loaded at START_ADDRESS
+Every input runs for at most FUZZ_FRAMES frames of FUZZ_CYCLES instructions, ticking the timers at
+each frame boundary like the emulation thread does. The machine is a static buffer reset by
+chip8_init(), so back to back runs in persistent mode never allocate. */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "chip8.h"
+
+#define FUZZ_FRAMES 16
+#define FUZZ_CYCLES 100 // instructions per frame, kept small so runs stay in the microseconds
+#define FUZZ_HEADER 3
+
+// room for the biggest machine, aligned like malloc would
+static _Alignas(16) uint8_t machine_buffer[sizeof(chip8) + XOCHIP_RAM_SIZE];
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+	if (size < FUZZ_HEADER)
+		return 0;
+	chip8_machine machine = data[0] % 3;
+	unsigned quirks = data[1] % CHIP8_QUIRK_SETS;
+	size_t frames = data[2];
+	const uint8_t* script = data + FUZZ_HEADER;
+	size -= FUZZ_HEADER;
+	if (frames * 2 > size)
+		frames = size / 2;
+	const uint8_t* rom = script + frames * 2;
+	size -= frames * 2;
+
+	chip8* chip = (chip8*)machine_buffer;
+	chip8_init(chip, machine, 1);
+	chip->quirks = quirks;
+	if (!chip8_load(chip, rom, size))
+		return -1; // doesn't fit, keep it out of the corpus
+	chip8_step_fn step = chip8_step_for(chip);
+
+	for (unsigned frame = 0; frame < FUZZ_FRAMES; frame++) {
+		if (frames)
+			chip->keys = script[(frame % frames) * 2] | (script[(frame % frames) * 2 + 1] << 8);
+		for (unsigned i = 0; i < FUZZ_CYCLES; i++) {
+			step(chip);
+			if (chip->fault)
+				return 0;
+		}
+		if (chip->timer_delay > 0)
+			chip->timer_delay--;
+		if (chip->timer_sound > 0)
+			chip->timer_sound--;
+	}
+	return 0;
+}
+
+#ifdef CHIP8_FUZZ_MAIN
+#ifdef __AFL_FUZZ_TESTCASE_LEN
+// AFL++ persistent mode, the test cases arrive through shared memory
+__AFL_FUZZ_INIT();
+
+int main(void) {
+	__AFL_INIT();
+	const uint8_t* data = __AFL_FUZZ_TESTCASE_BUF;
+	while (__AFL_LOOP(100000))
+		LLVMFuzzerTestOneInput(data, __AFL_FUZZ_TESTCASE_LEN);
+	return 0;
+}
+#else
+// without AFL, run each file once, for reproducing crashes
+int main(int argc, char** argv) {
+	static uint8_t input[FUZZ_HEADER + 2 * 255 + XOCHIP_RAM_SIZE];
+	for (int i = 1; i < argc; i++) {
+		FILE* file = fopen(argv[i], "rb");
+		if (!file) {
+			fprintf(stderr, "File %s not found\n", argv[i]);
+			return 1;
+		}
+		size_t size = fread(input, 1, sizeof(input), file);
+		fclose(file);
+		LLVMFuzzerTestOneInput(input, size);
+	}
+	return 0;
+}
+#endif
+#endif
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
@@ -0,0 +1,174 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+#include <stdlib.h>
+#include <string.h>
+#include "hash.h"
+
+// where each word of state lives, keeps equal words in different places from cancelling out
+#define HASH_DOMAIN_STATE 0x100000000ull
+#define HASH_DOMAIN_STACK 0x200000000ull
+#define HASH_DOMAIN_DISPLAY 0x300000000ull
+#define HASH_DOMAIN_RAM 0x400000000ull
+
+struct chip8_hasher {
+	uint64_t ram; // every block of the loaded RAM
+	unsigned dirty_words;
+	// the part of the display the machine can draw into, see pool.c
+	unsigned planes;
+	uint64_t rows; // a bit per row
+	uint64_t blocks[]; // each block of the loaded RAM
+};
+
+// splitmix64's finalizer
+static inline uint64_t mix64(uint64_t x) {
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+	return x ^ (x >> 31);
+}
+
+// the Zobrist key of value at location
+static inline uint64_t zobrist(uint64_t location, uint64_t value) {
+	return mix64(value ^ mix64(location));
+}
+
+static uint64_t hash_block(const uint8_t* ram, unsigned block) {
+	uint64_t h = 0;
+	for (unsigned w = 0; w < CHIP8_DIRTY_BLOCK / 8; w++) {
+		uint64_t word;
+		memcpy(&word, ram + block * CHIP8_DIRTY_BLOCK + w * 8, sizeof(word));
+		h ^= zobrist(HASH_DOMAIN_RAM + block * (CHIP8_DIRTY_BLOCK / 8) + w, word);
+	}
+	return h;
+}
+
+chip8_hasher* chip8_hasher_create(const chip8* base) {
+	unsigned blocks = base->ram_size / CHIP8_DIRTY_BLOCK;
+	chip8_hasher* hasher = malloc(sizeof(*hasher) + blocks * sizeof(hasher->blocks[0]));
+	if (!hasher)
+		return NULL;
+	hasher->ram = 0;
+	for (unsigned b = 0; b < blocks; b++) {
+		hasher->blocks[b] = hash_block(base->ram, b);
+		hasher->ram ^= hasher->blocks[b];
+	}
+	hasher->dirty_words = (blocks + 63) / 64;
+	hasher->planes = base->machine == CHIP8_MACHINE_XOCHIP ? CHIP8_PLANES : 1;
+	hasher->rows = base->machine == CHIP8_MACHINE_CHIP8 ? (1ull << CHIP8_HEIGHT) - 1 : ~0ull;
+	return hasher;
+}
+
+void chip8_hasher_free(chip8_hasher* hasher) {
+	free(hasher);
+}
+
+// the rows of a band in every plane, keyed by where each word sits in chip8.display
+static uint64_t hash_band(const chip8_hasher* hasher, const chip8* chip, unsigned band) {
+	uint64_t h = 0;
+	for (unsigned p = 0; p < hasher->planes; p++) {
+		for (unsigned y = band * CHIP8_HASH_BAND; y < (band + 1) * CHIP8_HASH_BAND; y++) {
+			for (unsigned w = 0; w < 2; w++)
+				h ^= zobrist(HASH_DOMAIN_DISPLAY + (p * CHIP8_HIRES_HEIGHT + y) * 2 + w, chip->display[p][y][w]);
+		}
+	}
+	return h;
+}
+
+uint64_t chip8_hash(const chip8_hasher* hasher, chip8* chip) {
+	uint64_t h = hasher->ram;
+	for (unsigned w = 0; w < hasher->dirty_words; w++) {
+		for (uint64_t dirty = chip->dirty[w]; dirty; dirty &= dirty - 1) {
+			unsigned block = w * 64 + __builtin_ctzll(dirty);
+			h ^= hasher->blocks[block] ^ hash_block(chip->ram, block);
+		}
+	}
+
+	// only the bands drawn into since the last call are hashed again
+	const uint64_t drawn = chip->drawn & hasher->rows;
+	for (unsigned band = 0; band < CHIP8_HIRES_HEIGHT / CHIP8_HASH_BAND; band++) {
+		if ((drawn >> (band * CHIP8_HASH_BAND)) & ((1ull << CHIP8_HASH_BAND) - 1))
+			chip->band_hash[band] = hash_band(hasher, chip, band);
+		h ^= chip->band_hash[band];
+	}
+	chip->drawn = 0;
+
+	// entries above the stack pointer are dead, the next call overwrites them before a return reads them
+	unsigned depth = chip->idx_stack < CHIP8_STACK_SIZE ? chip->idx_stack : CHIP8_STACK_SIZE;
+	for (unsigned d = 0; d < depth; d++)
+		h ^= zobrist(HASH_DOMAIN_STACK + d, chip->stack[d]);
+
+	uint64_t v[2], rpl[2], pattern[2];
+	memcpy(v, chip->registers, sizeof(v));
+	memcpy(rpl, chip->rpl, sizeof(rpl));
+	memcpy(pattern, chip->pattern, sizeof(pattern));
+	uint64_t control = (uint64_t)chip->pc | (uint64_t)chip->idx_reg << 16 | (uint64_t)chip->idx_stack << 32
+		| (uint64_t)chip->timer_delay << 40 | (uint64_t)chip->timer_sound << 48 | (uint64_t)chip->fault << 56;
+	uint64_t mode = (uint64_t)chip->rng | (uint64_t)chip->hires << 32 | (uint64_t)chip->planes << 40
+		| (uint64_t)chip->pitch << 48 | (uint64_t)chip->quirks << 56;
+	const uint64_t words[] = {v[0], v[1], control, mode, rpl[0], rpl[1], pattern[0], pattern[1]};
+	for (unsigned w = 0; w < sizeof(words) / sizeof(words[0]); w++)
+		h ^= zobrist(HASH_DOMAIN_STATE + w, words[w]);
+	return h;
+}
+
+//***visited set***
+bool chip8_visited_init(chip8_visited* set, unsigned bits) {
+	size_t capacity = (size_t)1 << bits;
+	set->slots = calloc(capacity, sizeof(set->slots[0]));
+	if (!set->slots)
+		return false;
+	set->mask = capacity - 1;
+	atomic_init(&set->count, 0);
+	return true;
+}
+
+void chip8_visited_free(chip8_visited* set) {
+	free(set->slots);
+	set->slots = NULL;
+}
+
+chip8_visited_result chip8_visited_insert(chip8_visited* set, uint64_t hash) {
+	if (hash == 0)
+		hash = 1; // 0 is a free slot
+	// probes get long past three quarters full
+	if (atomic_load_explicit(&set->count, memory_order_relaxed) >= set->mask - set->mask / 4)
+		return CHIP8_VISITED_FULL;
+	size_t at = hash & set->mask;
+	for (size_t probe = 0; probe <= set->mask; probe++, at = (at + 1) & set->mask) {
+		uint64_t seen = atomic_load_explicit(&set->slots[at], memory_order_relaxed);
+		if (seen == hash)
+			return CHIP8_VISITED_SEEN;
+		if (seen)
+			continue;
+		// a slot only ever goes from free to a hash, so losing the race just means checking what won
+		if (atomic_compare_exchange_strong_explicit(&set->slots[at], &seen, hash, memory_order_relaxed, memory_order_relaxed)) {
+			atomic_fetch_add_explicit(&set->count, 1, memory_order_relaxed);
+			return CHIP8_VISITED_NEW;
+		}
+		if (seen == hash)
+			return CHIP8_VISITED_SEEN;
+	}
+	return CHIP8_VISITED_FULL;
+}
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
@@ -0,0 +1,79 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+#ifndef HASH_H
+#define HASH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "chip8.h"
+
+/* 64-bit state hashes for deduplicating machines during search, Zobrist style: the hash is the XOR
+of one key per 64-bit word of state, each a function of where the word lives and what it holds.
+Two machines hash the same when everything that decides what they do next matches: registers, PC,
+I, the live part of the stack, timers, RNG, fault, the display and RAM. The cycle count, the last
+opcode, pending events and the keypad (an input, not state) are left out.
+
+RAM is the bulk of it, and a machine only ever differs from the ROM it was loaded with in its dirty
+blocks (see chip8.dirty). So the hasher keeps the loaded RAM's hash and each of its blocks' hashes,
+and hashing a machine swaps in the current contents of just those blocks. The display is cached in
+the machine itself, a hash per band of CHIP8_HASH_BAND rows: only bands drawn into since the last
+chip8_hash() of the machine (or of the one it was copied from) are hashed again, so a display that
+didn't change costs nothing. A hash per row would be finer, but pool.c copies the cache with every
+clone and 64 of them are eight cache lines against one.
+
+RAM has no such cache, a block once written is hashed on every call. A running hash kept up to date
+by the interpreter would make every RAM write and draw pay for a Zobrist key, in the emulator too,
+while search only hashes once per action, many frames of instructions apart. */
+typedef struct chip8_hasher chip8_hasher;
+
+// for base and its descendants, base being a machine right after chip8_init() and chip8_load()
+chip8_hasher* chip8_hasher_create(const chip8* base);
+void chip8_hasher_free(chip8_hasher* hasher);
+// updates chip's display cache, see chip8.drawn
+uint64_t chip8_hash(const chip8_hasher* hasher, chip8* chip);
+
+/* Lock-free set of hashes, open addressing with linear probing, 0 marks a free slot. Any number of
+threads can insert at once. The capacity is fixed, a power of two, and the set counts as full at
+three quarters. */
+typedef struct chip8_visited {
+	_Atomic uint64_t* slots;
+	size_t mask;
+	atomic_size_t count;
+} chip8_visited;
+
+// room for 2^bits hashes, false when out of memory
+bool chip8_visited_init(chip8_visited* set, unsigned bits);
+void chip8_visited_free(chip8_visited* set);
+typedef enum {
+	CHIP8_VISITED_NEW,
+	CHIP8_VISITED_SEEN,
+	CHIP8_VISITED_FULL,
+} chip8_visited_result;
+chip8_visited_result chip8_visited_insert(chip8_visited* set, uint64_t hash);
+
+#endif
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
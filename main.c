@@ -3,51 +3,174 @@ Copyright (C) 2025 Eric Hernandez
 See end of file for extended copyright information */
 
 #include <raylib.h>
+#include <errno.h>
+#include <poll.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
 #include <argp.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include "chip8.h"
+#include "pacer.h"
+#include "audio.h"
+#include "debugger.h"
+#include "rom.h"
+#include "romdb.h"
+#include "trace.h"
+#include "profile.h"
+#include "metrics.h"
+#include "shm.h"
+#include "stream.h"
 
-#define CHIP8_WIDTH 64
-#define CHIP8_HEIGHT 32
 #define SCALE_FACTOR 32 // Integer scaling
-#define FONTSET_SIZE 80
-#define FONT_START_ADDRESS 0x80
-#define START_ADDRESS 0x200
-
-typedef struct Chip8_t {
-	uint8_t ram[4096];
-	uint8_t display[CHIP8_HEIGHT][CHIP8_WIDTH];
-	uint16_t stack[16];
-	uint8_t registers[16];
-	uint16_t idx_reg;
-	uint16_t pc;
-	uint16_t opcode;
-	uint8_t idx_stack;
-	uint8_t timer_delay;
-	uint8_t timer_sound;
-} chip8;
+#define TIMER_HZ 60 // the delay and sound timers count down at 60hz of emulated time
+#define AUDIO_LATENCY_MS 50
+#define METRICS_INTERVAL 10 // seconds
+
+/* Input-to-photon latency probe.
+A probe starts when the render thread samples a keypad change and walks through the stages below on the
+emulation thread: the ROM reads the keypad (Ex9E/ExA1/Fx0A), then changes the display (00E0/Dxyn). Frames
+published after that carry the probe, and the render thread closes it once one of them is presented after
+EndDrawing(). Only one probe is in flight at a time; a newer keypad change replaces a probe that has not
+been presented yet. */
+#define LATENCY_MAX_SAMPLES 4096
+#define LATENCY_BUCKET_MS 2
+#define LATENCY_BUCKETS 25
+
+typedef enum {
+	PROBE_IDLE,
+	PROBE_SAMPLED,
+	PROBE_READ,
+	PROBE_DRAWN,
+} probe_stage;
+
+// emulation side of a probe, identified by the keypad change counter it belongs to
+struct latency_probe {
+	probe_stage stage;
+	uint16_t seq;
+	uint64_t cycle_sample;
+	uint64_t cycle_read;
+	uint64_t cycle_draw;
+};
+
+struct latency_stats {
+	uint64_t total_ns[LATENCY_MAX_SAMPLES];
+	uint64_t read_cycles[LATENCY_MAX_SAMPLES];
+	uint64_t draw_cycles[LATENCY_MAX_SAMPLES];
+	size_t count;
+	size_t superseded; // changes replaced by a newer one before the ROM drew anything
+};
+
+
+/* Frames are handed from the emulation thread to the render thread through a lock-free triple buffer.
+The writer owns one slot, the reader owns another and the third sits in the middle. Publishing swaps
+the writer's slot with the middle one and marks it fresh; the reader only swaps when the middle slot
+is fresh, so neither side ever waits for the other. */
+#define TRIPLE_FRESH 0x4u
+#define TRIPLE_INDEX 0x3u
 
+struct frame {
+	chip8_plane display[CHIP8_PLANES]; // packed, see chip8.display
+	bool hires;
+	struct latency_probe probe; // last probe that reached PROBE_DRAWN, stage is PROBE_IDLE if none
+};
+
+struct triple_buffer {
+	struct frame frames[3];
+	_Atomic uint8_t middle;
+};
+
+struct emulator {
+	chip8* chip;
+	struct triple_buffer screen;
+	_Atomic uint32_t input; // keypad mask in the low 16 bits, keypad change counter in the high 16 bits
+	atomic_bool running;
+	int status;
+	float hz;
+	float speed; // multiple of real time, 0 runs unthrottled
+	atomic_bool turbo; // fast-forward hotkey held, runs unthrottled
+	bool audio;
+	bool latency;
+	bool debug;
+	bool trace;
+	bool metrics;
+	struct chip8_shm* shm; // NULL unless --shm
+	int stream; // connection to a chip8-serve with --connect, -1 when running a ROM here
+	struct pacer pacer;
+};
 
 struct arguments {
 	char* filename;
 	long scale_factor;
 	float fps;
 	float hz;
+	float speed;
+	bool latency;
+	bool pacer_stats;
+	bool mute;
+	long audio_latency;
+	bool audio_stats;
+	chip8_machine machine;
+	bool machine_set;
+	const char* quirks;
+	const char* romdb;
+	bool debug;
+	const char* trace;
+	const char* profile;
+	const char* metrics;
+	double metrics_interval;
+	const char* shm;
+	const char* connect;
+};
+
+enum {
+	OPT_LATENCY = 256,
+	OPT_PACER_STATS,
+	OPT_SPEED,
+	OPT_MUTE,
+	OPT_AUDIO_LATENCY,
+	OPT_AUDIO_STATS,
+	OPT_ROMDB,
+	OPT_DEBUG,
+	OPT_TRACE,
+	OPT_PROFILE,
+	OPT_METRICS,
+	OPT_METRICS_INTERVAL,
+	OPT_SHM,
+	OPT_CONNECT,
 };
 
 static struct argp_option options[] = {
 	{"scalefactor", 's', "NUMBER", 0, "Scaling factor. Defaults to 32", 0},
 	{"fps", 'f', "NUMBER", 0, "FPS limit. Defaults to 60", 0},
 	{"cpuherz", 'h', "NUMBER", 0, "Set clock speed in hz. By default, uses per instruction cycle speed that aproximates the original COSMIC VIP CHIP-8 timings", 0},
+	{"machine", 'm', "NAME", 0, "Machine to emulate: chip8, schip (SUPER-CHIP 1.1) or xochip. Defaults to chip8", 0},
+	{"quirks", 'q', "LIST", 0, "Quirk profile (chip8, vip, schip, xochip) and/or quirks to set or clear (vf_reset, memory_increment, shift_vx, jump_vx, clip, -clip...). Defaults to the machine's profile", 0},
+	{"romdb", OPT_ROMDB, "FILE", 0, "ROM database index to pick the machine, quirks, speed and keys from. Defaults to romdb.bin when present", 0},
+	{"speed", OPT_SPEED, "FACTOR", 0, "Emulation speed as a multiple of real time, 0 for unlimited. Defaults to 1. Hold TAB to fast-forward", 0},
+	{"mute", OPT_MUTE, 0, 0, "Disable the buzzer", 0},
+	{"audio-latency", OPT_AUDIO_LATENCY, "MS", 0, "Most buzzer audio allowed to queue up ahead of the device. Defaults to 50", 0},
+	{"audio-stats", OPT_AUDIO_STATS, 0, 0, "Print audio queue latency and underruns on exit", 0},
+	{"latency", OPT_LATENCY, 0, 0, "Measure input-to-photon latency and print a histogram on exit", 0},
+	{"pacer-stats", OPT_PACER_STATS, 0, 0, "Print frame pacing drift and sleep/spin statistics on exit", 0},
+	{"debug", OPT_DEBUG, 0, 0, "Start paused in the interactive debugger on the terminal", 0},
+	{"trace", OPT_TRACE, "FILE", 0, "Record every executed instruction to a binary trace, print it with chip8-trace", 0},
+	{"profile", OPT_PROFILE, "FILE", 0, "Write frame timing zones as Chrome trace-event JSON on exit. Needs a build with ./nob profile", 0},
+	{"metrics", OPT_METRICS, "DEST", 0, "Write JSON-lines metrics periodically to a file, or to a Unix socket given as unix:PATH", 0},
+	{"metrics-interval", OPT_METRICS_INTERVAL, "SECONDS", 0, "Time between metrics lines. Defaults to 10", 0},
+	{"shm", OPT_SHM, "NAME", 0, "Publish every frame and the registers to shared memory /NAME, and take keypad input from it", 0},
+	{"connect", OPT_CONNECT, "ADDR", 0, "Show and play a ROM run by chip8-serve on unix:PATH or HOST:PORT instead of a local one", 0},
 	{0}
 };
 
 static char doc[] = "Chip-8 Emulator";
-static char args_doc[] = "chip-8-emu FILEPATH";
+static char args_doc[] = "chip-8-emu FILEPATH|-|ARCHIVE.tar:MEMBER\n--connect=ADDR";
 
 
 static error_t parse_opt (int key, char* arg, struct argp_state* state) {
@@ -62,20 +185,358 @@ static error_t parse_opt (int key, char* arg, struct argp_state* state) {
 		case 'h':
 			arguments->hz = atoi(arg);
 			break;
+		case OPT_LATENCY:
+			arguments->latency = true;
+			break;
+		case 'm':
+			if (!chip8_parse_machine(arg, &arguments->machine))
+				argp_error(state, "unknown machine '%s'", arg);
+			arguments->machine_set = true;
+			break;
+		case 'q':
+			arguments->quirks = arg;
+			break;
+		case OPT_ROMDB:
+			arguments->romdb = arg;
+			break;
+		case OPT_SPEED:
+			arguments->speed = atof(arg);
+			if (arguments->speed < 0.0f)
+				argp_error(state, "speed must not be negative");
+			break;
+		case OPT_MUTE:
+			arguments->mute = true;
+			break;
+		case OPT_AUDIO_LATENCY:
+			arguments->audio_latency = atoi(arg);
+			break;
+		case OPT_AUDIO_STATS:
+			arguments->audio_stats = true;
+			break;
+		case OPT_PACER_STATS:
+			arguments->pacer_stats = true;
+			break;
+		case OPT_DEBUG:
+			arguments->debug = true;
+			break;
+		case OPT_TRACE:
+			arguments->trace = arg;
+			break;
+		case OPT_PROFILE:
+#ifndef CHIP8_PROFILE
+			argp_error(state, "this build has no profiling zones, rebuild with ./nob profile");
+#endif
+			arguments->profile = arg;
+			break;
+		case OPT_METRICS:
+			arguments->metrics = arg;
+			break;
+		case OPT_METRICS_INTERVAL:
+			arguments->metrics_interval = atof(arg);
+			if (arguments->metrics_interval <= 0.0)
+				argp_error(state, "metrics interval must be positive");
+			break;
+		case OPT_SHM:
+			arguments->shm = arg;
+			break;
+		case OPT_CONNECT:
+			arguments->connect = arg;
+			break;
 		case ARGP_KEY_ARG:
 			if (state->arg_num >= 1)
 				argp_usage(state);
 			arguments->filename = arg;
 			break;
 		case ARGP_KEY_END:
-			if (state->arg_num < 1)
+			if (arguments->connect) {
+				// the ROM and everything inspecting it live on the server
+				if (state->arg_num > 0 || arguments->debug || arguments->trace || arguments->shm)
+					argp_error(state, "--connect takes no ROM, --debug, --trace or --shm");
+			} else if (state->arg_num < 1) {
 				argp_usage(state);
+			}
 			break;
 		default:
 			return ARGP_ERR_UNKNOWN;
 	}
 	return 0;
 }
+static uint64_t now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// raylib only refreshes key state in PollInputEvents() (called by EndDrawing()), so one sample per frame is enough
+static uint16_t sample_keypad(const uint16_t keypad[16]) {
+	uint16_t keys = 0;
+	for (uint_fast8_t i = 0; i < 16; i++) {
+		if (IsKeyDown(keypad[i]))
+			keys |= 1u << i;
+	}
+	return keys;
+}
+
+static int compare_u64(const void* a, const void* b) {
+	uint64_t x = *(const uint64_t*)a;
+	uint64_t y = *(const uint64_t*)b;
+	return (x > y) - (x < y);
+}
+
+// publish the writer's slot, and get back the slot to draw the next frame into
+static void triple_publish(struct triple_buffer* tb, uint8_t* back) {
+	*back = atomic_exchange_explicit(&tb->middle, *back | TRIPLE_FRESH, memory_order_acq_rel) & TRIPLE_INDEX;
+}
+
+// swap in the newest frame if there is one, returns false when the reader's slot is already current
+static bool triple_acquire(struct triple_buffer* tb, uint8_t* front) {
+	if (!(atomic_load_explicit(&tb->middle, memory_order_relaxed) & TRIPLE_FRESH))
+		return false;
+	*front = atomic_exchange_explicit(&tb->middle, *front, memory_order_acq_rel) & TRIPLE_INDEX;
+	return true;
+}
+
+static void publish_frame(struct emulator* emu, uint8_t* back, const struct latency_probe* drawn) {
+	PROFILE_ZONE("publish");
+	struct frame* frame = &emu->screen.frames[*back];
+	memcpy(frame->display, emu->chip->display, sizeof(frame->display));
+	frame->hires = emu->chip->hires;
+	// the render thread may skip frames, so every later frame carries the drawn probe too
+	frame->probe = *drawn;
+	triple_publish(&emu->screen, back);
+	if (emu->metrics)
+		metrics_published();
+}
+
+// expand a packed frame into 8-bit grayscale for the texture, the XO-CHIP planes pick one of four shades
+static void unpack_frame(const struct frame* frame, uint8_t pixels[CHIP8_HIRES_HEIGHT][CHIP8_HIRES_WIDTH]) {
+	static const uint8_t palette[1 << CHIP8_PLANES] = {0, 255, 112, 184};
+	for (unsigned y = 0; y < CHIP8_HIRES_HEIGHT; y++) {
+		for (unsigned x = 0; x < CHIP8_HIRES_WIDTH; x++) {
+			unsigned px = frame->hires ? x : x / 2;
+			unsigned py = frame->hires ? y : y / 2;
+			unsigned color = 0;
+			for (unsigned p = 0; p < CHIP8_PLANES; p++)
+				color |= chip8_pixel(frame->display[p], px, py) << p;
+			pixels[y][x] = palette[color];
+		}
+	}
+}
+
+static void* emulation_thread(void* arg) {
+	struct emulator* emu = arg;
+	chip8* chip = emu->chip;
+	/* only the debugger's interpreter checks for breakpoints and only the traced one writes records, the
+	specialized one has nothing extra to do. Under --debug the debugger's interpreter writes the trace too. */
+	chip8_step_fn step = emu->debug ? debugger_step : emu->trace ? trace_step : chip8_step_for(chip);
+	uint8_t back = 0;
+	struct latency_probe probe = {0};
+	struct latency_probe drawn = {0};
+
+	/* The core runs a 60hz frame worth of emulated time at once, then sleeps until that frame's absolute
+	deadline. Instruction costs are carried over between frames so the average speed stays exact, and the
+	delay timer ticks on frame boundaries so it follows emulated time rather than the host clock.
+	Running faster than real time shortens the pacer period, or skips it altogether when unthrottled; the
+	display is then published once per emulated frame instead of on every change, since the render thread
+	could never show the intermediate ones anyway. */
+	double budget = 0.0; // emulated seconds left in the current frame
+	bool dirty = false; // display changed since the last publish
+	bool was_unthrottled = false;
+	uint64_t frames = 0; // emulated, numbers the frames published to --shm
+	uint64_t period = emu->speed > 0.0f ? (uint64_t)(1e9 / (TIMER_HZ * emu->speed)) : 1000000000ull / TIMER_HZ;
+	pacer_init(&emu->pacer, period);
+	PROFILE_THREAD("emulation");
+	while (atomic_load_explicit(&emu->running, memory_order_relaxed)) {
+		PROFILE_ZONE("frame");
+		bool unthrottled = emu->speed <= 0.0f || atomic_load_explicit(&emu->turbo, memory_order_relaxed);
+		bool skip_frames = unthrottled || emu->speed > 1.0f;
+		budget += 1.0 / TIMER_HZ;
+		// an agent on --shm presses keys along with the keyboard, sampled once per frame like the keyboard itself
+		uint16_t agent_keys = emu->shm ? shm_keys(emu->shm) : 0;
+		{
+			PROFILE_ZONE("execute");
+			while (budget > 0.0) {
+				uint32_t input = atomic_load_explicit(&emu->input, memory_order_relaxed);
+				chip->keys = (input & 0xFFFFu) | agent_keys;
+				if (emu->latency && (uint16_t)(input >> 16) != probe.seq) {
+					probe.stage = PROBE_SAMPLED;
+					probe.seq = input >> 16;
+					probe.cycle_sample = chip->cycles;
+				}
+
+				double wait = step(chip);
+				if (chip->fault) {
+					if (chip->fault != CHIP8_FAULT_EXIT) {
+						fprintf(stderr, "%s at %03X\n", chip8_fault_name(chip->fault), chip->pc);
+						emu->status = 1;
+					}
+					atomic_store(&emu->running, false);
+					return NULL;
+				}
+
+				if (chip->events) {
+					if (probe.stage == PROBE_SAMPLED && (chip->events & CHIP8_EVENT_KEYPAD_READ)) {
+						probe.stage = PROBE_READ;
+						probe.cycle_read = chip->cycles;
+					} else if (probe.stage == PROBE_READ && (chip->events & CHIP8_EVENT_DISPLAY)) {
+						probe.stage = PROBE_DRAWN;
+						probe.cycle_draw = chip->cycles;
+						drawn = probe;
+						probe.stage = PROBE_IDLE;
+					}
+					if (chip->events & CHIP8_EVENT_DISPLAY)
+						dirty = true;
+					if (chip->events & (CHIP8_EVENT_BREAKPOINT | CHIP8_EVENT_WATCHPOINT)) {
+						// show the display as it is where we stopped
+						if (dirty) {
+							publish_frame(emu, &back, &drawn);
+							dirty = false;
+						}
+						if (!debugger_stop(chip)) {
+							atomic_store(&emu->running, false);
+							return NULL;
+						}
+						pacer_restart(&emu->pacer);
+					}
+					chip->events = 0;
+					if (dirty && !skip_frames) {
+						publish_frame(emu, &back, &drawn);
+						dirty = false;
+					}
+				}
+
+				budget -= emu->hz ? 1.0 / emu->hz : wait;
+			}
+		}
+		if (chip->timer_delay > 0)
+			chip->timer_delay--;
+		// the buzzer sounds for the next frame whenever the sound timer is still running, fast-forward is silent
+		if (emu->audio && !unthrottled) {
+			if (chip->machine == CHIP8_MACHINE_XOCHIP && chip->timer_sound > 0)
+				audio_push_pattern(chip->pattern, chip->pitch);
+			else
+				audio_push_frame(chip->timer_sound > 0);
+		}
+		if (chip->timer_sound > 0)
+			chip->timer_sound--;
+		if (emu->shm)
+			shm_publish(emu->shm, chip, ++frames);
+		// when skipping, only hand over a frame once the render thread took the previous one
+		if (dirty && !(atomic_load_explicit(&emu->screen.middle, memory_order_relaxed) & TRIPLE_FRESH)) {
+			publish_frame(emu, &back, &drawn);
+			dirty = false;
+		}
+
+		uint64_t drift = 0;
+		if (!unthrottled) {
+			PROFILE_ZONE("sleep");
+			if (was_unthrottled)
+				pacer_restart(&emu->pacer);
+			uint64_t drift_before = emu->pacer.drift_total;
+			pacer_wait(&emu->pacer);
+			drift = emu->pacer.drift_total - drift_before;
+		}
+		was_unthrottled = unthrottled;
+		if (emu->metrics)
+			metrics_emulated(chip->cycles, drift);
+	}
+	return NULL;
+}
+
+/* With --connect the frames come from a chip8-serve instead, see stream.h. They are applied to the
+chip's display, which only holds the frame being put together here, and handed to the render thread
+like emulated ones; keypad changes go back the other way. */
+static void* viewer_thread(void* arg) {
+	struct emulator* emu = arg;
+	chip8* chip = emu->chip;
+	uint8_t back = 0;
+	const struct latency_probe drawn = {0};
+	static uint8_t payload[STREAM_MAX_PAYLOAD];
+	uint8_t keys_message[STREAM_HEADER_SIZE + 2];
+	uint16_t sent_keys = 0;
+	PROFILE_THREAD("viewer");
+	while (atomic_load_explicit(&emu->running, memory_order_relaxed)) {
+		uint16_t keys = atomic_load_explicit(&emu->input, memory_order_relaxed) & 0xFFFFu;
+		if (keys != sent_keys) {
+			if (!stream_send(emu->stream, keys_message, stream_encode_keys(keys, keys_message))) {
+				fprintf(stderr, "The server closed the connection\n");
+				break;
+			}
+			sent_keys = keys;
+		}
+		// wake up at least once a frame to pass keypad changes on
+		struct pollfd pfd = {.fd = emu->stream, .events = POLLIN};
+		int ready = poll(&pfd, 1, 1000 / TIMER_HZ);
+		if (ready < 0 && errno != EINTR) {
+			emu->status = 1;
+			break;
+		}
+		if (ready <= 0)
+			continue;
+		struct stream_header header;
+		if (!stream_receive(emu->stream, &header, payload)) {
+			fprintf(stderr, "The server closed the connection\n");
+			break;
+		}
+		if (header.type == STREAM_KEYS || !stream_apply(&header, payload, chip->display, &chip->hires)) {
+			fprintf(stderr, "Malformed frame from the server\n");
+			emu->status = 1;
+			break;
+		}
+		publish_frame(emu, &back, &drawn);
+	}
+	atomic_store(&emu->running, false);
+	return NULL;
+}
+
+// nearest-rank percentile, values must be sorted
+static uint64_t percentile(const uint64_t* values, size_t count, unsigned p) {
+	size_t rank = (count * p + 99) / 100;
+	return values[rank ? rank - 1 : 0];
+}
+
+static void latency_report(struct latency_stats* stats) {
+	fprintf(stderr, "input-to-photon latency: %zu samples, %zu changes superseded before being presented\n", stats->count, stats->superseded);
+	if (stats->count == 0)
+		return;
+
+	qsort(stats->total_ns, stats->count, sizeof(uint64_t), compare_u64);
+	qsort(stats->read_cycles, stats->count, sizeof(uint64_t), compare_u64);
+	qsort(stats->draw_cycles, stats->count, sizeof(uint64_t), compare_u64);
+	fprintf(stderr, "  total (ms):          p50 %7.2f  p95 %7.2f  p99 %7.2f\n",
+		percentile(stats->total_ns, stats->count, 50) / 1e6,
+		percentile(stats->total_ns, stats->count, 95) / 1e6,
+		percentile(stats->total_ns, stats->count, 99) / 1e6);
+	fprintf(stderr, "  sample->read (cyc):  p50 %7" PRIu64 "  p95 %7" PRIu64 "  p99 %7" PRIu64 "\n",
+		percentile(stats->read_cycles, stats->count, 50),
+		percentile(stats->read_cycles, stats->count, 95),
+		percentile(stats->read_cycles, stats->count, 99));
+	fprintf(stderr, "  read->draw (cyc):    p50 %7" PRIu64 "  p95 %7" PRIu64 "  p99 %7" PRIu64 "\n",
+		percentile(stats->draw_cycles, stats->count, 50),
+		percentile(stats->draw_cycles, stats->count, 95),
+		percentile(stats->draw_cycles, stats->count, 99));
+
+	//***histogram of the total latency, last bucket collects everything above***
+	size_t buckets[LATENCY_BUCKETS] = {0};
+	size_t widest = 0;
+	for (size_t i = 0; i < stats->count; i++) {
+		size_t b = stats->total_ns[i] / (LATENCY_BUCKET_MS * 1000000ull);
+		if (b >= LATENCY_BUCKETS)
+			b = LATENCY_BUCKETS - 1;
+		if (++buckets[b] > widest)
+			widest = buckets[b];
+	}
+	for (size_t b = 0; b < LATENCY_BUCKETS; b++) {
+		if (buckets[b] == 0)
+			continue;
+		int bar = (int)(buckets[b] * 50 / widest);
+		if (b == LATENCY_BUCKETS - 1)
+			fprintf(stderr, "  >=%3zu ms    %6zu %.*s\n", b * LATENCY_BUCKET_MS, buckets[b], bar, "##################################################");
+		else
+			fprintf(stderr, "  %3zu-%3zu ms  %6zu %.*s\n", b * LATENCY_BUCKET_MS, (b + 1) * LATENCY_BUCKET_MS, buckets[b], bar, "##################################################");
+	}
+}
+
 static struct argp argp = {
 	.options = options,
 	.parser = parse_opt,
@@ -93,53 +554,129 @@ int main (int argc, char* argv[]) {
 	arguments.filename = NULL;
 	arguments.fps = 60.0;
 	arguments.hz = 0.0;
+	arguments.speed = 1.0;
+	arguments.latency = false;
+	arguments.pacer_stats = false;
+	arguments.mute = false;
+	arguments.audio_latency = AUDIO_LATENCY_MS;
+	arguments.audio_stats = false;
+	arguments.machine = CHIP8_MACHINE_CHIP8;
+	arguments.machine_set = false;
+	arguments.quirks = NULL;
+	arguments.romdb = NULL;
+	arguments.debug = false;
+	arguments.trace = NULL;
+	arguments.profile = NULL;
+	arguments.metrics = NULL;
+	arguments.metrics_interval = METRICS_INTERVAL;
+	arguments.shm = NULL;
+	arguments.connect = NULL;
 	argp_parse(&argp, argc, argv, 0, 0, &arguments);
 	//arguments.filename = "INVADERS";
 
-	//***open file***
-	FILE* file = fopen(arguments.filename, "rb");
+	struct rom rom = {0};
+	struct romdb db = {0};
+	const struct romdb_entry* rom_entry = NULL;
+	int stream = -1;
+	if (arguments.connect) {
+		stream = stream_connect(arguments.connect);
+		if (stream < 0) {
+			fprintf(stderr, "Could not connect to %s\n", arguments.connect);
+			return 1;
+		}
+	} else {
+		//***map the ROM, the size is checked against the biggest RAM here and the machine's once it is known***
+		rom_status rom_status = rom_open(&rom, arguments.filename, XOCHIP_RAM_SIZE - START_ADDRESS);
+		if (rom_status != ROM_OK) {
+			fprintf(stderr, "File %s %s\n", arguments.filename, rom_status_name(rom_status));
+			return 1;
+		}
 
-	if (!file) {
-		fprintf(stderr, "File %s not found\n", arguments.filename);
-		return 1;
+		//***look the ROM up in the database, the command line still wins***
+		if (romdb_open(&db, arguments.romdb ? arguments.romdb : "romdb.bin")) {
+			rom_entry = romdb_lookup(&db, romdb_hash(rom.data, rom.size));
+		} else if (arguments.romdb) {
+			fprintf(stderr, "Could not load ROM database %s\n", arguments.romdb);
+			return 1;
+		}
+	}
+	if (rom_entry) {
+		if (!arguments.machine_set)
+			arguments.machine = rom_entry->machine;
+		if (arguments.hz == 0.0f && rom_entry->cycles)
+			arguments.hz = (float)rom_entry->cycles * TIMER_HZ;
 	}
-	
-	//***get file size***
-	fseek(file, 0, SEEK_END);
-	long file_size = ftell(file);
-	fseek(file,0,SEEK_SET);
-	if (file_size == -1) {
-		fprintf(stderr, "Could not get file size\n");
-		fclose(file);
+	// window init
+	const int windowWidth = CHIP8_WIDTH * arguments.scale_factor;
+	const int windowHeight = CHIP8_HEIGHT * arguments.scale_factor;
+	InitWindow(windowWidth, windowHeight, "CHIP-8-emu");
+	SetTargetFPS(arguments.fps);
+
+	//shared between the emulation and render threads, too big for the stack once triple buffered
+	struct emulator* emu = calloc(1, sizeof(*emu));
+	if (!emu) {
+		fprintf(stderr,"Could not allocate memory\n");
 		return 1;
 	}
-	
-	//***Read file into a buffer***
-	uint8_t* buffer = malloc(file_size);
-	if (!buffer) {
+	emu->chip = chip8_create(arguments.machine, GetRandomValue(0, 0x7FFFFFFF));
+	if (!emu->chip) {
 		fprintf(stderr,"Could not allocate memory\n");
-		fclose(file);
 		return 1;
 	}
-	long bytes_read = fread(buffer, 1, file_size, file);
-	if (bytes_read != file_size) {
-		if (ferror(file)) {
-			fprintf(stderr, "error reading file\n");
-		}else {
-			fprintf(stderr, "short read: expected %ld bytes, got %zu\n", file_size, bytes_read);
+	emu->stream = stream;
+	//***copy the ROM into the chip-8 ram, a viewer's chip only holds the display it is sent***
+	if (stream < 0 && !chip8_load(emu->chip, rom.data, rom.size)) {
+		fprintf(stderr, "File %s is too big for the %s machine\n", arguments.filename, chip8_machine_name(arguments.machine));
+		return 1;
+	}
+	//we don't need this anymore
+	rom_close(&rom);
+	if (arguments.quirks) {
+		unsigned quirks = emu->chip->quirks;
+		if (!chip8_parse_quirks(arguments.quirks, &quirks)) {
+			fprintf(stderr, "Unknown quirk in '%s'\n", arguments.quirks);
+			return 1;
 		}
-		if (file_size > (4096 - START_ADDRESS)) fprintf(stderr, "File too big to be a chip-8 ROM\n");
-		fclose(file);
+		emu->chip->quirks = quirks;
+	} else if (rom_entry && rom_entry->quirks != ROMDB_QUIRKS_DEFAULT && rom_entry->machine == arguments.machine) {
+		emu->chip->quirks = rom_entry->quirks;
+	}
+	emu->hz = arguments.hz;
+	emu->speed = arguments.speed;
+	// the sound timer stays on the server, a viewer is silent
+	if (!arguments.mute && stream < 0) {
+		emu->audio = audio_init(arguments.audio_latency);
+		if (!emu->audio)
+			fprintf(stderr, "Could not open an audio device, continuing without sound\n");
+	}
+	emu->latency = arguments.latency;
+	emu->trace = arguments.trace != NULL;
+	if (emu->trace && !trace_open(arguments.trace, emu->chip)) {
+		fprintf(stderr, "Could not write trace %s\n", arguments.trace);
 		return 1;
 	}
-	// window init
-	const int windowWidth = CHIP8_WIDTH * arguments.scale_factor;
-	const int windowHeight = CHIP8_HEIGHT * arguments.scale_factor;
-	InitWindow(windowWidth, windowHeight, "CHIP-8-emu");
-	
-	//stack allocation for chip8
-	chip8 chip = {0};
-	chip.pc = START_ADDRESS;
+	emu->debug = arguments.debug;
+	if (emu->debug && !debugger_init(emu->chip, emu->trace ? trace_sink() : NULL)) {
+		fprintf(stderr, "Could not start the debugger\n");
+		return 1;
+	}
+	emu->metrics = arguments.metrics != NULL;
+	if (emu->metrics && !metrics_open(arguments.metrics, arguments.metrics_interval)) {
+		fprintf(stderr, "Could not open metrics destination %s\n", arguments.metrics);
+		return 1;
+	}
+	if (arguments.shm) {
+		emu->shm = shm_create(arguments.shm);
+		if (!emu->shm) {
+			fprintf(stderr, "Could not create shared memory %s\n", arguments.shm);
+			return 1;
+		}
+	}
+	atomic_init(&emu->screen.middle, 1);
+	atomic_init(&emu->input, 0);
+	atomic_init(&emu->running, true);
+	atomic_init(&emu->turbo, false);
+	uint8_t front = 2;
 	// *** Keypad settings ***
 	/* In the original COSMAC VIP, the keypad was set up as a HEX keypad like this:
 	 
@@ -160,380 +697,77 @@ int main (int argc, char* argv[]) {
 									KEY_Q, KEY_W, KEY_E, KEY_A,
 									 KEY_S, KEY_D, KEY_Z, KEY_C, 
 									  KEY_FOUR, KEY_R, KEY_F, KEY_V};
-	//font sprite magic numbers
-	uint8_t fontset[FONTSET_SIZE] =
-	{
-	0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
-	0x20, 0x60, 0x20, 0x20, 0x70, // 1
-	0xF0, 0x10, 0xF0, 0x80, 0xF0, // 2
-	0xF0, 0x10, 0xF0, 0x10, 0xF0, // 3
-	0x90, 0x90, 0xF0, 0x10, 0x10, // 4
-	0xF0, 0x80, 0xF0, 0x10, 0xF0, // 5
-	0xF0, 0x80, 0xF0, 0x90, 0xF0, // 6
-	0xF0, 0x10, 0x20, 0x40, 0x40, // 7
-	0xF0, 0x90, 0xF0, 0x90, 0xF0, // 8
-	0xF0, 0x90, 0xF0, 0x10, 0xF0, // 9
-	0xF0, 0x90, 0xF0, 0x90, 0x90, // A
-	0xE0, 0x90, 0xE0, 0x90, 0xE0, // B
-	0xF0, 0x80, 0x80, 0x80, 0xF0, // C
-	0xE0, 0x90, 0x90, 0x90, 0xE0, // D
-	0xF0, 0x80, 0xF0, 0x80, 0xF0, // E
-	0xF0, 0x80, 0xF0, 0x80, 0x80	// F
-	};
-	for (uint i = 0; i < FONTSET_SIZE; ++i) {
-		chip.ram[FONT_START_ADDRESS + i] = fontset[i];
-	}
-	//***copy buffer into the chip-8 ram***
-	for (long i = 0; i <file_size; ++i) {
-		chip.ram[START_ADDRESS + i] = buffer[i];
+	if (rom_entry) {
+		for (int i = 0; i < 16; i++) {
+			if (rom_entry->keymap[i])
+				keypad[i] = rom_entry->keymap[i];
+		}
 	}
-	//we don't need this anymore 
-	free(buffer);
+	romdb_close(&db);
 
+	//the texture is always hi-res sized, lo-res frames are doubled up when they are unpacked
+	static uint8_t pixels[CHIP8_HIRES_HEIGHT][CHIP8_HIRES_WIDTH];
 	Image screen_image = {
-		.data = &chip.display[0][0],
-		.width = CHIP8_WIDTH,
-		.height = CHIP8_HEIGHT,
+		.data = &pixels[0][0],
+		.width = CHIP8_HIRES_WIDTH,
+		.height = CHIP8_HIRES_HEIGHT,
 		.mipmaps = 1,
 		.format = PIXELFORMAT_UNCOMPRESSED_GRAYSCALE,
 	};	
 	Texture screen_texture = LoadTextureFromImage(screen_image);
-	RenderTexture2D target = LoadRenderTexture(CHIP8_WIDTH, CHIP8_HEIGHT);
-
-
-	struct timespec last_time;
-	clock_gettime(CLOCK_MONOTONIC_RAW, &last_time);
-	struct timespec gfx_clock = last_time;
-	struct timespec cycle_start;
-	struct timespec cycle_end;
-	while (!WindowShouldClose()) {
-		//Load opcode and increment PC to next instruction
-		//since PC points to a single byte of ram, we bitshift to the left by 8 bits and OR it with the next 8 bits to get the full 12bit opcode
-		clock_gettime(CLOCK_MONOTONIC_RAW, &cycle_start);
-		double wait = 0.002;
-		double elapsed = (cycle_start.tv_sec - last_time.tv_sec) + (cycle_start.tv_nsec - last_time.tv_nsec) / 1e9;
-		if (elapsed >= (1.0 /60.0) && chip.timer_delay > 0) {
-			last_time = cycle_start;
-			chip.timer_delay--;
-		}
-		chip.opcode = (chip.ram[chip.pc] << 8u) | chip.ram[chip.pc+1];
-		//printf("chip opcode is %X\n", chip.opcode);
-		chip.pc += 2;
-		// we will also need a random number every cycle
-		uint8_t random = GetRandomValue(0, 255);
-		//*** Emulate each opcode ***
-		switch (chip.opcode & 0xF000u) {
-			case 0x0000u:
-				switch (chip.opcode) {
-					case 0x00E0u:
-					//clear the display
-						memset(chip.display, 0, sizeof(chip.display));
-						wait = 0.000109;
-						break;
-					case 0x00EEu:
-					// return from subroutine
-						if (chip.idx_stack == 0) {
-							fprintf(stderr, "stack underflow\n");
-							return 1;
-						}
-					chip.idx_stack--;
-					chip.pc = chip.stack[chip.idx_stack];
-					wait = 0.000105;
-					break;
-					}
-				break;
-			case 0x1000u: 
-				//this is the JUMP instruction. Jump to the address in the last 3 digits in HEX
-				chip.pc = chip.opcode & 0x0FFFu;
-				wait = 0.000105;
-				break;
-			case 0x2000u:
-				//This is the CALL instruction. Jump to the address indicated and also add a stack frame with a pointer to the previous instruction
-				chip.stack[chip.idx_stack] = chip.pc;
-				chip.idx_stack++;
-				chip.pc = chip.opcode & 0x0FFFu;
-				wait = 0.000105;
-				break;
-			case 0x3000u:
-				//this is the SE Vx, byte instruction. It skips the next instruction if the value in the register specified by the second 4bits is equal to the value in the last 8 bits
-				if (chip.registers[(chip.opcode & 0x0F00u) >> 8u] == (chip.opcode & 0x00FFu))
-					chip.pc += 2;
-				wait = 0.000055;
-				break;
-			case 0x4000u:
-				//this does the opposite of above. It skips if they DO NOT equal
-				if (chip.registers[(chip.opcode & 0x0F00u) >> 8u] != (chip.opcode & 0x00FFu))
-					chip.pc +=2;
-				wait = 0.000055;
-				break;
-			case 0x5000u:
-				//skip if value at register indicated by second 4 bits is equal to value at register indicated by third 4 bits
-				if (chip.registers[(chip.opcode & 0x0F00u) >> 8u] == chip.registers[(chip.opcode & 0x00F0u) >> 4u])
-					chip.pc += 2;
-				wait = 0.000073;
-				break;
-			case 0x6000u:
-				//put the value in the last two bytes into the register indicated by the second 4 bits
-				chip.registers[(chip.opcode & 0x0F00u) >> 8u] = (chip.opcode & 0x00FFu);
-				wait = 0.000027;
-				break;
-			case 0x7000u:
-				//add the value in the last two bytes to the value in the register indicated by the second 4 bits and store the sum in that register
-				chip.registers[(chip.opcode & 0x0F00u) >> 8u] += (chip.opcode & 0x00FFu);
-				wait = 0.000045;
-				break;
-			case 0x8000u:
-				switch (chip.opcode & 0xFu) {
-					// 8xy0
-					// Set Vx = Vy
-					case 0x0u:
-						chip.registers[(chip.opcode & 0x0F00u) >> 8u] = chip.registers[(chip.opcode & 0x00F0u) >> 4u];
-						wait = 0.000200;
-						break;
-					// 8xy1
-					// Set Vx = Vx | Vy
-					case 0x1u:
-						chip.registers[(chip.opcode & 0x0F00u) >> 8u] |= chip.registers[(chip.opcode & 0x00F0u) >> 4u];
-						wait = 0.000200;
-						break;
-					// 8xy2
-					// Set Vx = Vx & Vy
-					case 0x2u:
-						chip.registers[(chip.opcode & 0x0F00u) >> 8u] &= chip.registers[(chip.opcode & 0x00F0u) >> 4u];
-						wait = 0.000200;
-						break;
-					case 0x3u:
-						chip.registers[(chip.opcode & 0x0F00u) >> 8u] ^= chip.registers[(chip.opcode & 0x00F0u) >> 4u];
-						wait = 0.000200;
-						break;
-					case 0x4u:
-						/*Set Vx = Vx + Vy, set VF = carry.
-
-The values of Vx and Vy are added together. If the result is greater than 8 bits (i.e., > 255,) VF is set to 1, otherwise 0. Only the lowest 8 bits of the result are kept, and stored in Vx.
-
-This is an ADD with an overflow flag. If the sum is greater than what can fit into a byte (255), register VF will be set to 1 as a flag.*/
-						{
-						uint8_t Vx = (chip.opcode & 0x0F00u) >> 8u;
-						uint8_t Vy = (chip.opcode & 0x00F0u) >> 4u;
-						uint16_t sum = chip.registers[Vx] + chip.registers[Vy];
-						if (sum > 255)
-							chip.registers[0xF] = 1;
-						else
-							chip.registers[0xF] = 0;
-						chip.registers[Vx] = sum & 0xFFu;
-						}
-						wait = 0.000200;
-						break;
-					case 0x5u:
-						/* Set Vx = Vx - Vy, set VF = NOT borrow.
-
-If Vx > Vy, then VF is set to 1, otherwise 0. Then Vy is subtracted from Vx, and the results stored in Vx. */
-						{
-						uint8_t Vx = (chip.opcode & 0x0F00u) >> 8u;
-						uint8_t Vy = (chip.opcode & 0x00F0u) >> 4u;
-						if (chip.registers[Vx] > chip.registers[Vy])
-							chip.registers[0xF] = 1;
-						else	
-							chip.registers[0xF] = 0;
-						chip.registers[Vx] -= chip.registers[Vy];
-						}
-						wait = 0.000200;
-						break;
-					case 0x6u:
-					/* Set Vx = Vx SHR 1.
-
-If the least-significant bit of Vx is 1, then VF is set to 1, otherwise 0. Then Vx is divided by 2.
-
-A right shift is performed (division by 2), and the least significant bit is saved in Register VF. */
-						{
-						uint8_t Vx = (chip.opcode & 0x0F00u) >> 8u;
-						chip.registers[0xF] = (chip.registers[Vx] & 0x1u);
-						chip.registers[Vx] >>= 1;
-						}
-						wait = 0.000200;
-						break;
-					case 0x7u:
-					/* Set Vx = Vy - Vx, set VF = NOT borrow.
-
-If Vy > Vx, then VF is set to 1, otherwise 0. Then Vx is subtracted from Vy, and the results stored in Vx. */
-						{
-						uint8_t Vx = (chip.opcode & 0x0F00u) >> 8u;
-						uint8_t Vy = (chip.opcode & 0x00F0u) >> 4u;
-						if (chip.registers[Vy] > chip.registers[Vx])
-							chip.registers[0xF] = 1;
-						else
-							chip.registers[0xF] = 0;
-						chip.registers[Vx] = chip.registers[Vy] - chip.registers[Vx];
-						}
-						wait = 0.000200;
-						break;
-					case 0xE:
-						{
-						uint8_t Vx = (chip.opcode & 0x0F00u) >> 8u;
-						chip.registers[0xF] = (chip.registers[Vx] & 0x80u) >> 7u;
-						chip.registers[Vx] <<= 1;
-						}
-						wait = 0.000200;
-						break;
-				}
-				break;
-
-			case 0x9000u:
-				//skip next instruction if register in second 4 bits does not equal register in third 4 bits
-				if (chip.registers[(chip.opcode & 0x0F00u) >> 8u] != chip.registers[(chip.opcode & 0x00F0U) >> 4u])
-					chip.pc += 2;
-				wait = 0.00073;
-				break;
-			case 0xA000u:
-				//set the index register to the value in the last 12bits
-				chip.idx_reg = chip.opcode & 0x0FFFu;
-				wait = 0.000055;
-				break;
-			case 0xB000u:
-				//jump to the address indicated by the last 12 bits + the value in register 0
-				chip.pc = chip.registers[0] + (chip.opcode & 0x0FFFu);
-				wait = 0.000105;
-				break;
-			case 0xC000u:
-				//generate a random number in the range of 0-255 and then AND that with the last byte of the opcode, then store that number in the register indicated by the second 4 bits
-				chip.registers[(chip.opcode & 0x0F00u) >> 8u] = (random & (chip.opcode & 0x00FFu));
-				wait = 0.000164;
-				break;
-			case 0xD000u:
-				//Dxyn
-				//Draw sprite with length n-bytes starting at location determined by registers xy
-				chip.registers[0xF] = 0;
-				uint8_t Vx = (chip.opcode & 0x0F00u) >> 8u;
-				uint8_t Vy = (chip.opcode & 0x00F0u) >> 4u;
-				uint8_t x = chip.registers[Vx] % CHIP8_WIDTH; 
-				uint8_t y = chip.registers[Vy] % CHIP8_HEIGHT;
-				uint8_t height = chip.opcode & 0x000F;
-
-				for (uint row = 0; row < height; row++) {
-					uint8_t sprite = chip.ram[chip.idx_reg + row];
-
-					for (uint8_t column = 0; column < 8; column++) {
-						if ((sprite & (0x80 >> column)) != 0) {
-							uint8_t pixel_x = (x+column) % CHIP8_WIDTH;
-							uint8_t pixel_y = (y+row) % CHIP8_HEIGHT;
-							if (chip.display[pixel_y][pixel_x] == 255)
-								chip.registers[0xF] = 1; //This represents a colision as the sprite was already on
-							chip.display[pixel_y][pixel_x] = chip.display[pixel_y][pixel_x] ? 0:255;
-						}
-					}
-				}
-				wait = 0.001734;
-				break;
-			case 0xE000u:
-				switch (chip.opcode & 0xFF) {
-					case 0x9Eu:
-					// Skip next instruction if key with the value of Vx is pressed.
-						{
-							uint8_t Vx = (chip.opcode & 0x0F00u) >> 8u;
-							uint8_t key = chip.registers[Vx];
-							if (IsKeyDown(keypad[key]))
-			  					chip.pc += 2;
-						}
-						wait = 0.000073;
-						break;
-					case 0xA1u:
-					// Skip if key is not pressed
-						{
-							uint8_t Vx = (chip.opcode & 0x0F00u) >> 8u;
-							uint8_t key = chip.registers[Vx];
-							if (!(IsKeyDown(keypad[key])))
-			  					chip.pc += 2;
-						}
-						wait = 0.000073;
-						break;
-				}
-				break;
-			case 0xF000u:
-				switch (chip.opcode & 0xFF) {
-					case 0x07u:
-						//set Vx = delay timer
-						chip.registers[(chip.opcode & 0x0F00u) >> 8u] = chip.timer_delay;
-						wait = 0.000073;
-						break;
-					case 0x0Au:
-					//Wait for a key press, store the value of the key in Vx.
-						{
-							uint8_t Vx = (chip.opcode & 0x0F00u) >> 8u;
-							bool keyFound = false;
-							for (uint_fast8_t i = 0; i < 16; i++) {
-								if (IsKeyDown(keypad[i])) {
-									chip.registers[Vx] = i;
-									keyFound = true;
-									break;
-								}
-							}
-							if (!keyFound)
-								chip.pc -= 2;
-						} wait = 0.0; break;
-					case 0x15u:
-						// Set delay timer = Vx.
-						{
-							uint8_t Vx = (chip.opcode & 0x0F00u) >> 8u;
-							chip.timer_delay = chip.registers[Vx];
-							wait = 0.000045;
-						} break;
-					case 0x18:
-						chip.timer_sound = chip.registers[(chip.opcode & 0x0F00u) >> 8u];
-						wait = 0.000045;
-						break;
-					case 0x1Eu:
-						// Set I = I + Vx
-						chip.idx_reg += chip.registers[(chip.opcode & 0x0F00u) >> 8u];
-						wait = 0.000086;
-						break;
-					case 0x29u:
-						// Set I = location of sprite for digit Vx
-						{
-						uint8_t Vx = (chip.opcode & 0x0F00u) >> 8u;
-						uint8_t digit = chip.registers[Vx];
-						chip.idx_reg = FONT_START_ADDRESS + (5 * digit);
-						}
-						wait = 0.000096;
-						break;
-					case 0x33u:
-						/* Store BCD representation of Vx in memory locations I, I+1, and I+2.
-						The interpreter takes the decimal value of Vx, and places the hundreds digit in memory at location in I, the tens digit at location I+1, and the ones digit at location I+2. */
-						{
-							uint8_t Vx = (chip.opcode & 0x0F00u) >> 8u;
-							uint8_t value = chip.registers[Vx];
-							chip.ram[chip.idx_reg]     = value / 100;
-							chip.ram[chip.idx_reg + 1] = (value / 10) % 10;
-							chip.ram[chip.idx_reg + 2] = value % 10;
-						} wait = 0.000927; break;
-					case 0x55u:
-						// Store registers V0 through Vx in memory starting at location I
-						{
-							uint8_t Vx = (chip.opcode & 0x0F00u) >> 8u;
-							for (uint8_t i = 0; i <= Vx; ++i) {
-								chip.ram[chip.idx_reg +i] = chip.registers[i];
-							}
-						} wait = 0.000605; break;
-					case 0x65u:
-						// Read registers V0 through Vx from memory starting at location I
-						{
-							uint8_t Vx = (chip.opcode & 0x0F00u) >> 8u;
-							
-							for (uint_fast8_t i =0; i <= Vx; ++i) {
-								chip.registers[i] = chip.ram[chip.idx_reg + i];
-							}
-						} wait = 0.000605; break;
-				}
+	RenderTexture2D target = LoadRenderTexture(CHIP8_HIRES_WIDTH, CHIP8_HIRES_HEIGHT);
+
+	uint16_t keys = 0;
+	uint16_t input_seq = 0;
+	uint64_t t_sample = 0; // when the keypad change with input_seq was sampled
+	bool probe_pending = false;
+	struct latency_stats* latency = NULL;
+	if (arguments.latency) {
+		latency = calloc(1, sizeof(*latency));
+		if (!latency) {
+			fprintf(stderr,"Could not allocate memory\n");
+			return 1;
 		}
+	}
 
+	pthread_t emu_thread;
+	if (pthread_create(&emu_thread, NULL, stream < 0 ? emulation_thread : viewer_thread, emu) != 0) {
+		fprintf(stderr, "Could not start the emulation thread\n");
+		return 1;
+	}
 
-		UpdateTexture(screen_texture, &chip.display[0][0]);
+	bool turbo = false;
+	uint64_t presented_at = now_ns(); // previous EndDrawing(), for the metrics' frame times
+	PROFILE_THREAD("render");
+	while (!WindowShouldClose() && atomic_load_explicit(&emu->running, memory_order_relaxed)) {
+		PROFILE_ZONE("frame");
+		if (IsKeyDown(KEY_TAB) != turbo) {
+			turbo = !turbo;
+			atomic_store_explicit(&emu->turbo, turbo, memory_order_relaxed);
+			SetWindowTitle(turbo ? "CHIP-8-emu (fast-forward)" : "CHIP-8-emu");
+		}
+		uint16_t sampled = sample_keypad(keypad);
+		if (sampled != keys) {
+			keys = sampled;
+			input_seq++;
+			atomic_store_explicit(&emu->input, ((uint32_t)input_seq << 16) | keys, memory_order_relaxed);
+			if (latency) {
+				if (probe_pending)
+					latency->superseded++;
+				probe_pending = true;
+				t_sample = now_ns();
+			}
+		}
 
-		struct timespec now;
-		clock_gettime(CLOCK_MONOTONIC_RAW, &now);
-		double ft = (now.tv_sec - gfx_clock.tv_sec) + (now.tv_nsec - gfx_clock.tv_nsec) / 1e9;
-		if (ft >= (1.0/arguments.fps)) {
-			gfx_clock = now;
+		bool uploaded = triple_acquire(&emu->screen, &front);
+		if (uploaded) {
+			PROFILE_ZONE("UpdateTexture");
+			unpack_frame(&emu->screen.frames[front], pixels);
+			UpdateTexture(screen_texture, &pixels[0][0]);
+		}
 
+		{
+			PROFILE_ZONE("draw");
 			BeginDrawing();
 			BeginTextureMode(target);
 			DrawTexture(screen_texture, 0, 0, WHITE);
@@ -542,20 +776,64 @@ If Vy > Vx, then VF is set to 1, otherwise 0. Then Vx is subtracted from Vy, and
 			DrawTexturePro(
 				target.texture, (Rectangle){0,0, target.texture.width, -target.texture.height}, (Rectangle){0,0,windowWidth,windowHeight},
 				(Vector2){0,0}, 0.0f, WHITE);
+		}
+		{
+			// buffer swap, the --fps limiter's sleep and input polling
+			PROFILE_ZONE("EndDrawing");
 			EndDrawing();
 		}
+		if (emu->metrics) {
+			uint64_t t = now_ns();
+			metrics_presented(t - presented_at, uploaded);
+			presented_at = t;
+		}
 
-		clock_gettime(CLOCK_MONOTONIC_RAW, &cycle_end);
-		if (arguments.hz)
-			wait = (1.0/arguments.hz);
-		WaitTime(wait - ((cycle_end.tv_sec - cycle_start.tv_sec) + (cycle_end.tv_nsec - cycle_start.tv_nsec) / 1e9));
-//		WaitTime(wait);
+		//***the frame holding the probe's display change is now on screen***
+		const struct latency_probe* shown = &emu->screen.frames[front].probe;
+		if (probe_pending && shown->stage == PROBE_DRAWN && shown->seq == input_seq) {
+			if (latency->count < LATENCY_MAX_SAMPLES) {
+				latency->total_ns[latency->count] = now_ns() - t_sample;
+				latency->read_cycles[latency->count] = shown->cycle_read - shown->cycle_sample;
+				latency->draw_cycles[latency->count] = shown->cycle_draw - shown->cycle_read;
+				latency->count++;
+			}
+			probe_pending = false;
 		}
+	}
+	atomic_store(&emu->running, false);
+	if (emu->debug)
+		debugger_release();
+	pthread_join(emu_thread, NULL);
+	int status = emu->status;
+	if (emu->trace)
+		trace_close(stderr);
+	if (emu->metrics)
+		metrics_close();
+	if (emu->shm)
+		shm_destroy(emu->shm, arguments.shm);
+	if (stream >= 0)
+		close(stream);
+#ifdef CHIP8_PROFILE
+	if (arguments.profile && !profile_write(arguments.profile))
+		fprintf(stderr, "Could not write profile %s\n", arguments.profile);
+#endif
+
 	//De-init
+	if (arguments.pacer_stats)
+		pacer_report(&emu->pacer, stderr);
+	if (arguments.audio_stats)
+		audio_report(stderr);
+	audio_close();
+	if (latency) {
+		latency_report(latency);
+		free(latency);
+	}
+	free(emu->chip);
+	free(emu);
 	UnloadRenderTexture(target);
 	UnloadTexture(screen_texture);
 	CloseWindow();
-	return 0;
+	return status;
 	}
 /*MIT License
 Copyright (c) 2025 Eric Hernandez
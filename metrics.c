@@ -0,0 +1,280 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+#include "metrics.h"
+
+#define METRICS_LINE_MAX 1024
+
+struct metrics {
+	// written by the emulation and render threads
+	_Atomic uint64_t cycles;
+	_Atomic uint64_t emulated;
+	_Atomic uint64_t published;
+	_Atomic uint64_t presented;
+	_Atomic uint64_t uploads;
+	_Atomic uint64_t drift_total;
+	_Atomic uint64_t drift_max; // since the last line, reset by the reporter
+	_Atomic uint64_t frame_max;
+	_Atomic uint32_t frame_buckets[METRICS_BUCKETS];
+
+	// reporter only
+	FILE* file;
+	int sock; // -1 when writing to a file or disconnected
+	struct sockaddr_un addr;
+	uint64_t interval_ns;
+	uint64_t start;
+	uint64_t last; // time of the previous line
+	uint64_t prev_cycles, prev_emulated, prev_published, prev_presented, prev_uploads, prev_drift;
+	pthread_t reporter;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	bool stop;
+};
+
+static struct metrics metrics;
+
+void metrics_emulated(uint64_t cycles, uint64_t drift_ns) {
+	atomic_store_explicit(&metrics.cycles, cycles, memory_order_relaxed);
+	atomic_fetch_add_explicit(&metrics.emulated, 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&metrics.drift_total, drift_ns, memory_order_relaxed);
+	// single writer, a maximum landing right as the reporter resets it only moves to the next line
+	if (drift_ns > atomic_load_explicit(&metrics.drift_max, memory_order_relaxed))
+		atomic_store_explicit(&metrics.drift_max, drift_ns, memory_order_relaxed);
+}
+
+void metrics_published(void) {
+	atomic_fetch_add_explicit(&metrics.published, 1, memory_order_relaxed);
+}
+
+void metrics_presented(uint64_t frame_ns, bool uploaded) {
+	atomic_fetch_add_explicit(&metrics.presented, 1, memory_order_relaxed);
+	if (uploaded)
+		atomic_fetch_add_explicit(&metrics.uploads, 1, memory_order_relaxed);
+	uint64_t bucket = frame_ns / (METRICS_BUCKET_US * 1000ull);
+	atomic_fetch_add_explicit(&metrics.frame_buckets[bucket < METRICS_BUCKETS ? bucket : METRICS_BUCKETS - 1], 1, memory_order_relaxed);
+	if (frame_ns > atomic_load_explicit(&metrics.frame_max, memory_order_relaxed))
+		atomic_store_explicit(&metrics.frame_max, frame_ns, memory_order_relaxed);
+}
+
+static uint64_t now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static long rss_kb(void) {
+	FILE* f = fopen("/proc/self/statm", "r");
+	if (!f)
+		return -1;
+	long size, resident;
+	int n = fscanf(f, "%ld %ld", &size, &resident);
+	fclose(f);
+	return n == 2 ? resident * (sysconf(_SC_PAGESIZE) / 1024) : -1;
+}
+
+// upper edge of the bucket holding the p-th percentile, in ms
+static double frame_percentile(const uint32_t* buckets, uint64_t count, unsigned p) {
+	uint64_t rank = (count * p + 99) / 100;
+	uint64_t seen = 0;
+	for (int i = 0; i < METRICS_BUCKETS; i++) {
+		seen += buckets[i];
+		if (seen >= rank)
+			return (i + 1) * METRICS_BUCKET_US / 1000.0;
+	}
+	return METRICS_BUCKETS * METRICS_BUCKET_US / 1000.0;
+}
+
+// non-blocking, so a collector that stops reading never holds up the reporter or metrics_close()
+static bool connect_socket(struct metrics* m) {
+	m->sock = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (m->sock < 0)
+		return false;
+	if (connect(m->sock, (struct sockaddr*)&m->addr, sizeof(m->addr)) != 0) {
+		close(m->sock);
+		m->sock = -1;
+		return false;
+	}
+	return true;
+}
+
+/* A collector that isn't listening, or went away, is retried on the next line, the lines in between
+are lost. So is a line that doesn't fit the socket buffer of a collector that fell behind. */
+static void emit(struct metrics* m, const char* line, size_t length) {
+	if (m->file) {
+		fwrite(line, 1, length, m->file);
+		fflush(m->file);
+		return;
+	}
+	if (m->sock < 0 && !connect_socket(m))
+		return;
+	bool started = false;
+	while (length > 0) {
+		ssize_t sent = send(m->sock, line, length, MSG_NOSIGNAL);
+		if (sent < 0 && errno == EINTR)
+			continue;
+		// a whole line can be dropped, half of one would run into the next
+		if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && !started)
+			return;
+		if (sent <= 0) {
+			close(m->sock);
+			m->sock = -1;
+			return;
+		}
+		started = true;
+		line += sent;
+		length -= sent;
+	}
+}
+
+static void report(struct metrics* m) {
+	uint64_t now = now_ns();
+	struct timespec wall;
+	clock_gettime(CLOCK_REALTIME, &wall);
+	double seconds = (now - m->last) / 1e9;
+	m->last = now;
+
+	uint64_t cycles = atomic_load_explicit(&m->cycles, memory_order_relaxed);
+	uint64_t emulated = atomic_load_explicit(&m->emulated, memory_order_relaxed);
+	uint64_t published = atomic_load_explicit(&m->published, memory_order_relaxed);
+	uint64_t presented = atomic_load_explicit(&m->presented, memory_order_relaxed);
+	uint64_t uploads = atomic_load_explicit(&m->uploads, memory_order_relaxed);
+	uint64_t drift = atomic_load_explicit(&m->drift_total, memory_order_relaxed);
+	uint64_t drift_max = atomic_exchange_explicit(&m->drift_max, 0, memory_order_relaxed);
+	uint64_t frame_max = atomic_exchange_explicit(&m->frame_max, 0, memory_order_relaxed);
+	uint32_t buckets[METRICS_BUCKETS];
+	uint64_t frames = 0;
+	for (int i = 0; i < METRICS_BUCKETS; i++) {
+		buckets[i] = atomic_exchange_explicit(&m->frame_buckets[i], 0, memory_order_relaxed);
+		frames += buckets[i];
+	}
+
+	uint64_t d_emulated = emulated - m->prev_emulated;
+	uint64_t d_published = published - m->prev_published;
+	uint64_t d_uploads = uploads - m->prev_uploads;
+	// published frames the render thread never picked up were replaced by a newer one in the triple buffer
+	uint64_t dropped = d_published > d_uploads ? d_published - d_uploads : 0;
+
+	char line[METRICS_LINE_MAX];
+	int length = snprintf(line, sizeof(line),
+		"{\"time\":%.3f,\"uptime\":%.3f,\"interval\":%.3f,\"ips\":%.0f,\"instructions\":%" PRIu64
+		",\"frames_emulated\":%" PRIu64 ",\"frames_published\":%" PRIu64 ",\"frames_presented\":%" PRIu64
+		",\"frames_dropped\":%" PRIu64 ",\"texture_uploads\":%" PRIu64,
+		wall.tv_sec + wall.tv_nsec / 1e9, (now - m->start) / 1e9, seconds,
+		seconds > 0.0 ? (cycles - m->prev_cycles) / seconds : 0.0, cycles,
+		d_emulated, d_published, presented - m->prev_presented, dropped, d_uploads);
+	if (frames)
+		length += snprintf(line + length, sizeof(line) - length,
+			",\"frame_ms\":{\"p50\":%.2f,\"p95\":%.2f,\"p99\":%.2f,\"max\":%.2f}",
+			frame_percentile(buckets, frames, 50), frame_percentile(buckets, frames, 95),
+			frame_percentile(buckets, frames, 99), frame_max / 1e6);
+	if (d_emulated)
+		length += snprintf(line + length, sizeof(line) - length, ",\"drift_us\":{\"mean\":%.1f,\"max\":%.1f}",
+			(drift - m->prev_drift) / 1e3 / d_emulated, drift_max / 1e3);
+	length += snprintf(line + length, sizeof(line) - length, ",\"rss_kb\":%ld}\n", rss_kb());
+	emit(m, line, (size_t)length);
+
+	m->prev_cycles = cycles;
+	m->prev_emulated = emulated;
+	m->prev_published = published;
+	m->prev_presented = presented;
+	m->prev_uploads = uploads;
+	m->prev_drift = drift;
+}
+
+static void* reporter(void* arg) {
+	struct metrics* m = arg;
+	uint64_t next = m->start + m->interval_ns;
+	pthread_mutex_lock(&m->lock);
+	while (!m->stop) {
+		struct timespec ts = {.tv_sec = next / 1000000000ull, .tv_nsec = next % 1000000000ull};
+		if (pthread_cond_timedwait(&m->wake, &m->lock, &ts) == ETIMEDOUT) {
+			pthread_mutex_unlock(&m->lock);
+			report(m);
+			next += m->interval_ns;
+			pthread_mutex_lock(&m->lock);
+		}
+	}
+	pthread_mutex_unlock(&m->lock);
+	return NULL;
+}
+
+bool metrics_open(const char* dest, double interval) {
+	struct metrics* m = &metrics;
+	m->sock = -1;
+	if (strncmp(dest, "unix:", 5) == 0) {
+		const char* path = dest + 5;
+		if (strlen(path) >= sizeof(m->addr.sun_path))
+			return false;
+		m->addr.sun_family = AF_UNIX;
+		strcpy(m->addr.sun_path, path);
+		// the collector may start later, emit() connects
+	} else {
+		m->file = fopen(dest, "a");
+		if (!m->file)
+			return false;
+	}
+	m->interval_ns = (uint64_t)(interval * 1e9);
+	m->start = m->last = now_ns();
+	// the deadlines are CLOCK_MONOTONIC like now_ns(), not the condition variable's default realtime clock
+	pthread_condattr_t attr;
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&m->wake, &attr);
+	pthread_condattr_destroy(&attr);
+	pthread_mutex_init(&m->lock, NULL);
+	if (pthread_create(&m->reporter, NULL, reporter, m) != 0) {
+		if (m->file)
+			fclose(m->file);
+		return false;
+	}
+	return true;
+}
+
+void metrics_close(void) {
+	struct metrics* m = &metrics;
+	pthread_mutex_lock(&m->lock);
+	m->stop = true;
+	pthread_cond_signal(&m->wake);
+	pthread_mutex_unlock(&m->lock);
+	pthread_join(m->reporter, NULL);
+	report(m);
+	if (m->file)
+		fclose(m->file);
+	else if (m->sock >= 0)
+		close(m->sock);
+	pthread_cond_destroy(&m->wake);
+	pthread_mutex_destroy(&m->lock);
+}
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
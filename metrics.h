@@ -0,0 +1,51 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Periodic JSON-lines metrics, for --metrics.
+The emulation and render threads only add to relaxed atomic counters and a frame time histogram, once
+per frame. A reporter thread turns the differences since its last line into rates and percentiles and
+writes one line per interval, plus a last one on close, to a file or a Unix socket (unix:PATH). */
+#define METRICS_BUCKET_US 250 // frame time histogram resolution
+#define METRICS_BUCKETS 256 // the last bucket also holds every longer frame
+
+// dest is a file appended to, or unix:PATH for a stream socket, connected to once something listens there
+bool metrics_open(const char* dest, double interval);
+// writes the final line and stops the reporter
+void metrics_close(void);
+
+// emulation thread, once per emulated frame: total instructions so far and how late the pacer woke up
+void metrics_emulated(uint64_t cycles, uint64_t drift_ns);
+// emulation thread, a frame was handed to the render thread
+void metrics_published(void);
+// render thread, once per presented frame: time since the previous one and whether a new frame was uploaded
+void metrics_presented(uint64_t frame_ns, bool uploaded);
+
+#endif
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
@@ -5,7 +5,79 @@ int main(int argc, char **argv)
 {
     NOB_GO_REBUILD_URSELF(argc, argv);
     Nob_Cmd cmd = {0};
-    nob_cmd_append(&cmd, "cc", "-Wall", "-Wextra", "-lraylib", "-O3", "-o", "chip-8-emu", "main.c");
+    const char *program = nob_shift(argv, argc);
+    const char *target = argc > 0 ? nob_shift(argv, argc) : "emu";
+    if (strcmp(target, "fuzz") == 0) {
+        // libFuzzer with ASan and UBSan: ./chip8-fuzz corpus/
+        nob_cmd_append(&cmd, "clang", "-g", "-O1", "-fsanitize=fuzzer,address,undefined", "-fno-sanitize-recover=undefined", "-o", "chip8-fuzz", "fuzz.c", "chip8.c");
+        return nob_cmd_run_sync(cmd) ? 0 : 1;
+    }
+    if (strcmp(target, "fuzz-afl") == 0) {
+        // AFL++ persistent mode, AFL_USE_ASAN=1 AFL_USE_UBSAN=1 are set for the sanitizers: afl-fuzz -i seeds -o findings ./chip8-fuzz-afl
+        nob_cmd_append(&cmd, "env", "AFL_USE_ASAN=1", "AFL_USE_UBSAN=1", "afl-clang-fast", "-g", "-O1", "-DCHIP8_FUZZ_MAIN", "-o", "chip8-fuzz-afl", "fuzz.c", "chip8.c");
+        return nob_cmd_run_sync(cmd) ? 0 : 1;
+    }
+    if (strcmp(target, "fuzz-repro") == 0) {
+        // any C compiler, runs the given inputs once under the sanitizers: ./chip8-fuzz-repro crash-...
+        nob_cmd_append(&cmd, "cc", "-g", "-O1", "-fsanitize=address,undefined", "-fno-sanitize-recover=undefined", "-DCHIP8_FUZZ_MAIN", "-o", "chip8-fuzz-repro", "fuzz.c", "chip8.c");
+        return nob_cmd_run_sync(cmd) ? 0 : 1;
+    }
+    if (strcmp(target, "diff") == 0) {
+        // headless lockstep runner: ./chip8-diff roms/*.ch8, or --engine-b batch against the batch core
+        nob_cmd_append(&cmd, "cc", "-Wall", "-Wextra", "-Wno-psabi", "-O2", "-o", "chip8-diff", "diff.c", "chip8.c", "rom.c", "romdb.c", "batch.c", "-lpthread");
+        return nob_cmd_run_sync(cmd) ? 0 : 1;
+    }
+    if (strcmp(target, "bench") == 0) {
+        // headless benchmark, opcode class loops or ROMs: ./chip8-bench --counters [roms/*.ch8]
+        // batch.c passes AVX2 vectors between always inlined helpers, which have no ABI to warn about
+        nob_cmd_append(&cmd, "cc", "-Wall", "-Wextra", "-Wno-psabi", "-O3", "-o", "chip8-bench", "bench.c", "chip8.c", "rom.c", "batch.c");
+        return nob_cmd_run_sync(cmd) ? 0 : 1;
+    }
+    if (strcmp(target, "search") == 0) {
+        // breadth-first state space exploration with deduplication: ./chip8-search -d 12 rom.ch8
+        nob_cmd_append(&cmd, "cc", "-Wall", "-Wextra", "-O3", "-o", "chip8-search", "search.c", "hash.c", "pool.c", "chip8.c", "rom.c", "-lpthread");
+        return nob_cmd_run_sync(cmd) ? 0 : 1;
+    }
+    if (strcmp(target, "serve") == 0) {
+        // headless ROM runner streaming its display to chip-8-emu --connect viewers
+        nob_cmd_append(&cmd, "cc", "-Wall", "-Wextra", "-O3", "-o", "chip8-serve", "serve.c", "stream.c", "chip8.c", "pacer.c", "rom.c", "-lpthread", "-lm");
+        return nob_cmd_run_sync(cmd) ? 0 : 1;
+    }
+    if (strcmp(target, "env") == 0) {
+        // vectorized RL environments as a shared library, for chip8env.py
+        nob_cmd_append(&cmd, "cc", "-Wall", "-Wextra", "-O3", "-fPIC", "-shared", "-o", "libchip8env.so", "env.c", "chip8.c", "-lpthread");
+        return nob_cmd_run_sync(cmd) ? 0 : 1;
+    }
+    if (strcmp(target, "test") == 0) {
+        // the in-tree unit ROMs, then the conformance suite in tests/conformance.txt once its ROMs are in tests/roms/
+        nob_cmd_append(&cmd, "cc", "-Wall", "-Wextra", "-O2", "-o", "chip8-conform", "conform.c", "chip8.c", "rom.c", "romdb.c", "-lpthread");
+        if (!nob_cmd_run_sync_and_reset(&cmd)) return 1;
+        nob_cmd_append(&cmd, "./chip8-conform", "--roms", "tests/unit", "tests/unit.txt");
+        if (!nob_cmd_run_sync_and_reset(&cmd)) return 1;
+        if (!nob_file_exists("tests/roms")) {
+            nob_log(NOB_WARNING, "tests/roms/ not found, skipping the conformance suite");
+            return 0;
+        }
+        nob_cmd_append(&cmd, "./chip8-conform");
+        return nob_cmd_run_sync(cmd) ? 0 : 1;
+    }
+    // the emulator with frame timing zones compiled in, for --profile
+    bool profile = strcmp(target, "profile") == 0;
+    if (strcmp(target, "emu") != 0 && !profile) {
+        nob_log(NOB_ERROR, "usage: %s [emu|profile|fuzz|fuzz-afl|fuzz-repro|diff|test|bench|env|search|serve]", program);
+        return 1;
+    }
+    nob_cmd_append(&cmd, "cc", "-Wall", "-Wextra", "-O3", "-DROMDB_MAIN", "-o", "romdb", "romdb.c", "chip8.c");
+    if (!nob_cmd_run_sync_and_reset(&cmd)) return 1;
+    nob_cmd_append(&cmd, "./romdb", "compile", "romdb.txt", "romdb.bin");
+    if (!nob_cmd_run_sync_and_reset(&cmd)) return 1;
+    nob_cmd_append(&cmd, "cc", "-Wall", "-Wextra", "-O3", "-DTRACE_MAIN", "-o", "chip8-trace", "trace.c", "chip8.c", "-lpthread");
+    if (!nob_cmd_run_sync_and_reset(&cmd)) return 1;
+    nob_cmd_append(&cmd, "cc", "-Wall", "-Wextra", "-O3", "-DSHM_MAIN", "-o", "chip8-shm", "shm.c", "chip8.c");
+    if (!nob_cmd_run_sync_and_reset(&cmd)) return 1;
+    nob_cmd_append(&cmd, "cc", "-Wall", "-Wextra", "-O3");
+    if (profile) nob_cmd_append(&cmd, "-DCHIP8_PROFILE");
+    nob_cmd_append(&cmd, "-o", "chip-8-emu", "main.c", "chip8.c", "pacer.c", "audio.c", "rom.c", "romdb.c", "debugger.c", "trace.c", "profile.c", "metrics.c", "shm.c", "stream.c", "-lraylib", "-lpthread", "-lm");
     if (!nob_cmd_run_sync(cmd)) return 1;
     return 0;
 }
@@ -0,0 +1,106 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <time.h>
+#include "pacer.h"
+
+#define PACER_SLACK_MIN 50000ull // ns
+#define PACER_SLACK_MAX 2000000ull
+#define PACER_SLACK_MARGIN 20000ull
+
+uint64_t pacer_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void pacer_init(struct pacer* pacer, uint64_t period_ns) {
+	*pacer = (struct pacer){0};
+	pacer->period_ns = period_ns;
+	pacer->slack_ns = 1000000ull;
+	pacer->deadline = pacer_now() + period_ns;
+}
+
+void pacer_restart(struct pacer* pacer) {
+	pacer->deadline = pacer_now() + pacer->period_ns;
+}
+
+void pacer_wait(struct pacer* pacer) {
+	uint64_t deadline = pacer->deadline;
+	uint64_t now = pacer_now();
+	pacer->ticks++;
+
+	if (now >= deadline) {
+		pacer->late_ticks++;
+	} else {
+		//***sleep until just before the deadline***
+		if (deadline - now > pacer->slack_ns) {
+			uint64_t wake = deadline - pacer->slack_ns;
+			struct timespec ts = {.tv_sec = wake / 1000000000ull, .tv_nsec = wake % 1000000000ull};
+			while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+			uint64_t woke = pacer_now();
+			pacer->sleep_total += woke - now;
+			now = woke;
+
+			//***calibrate the slack to the OS wake-up latency***
+			uint64_t late = woke > wake ? woke - wake : 0;
+			pacer->wake_late_max -= pacer->wake_late_max / 64;
+			if (late > pacer->wake_late_max)
+				pacer->wake_late_max = late;
+			uint64_t slack = pacer->wake_late_max + PACER_SLACK_MARGIN;
+			pacer->slack_ns = slack < PACER_SLACK_MIN ? PACER_SLACK_MIN : slack > PACER_SLACK_MAX ? PACER_SLACK_MAX : slack;
+		}
+		//***spin the remainder***
+		uint64_t spin_start = now;
+		while (now < deadline)
+			now = pacer_now();
+		pacer->spin_total += now - spin_start;
+	}
+
+	uint64_t drift = now - deadline;
+	pacer->drift_total += drift;
+	if (drift > pacer->drift_max)
+		pacer->drift_max = drift;
+
+	if (drift > pacer->period_ns) {
+		pacer->resyncs++;
+		pacer->deadline = now + pacer->period_ns;
+	} else {
+		pacer->deadline = deadline + pacer->period_ns;
+	}
+}
+
+void pacer_report(const struct pacer* pacer, FILE* out) {
+	if (pacer->ticks == 0)
+		return;
+	fprintf(out, "pacer: %" PRIu64 " ticks of %.3f ms, %" PRIu64 " late, %" PRIu64 " resyncs\n",
+		pacer->ticks, pacer->period_ns / 1e6, pacer->late_ticks, pacer->resyncs);
+	fprintf(out, "  drift: mean %.1f us  max %.1f us\n",
+		pacer->drift_total / 1e3 / pacer->ticks, pacer->drift_max / 1e3);
+	fprintf(out, "  slept %.1f ms  spun %.1f ms  slack now %.1f us\n",
+		pacer->sleep_total / 1e6, pacer->spin_total / 1e6, pacer->slack_ns / 1e3);
+}
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
@@ -0,0 +1,60 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+#ifndef PACER_H
+#define PACER_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/* Fixed rate pacer on absolute CLOCK_MONOTONIC deadlines.
+Each wait sleeps with clock_nanosleep(TIMER_ABSTIME) until slightly before the deadline and spins the
+rest, so sleeping errors never accumulate. The spin window (slack) follows how late the OS actually
+wakes us up. When we fall more than a full period behind, the schedule is restarted from now instead
+of bursting to catch up. */
+struct pacer {
+	uint64_t period_ns;
+	uint64_t deadline; // absolute CLOCK_MONOTONIC time of the next tick, ns
+	uint64_t slack_ns; // wake up this early and spin the rest
+	uint64_t wake_late_max; // decaying maximum of how late clock_nanosleep() returned
+	// statistics
+	uint64_t ticks;
+	uint64_t late_ticks; // deadline already passed when we got to wait for it
+	uint64_t resyncs;
+	uint64_t drift_total; // how far past the deadline wait returned, summed
+	uint64_t drift_max;
+	uint64_t spin_total;
+	uint64_t sleep_total;
+};
+
+uint64_t pacer_now(void);
+void pacer_init(struct pacer* pacer, uint64_t period_ns);
+// start the schedule over from now, e.g. after running unthrottled for a while
+void pacer_restart(struct pacer* pacer);
+// wait for the next tick
+void pacer_wait(struct pacer* pacer);
+void pacer_report(const struct pacer* pacer, FILE* out);
+
+#endif
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
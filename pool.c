@@ -0,0 +1,132 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pool.h"
+
+#define POOL_ALIGN 64 // blocks start on a cache line
+#define POOL_SLAB_BLOCKS 64 // blocks carved from each allocation
+
+struct pool_slab {
+	struct pool_slab* next;
+	uint8_t* blocks;
+};
+
+struct chip8_pool {
+	chip8* image; // the base machine, as loaded
+	size_t block_size;
+	unsigned dirty_words; // words of chip8.dirty the machine's RAM covers
+	size_t display_bytes; // bytes of display the machine can draw into
+	chip8* free_list; // linked through the first pointer's worth of each block
+	struct pool_slab* slabs;
+};
+
+chip8_pool* chip8_pool_create(const chip8* base) {
+	chip8_pool* pool = calloc(1, sizeof(*pool));
+	if (!pool)
+		return NULL;
+	size_t size = chip8_size(base->machine);
+	pool->block_size = (size + POOL_ALIGN - 1) / POOL_ALIGN * POOL_ALIGN;
+	pool->image = aligned_alloc(POOL_ALIGN, pool->block_size);
+	if (!pool->image) {
+		free(pool);
+		return NULL;
+	}
+	memcpy(pool->image, base, size);
+	pool->dirty_words = (base->ram_size / CHIP8_DIRTY_BLOCK + 63) / 64;
+	// CHIP-8 stays in lo-res, which only uses the left word of the first CHIP8_HEIGHT rows
+	if (base->machine == CHIP8_MACHINE_XOCHIP)
+		pool->display_bytes = sizeof(base->display);
+	else if (base->machine == CHIP8_MACHINE_SCHIP)
+		pool->display_bytes = sizeof(base->display[0]);
+	else
+		pool->display_bytes = CHIP8_HEIGHT * sizeof(base->display[0][0]);
+	return pool;
+}
+
+void chip8_pool_free(chip8_pool* pool) {
+	if (!pool)
+		return;
+	for (struct pool_slab* slab = pool->slabs; slab;) {
+		struct pool_slab* next = slab->next;
+		free(slab->blocks);
+		free(slab);
+		slab = next;
+	}
+	free(pool->image);
+	free(pool);
+}
+
+// a slab's worth of blocks onto the free list, each a copy of the image so that only dirty blocks ever differ
+static bool grow(chip8_pool* pool) {
+	struct pool_slab* slab = malloc(sizeof(*slab));
+	if (!slab)
+		return false;
+	slab->blocks = aligned_alloc(POOL_ALIGN, POOL_SLAB_BLOCKS * pool->block_size);
+	if (!slab->blocks) {
+		free(slab);
+		return false;
+	}
+	slab->next = pool->slabs;
+	pool->slabs = slab;
+	for (unsigned b = 0; b < POOL_SLAB_BLOCKS; b++) {
+		chip8* chip = (chip8*)(slab->blocks + b * pool->block_size);
+		memcpy(chip, pool->image, pool->block_size);
+		chip8_release(pool, chip);
+	}
+	return true;
+}
+
+chip8* chip8_clone(chip8_pool* pool, const chip8* src) {
+	if (!pool->free_list && !grow(pool))
+		return NULL;
+	chip8* chip = pool->free_list;
+	memcpy(&pool->free_list, chip, sizeof(chip8*));
+
+	/* The block still holds whichever machine used it last, which differs from the image in its own
+	dirty blocks only: those and src's are copied, from src where src wrote and from the image elsewhere. */
+	const uint8_t* image = pool->image->ram;
+	for (unsigned w = 0; w < pool->dirty_words; w++) {
+		uint64_t stale = chip->dirty[w] | src->dirty[w];
+		while (stale) {
+			unsigned bit = __builtin_ctzll(stale);
+			stale &= stale - 1;
+			size_t offset = (w * 64 + bit) * CHIP8_DIRTY_BLOCK;
+			const uint8_t* from = (src->dirty[w] >> bit) & 1u ? src->ram : image;
+			memcpy(chip->ram + offset, from + offset, CHIP8_DIRTY_BLOCK);
+		}
+	}
+	memcpy(chip->dirty, src->dirty, pool->dirty_words * sizeof(chip->dirty[0]));
+	memcpy(chip, src, offsetof(chip8, display));
+	memcpy(chip->display, src->display, pool->display_bytes);
+	return chip;
+}
+
+void chip8_release(chip8_pool* pool, chip8* chip) {
+	memcpy(chip, &pool->free_list, sizeof(chip8*));
+	pool->free_list = chip;
+}
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
@@ -0,0 +1,51 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+#ifndef POOL_H
+#define POOL_H
+
+#include "chip8.h"
+
+/* Cheap copies of a machine for tree search, where every node forks the state of its parent.
+A pool hands out cache line aligned blocks for one machine type, carved from slabs and recycled
+through a free list, so a fork never reaches malloc(). Every machine of a pool descends from the
+same loaded ROM, kept as the pool's image: RAM outside a machine's dirty blocks (see chip8.dirty)
+still matches it, so a clone copies the registers, the display planes the machine can use and
+only the RAM blocks that either side has written since the ROM was loaded.
+
+A pool isn't thread safe, give each search thread its own. */
+typedef struct chip8_pool chip8_pool;
+
+/* A pool for clones of base and of its descendants, base being a machine right after chip8_init()
+and chip8_load(), which is copied. NULL when out of memory. */
+chip8_pool* chip8_pool_create(const chip8* base);
+// frees every machine the pool handed out along with it
+void chip8_pool_free(chip8_pool* pool);
+// a copy of src, which must descend from the pool's base. NULL when out of memory
+chip8* chip8_clone(chip8_pool* pool, const chip8* src);
+// returns a clone to the pool
+void chip8_release(chip8_pool* pool, chip8* chip);
+
+#endif
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
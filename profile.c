@@ -0,0 +1,145 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+#ifdef CHIP8_PROFILE
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+#include "profile.h"
+
+struct profile_event {
+	const char* name;
+	uint64_t begin;
+	uint64_t end;
+};
+
+/* Each thread appends to its own buffer without any locking; the mutex only guards the list of buffers,
+which grows once per thread on its first zone. */
+struct profile_buffer {
+	struct profile_buffer* next;
+	const char* thread;
+	unsigned tid;
+	size_t count;
+	size_t dropped;
+	struct profile_event events[PROFILE_MAX_EVENTS];
+};
+
+static pthread_mutex_t buffers_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct profile_buffer* buffers;
+static unsigned next_tid = 1;
+static _Thread_local struct profile_buffer* local;
+
+static uint64_t now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static struct profile_buffer* buffer(void) {
+	if (local)
+		return local;
+	struct profile_buffer* b = calloc(1, sizeof(*b));
+	if (!b)
+		return NULL;
+	pthread_mutex_lock(&buffers_lock);
+	b->tid = next_tid++;
+	b->next = buffers;
+	buffers = b;
+	pthread_mutex_unlock(&buffers_lock);
+	local = b;
+	return b;
+}
+
+void profile_thread(const char* name) {
+	struct profile_buffer* b = buffer();
+	if (b)
+		b->thread = name;
+}
+
+uint64_t profile_begin(void) {
+	return now_ns();
+}
+
+void profile_end(struct profile_zone* zone) {
+	uint64_t end = now_ns();
+	struct profile_buffer* b = buffer();
+	if (!b)
+		return;
+	if (b->count == PROFILE_MAX_EVENTS) {
+		b->dropped++;
+		return;
+	}
+	b->events[b->count++] = (struct profile_event){zone->name, zone->begin, end};
+}
+
+// trace-event timestamps are in microseconds, relative to the first zone keeps them readable
+static void write_us(FILE* f, uint64_t ns) {
+	fprintf(f, "%llu.%03u", (unsigned long long)(ns / 1000), (unsigned)(ns % 1000));
+}
+
+bool profile_write(const char* path) {
+	FILE* f = fopen(path, "w");
+	if (!f)
+		return false;
+	pthread_mutex_lock(&buffers_lock);
+	uint64_t epoch = UINT64_MAX;
+	// zones are stored as they end, so an outer zone comes after the ones it encloses
+	for (struct profile_buffer* b = buffers; b; b = b->next) {
+		for (size_t i = 0; i < b->count; i++) {
+			if (b->events[i].begin < epoch)
+				epoch = b->events[i].begin;
+		}
+	}
+	fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", f);
+	fputs("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"CHIP-8-emu\"}}", f);
+	for (struct profile_buffer* b = buffers; b; b = b->next) {
+		if (b->thread)
+			fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", b->tid, b->thread);
+		// complete events, the viewer nests them by time so inner zones need no extra bookkeeping
+		for (size_t i = 0; i < b->count; i++) {
+			const struct profile_event* e = &b->events[i];
+			fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":", e->name, b->tid);
+			write_us(f, e->begin - epoch);
+			fputs(",\"dur\":", f);
+			write_us(f, e->end - e->begin);
+			fputc('}', f);
+		}
+		if (b->dropped)
+			fprintf(stderr, "profile: %zu zones dropped on thread %s, buffer full\n", b->dropped, b->thread ? b->thread : "?");
+	}
+	fputs("\n]}\n", f);
+	while (buffers) {
+		struct profile_buffer* next = buffers->next;
+		free(buffers);
+		buffers = next;
+	}
+	local = NULL;
+	pthread_mutex_unlock(&buffers_lock);
+	return fclose(f) == 0;
+}
+
+#endif
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
@@ -0,0 +1,67 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Frame timing zones, for --profile.
+A zone is a scope whose start and end times are appended to a buffer owned by the calling thread, and
+profile_write() exports all of them as Chrome trace-event JSON for chrome://tracing or ui.perfetto.dev.
+Zones only exist in builds with -DCHIP8_PROFILE (./nob profile); otherwise the macros expand to nothing
+and the profile functions are never called. */
+#define PROFILE_MAX_EVENTS (1u << 18) // per thread, later zones are dropped and counted
+
+#ifdef CHIP8_PROFILE
+
+struct profile_zone {
+	const char* name;
+	uint64_t begin;
+};
+
+// name the calling thread in the exported trace
+void profile_thread(const char* name);
+uint64_t profile_begin(void);
+void profile_end(struct profile_zone* zone);
+// export every thread's zones, call once the other threads are done
+bool profile_write(const char* path);
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+// times the rest of the enclosing scope, early returns included
+#define PROFILE_ZONE(name) \
+	struct profile_zone PROFILE_CONCAT(profile_zone_, __LINE__) __attribute__((cleanup(profile_end))) = {(name), profile_begin()}
+#define PROFILE_THREAD(name) profile_thread(name)
+
+#else
+
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+
+#endif
+
+#endif
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
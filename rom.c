@@ -0,0 +1,198 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "chip8.h"
+#include "rom.h"
+
+#define TAR_BLOCK 512
+
+// pipes can't be mapped, they are read here. Never bigger than the biggest RAM, so no allocation
+static uint8_t pipe_buffer[XOCHIP_RAM_SIZE];
+
+static rom_status map_fd(struct rom* rom, int fd, size_t size) {
+	void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (map == MAP_FAILED)
+		return ROM_READ_ERROR;
+	rom->map = map;
+	rom->map_size = size;
+	rom->data = map;
+	rom->size = size;
+	return ROM_OK;
+}
+
+static rom_status read_pipe(struct rom* rom, int fd, size_t max_size) {
+	if (max_size > sizeof(pipe_buffer) - 1)
+		max_size = sizeof(pipe_buffer) - 1;
+	size_t size = 0;
+	// one byte past max_size tells an oversized ROM apart from one that fits exactly
+	while (size <= max_size) {
+		ssize_t n = read(fd, pipe_buffer + size, max_size + 1 - size);
+		if (n == 0)
+			break;
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return ROM_READ_ERROR;
+		}
+		size += n;
+	}
+	if (size > max_size)
+		return ROM_TOO_BIG;
+	rom->data = pipe_buffer;
+	rom->size = size;
+	return ROM_OK;
+}
+
+static rom_status open_fd(struct rom* rom, int fd, size_t max_size) {
+	struct stat st;
+	if (fstat(fd, &st) == -1)
+		return ROM_READ_ERROR;
+	if (!S_ISREG(st.st_mode))
+		return read_pipe(rom, fd, max_size);
+	if ((size_t)st.st_size > max_size)
+		return ROM_TOO_BIG;
+	if (st.st_size == 0)
+		return ROM_OK; // mmap refuses empty files, rom_open reports them
+	return map_fd(rom, fd, st.st_size);
+}
+
+static size_t tar_octal(const char* field, size_t len) {
+	size_t value = 0;
+	for (size_t i = 0; i < len && field[i] >= '0' && field[i] <= '7'; i++)
+		value = value * 8 + (field[i] - '0');
+	return value;
+}
+
+// ustar member lookup, the member name may carry the prefix field ("dir/name")
+static rom_status tar_find(struct rom* rom, const char* member, size_t max_size) {
+	const uint8_t* archive = rom->map;
+	size_t offset = 0;
+	while (offset + TAR_BLOCK <= rom->map_size) {
+		const char* header = (const char*)archive + offset;
+		if (header[0] == '\0')
+			return ROM_NOT_IN_ARCHIVE; // end of archive marker
+		if (memcmp(header + 257, "ustar", 5) != 0)
+			return ROM_BAD_ARCHIVE;
+		size_t size = tar_octal(header + 124, 12);
+		size_t data = offset + TAR_BLOCK;
+		if (size > rom->map_size - data)
+			return ROM_BAD_ARCHIVE;
+
+		char name[256 + 1];
+		if (header[345])
+			snprintf(name, sizeof(name), "%.155s/%.100s", header + 345, header);
+		else
+			snprintf(name, sizeof(name), "%.100s", header);
+		char type = header[156];
+		if ((type == '0' || type == '\0') && strcmp(name, member) == 0) {
+			if (size > max_size)
+				return ROM_TOO_BIG;
+			rom->data = archive + data;
+			rom->size = size;
+			return ROM_OK;
+		}
+		offset = data + (size + TAR_BLOCK - 1) / TAR_BLOCK * TAR_BLOCK;
+	}
+	return ROM_NOT_IN_ARCHIVE;
+}
+
+static rom_status open_archive(struct rom* rom, const char* path, size_t max_size) {
+	const char* colon = strrchr(path, ':');
+	if (!colon || colon == path || !colon[1])
+		return ROM_NOT_FOUND;
+	char archive[4096];
+	size_t len = colon - path;
+	if (len >= sizeof(archive))
+		return ROM_NOT_FOUND;
+	memcpy(archive, path, len);
+	archive[len] = '\0';
+
+	int fd = open(archive, O_RDONLY);
+	if (fd == -1)
+		return ROM_NOT_FOUND;
+	struct stat st;
+	rom_status status = ROM_BAD_ARCHIVE;
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size >= TAR_BLOCK)
+		status = map_fd(rom, fd, st.st_size);
+	close(fd);
+	if (status != ROM_OK)
+		return status;
+	return tar_find(rom, colon + 1, max_size);
+}
+
+rom_status rom_open(struct rom* rom, const char* path, size_t max_size) {
+	*rom = (struct rom){0};
+	rom_status status;
+	if (strcmp(path, "-") == 0) {
+		status = open_fd(rom, STDIN_FILENO, max_size);
+	} else {
+		int fd = open(path, O_RDONLY);
+		if (fd != -1) {
+			status = open_fd(rom, fd, max_size);
+			close(fd);
+		} else {
+			status = errno == ENOENT ? open_archive(rom, path, max_size) : ROM_READ_ERROR;
+		}
+	}
+	if (status == ROM_OK && rom->size == 0)
+		status = ROM_EMPTY;
+	if (status != ROM_OK)
+		rom_close(rom);
+	return status;
+}
+
+void rom_close(struct rom* rom) {
+	if (rom->map)
+		munmap(rom->map, rom->map_size);
+	*rom = (struct rom){0};
+}
+
+const char* rom_status_name(rom_status status) {
+	switch (status) {
+		case ROM_OK:
+			return "ok";
+		case ROM_NOT_FOUND:
+			return "not found";
+		case ROM_READ_ERROR:
+			return "could not be read";
+		case ROM_EMPTY:
+			return "is empty";
+		case ROM_TOO_BIG:
+			return "is too big to be a chip-8 ROM";
+		case ROM_BAD_ARCHIVE:
+			return "is not a valid tar archive";
+		case ROM_NOT_IN_ARCHIVE:
+			return "is not in the archive";
+	}
+	return "unknown error";
+}
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
@@ -0,0 +1,58 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+#ifndef ROM_H
+#define ROM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* ROM images, read only and without copies where possible.
+Regular files are mapped, "-" reads stdin (mapped too when it is redirected from a file) and
+"ARCHIVE.tar:MEMBER" points straight into the mapped tar archive, since tar stores members
+uncompressed and contiguous. */
+typedef enum {
+	ROM_OK,
+	ROM_NOT_FOUND,
+	ROM_READ_ERROR,
+	ROM_EMPTY,
+	ROM_TOO_BIG,
+	ROM_BAD_ARCHIVE,
+	ROM_NOT_IN_ARCHIVE,
+} rom_status;
+
+struct rom {
+	const uint8_t* data;
+	size_t size;
+	void* map; // whole file mapping, data may point into the middle of it
+	size_t map_size;
+};
+
+// the size is checked against max_size before anything is mapped or read
+rom_status rom_open(struct rom* rom, const char* path, size_t max_size);
+void rom_close(struct rom* rom);
+const char* rom_status_name(rom_status status);
+
+#endif
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
@@ -0,0 +1,321 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "chip8.h"
+#include "romdb.h"
+
+//***XXH64***
+#define XXH_PRIME64_1 0x9E3779B185EBCA87ull
+#define XXH_PRIME64_2 0xC2B2AE3D27D4EB4Full
+#define XXH_PRIME64_3 0x165667B19E3779F9ull
+#define XXH_PRIME64_4 0x85EBCA77C2B2AE63ull
+#define XXH_PRIME64_5 0x27D4EB2F165667C5ull
+
+static inline uint64_t rotl64(uint64_t value, unsigned amount) {
+	return (value << amount) | (value >> (64 - amount));
+}
+
+static inline uint64_t read64(const uint8_t* p) {
+	uint64_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static inline uint32_t read32(const uint8_t* p) {
+	uint32_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static inline uint64_t xxh64_round(uint64_t acc, uint64_t input) {
+	acc += input * XXH_PRIME64_2;
+	return rotl64(acc, 31) * XXH_PRIME64_1;
+}
+
+static inline uint64_t xxh64_merge(uint64_t acc, uint64_t value) {
+	acc ^= xxh64_round(0, value);
+	return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+// XXH64 reads the input as little endian words, this assumes a little endian host
+uint64_t romdb_hash(const void* data, size_t len) {
+	const uint8_t* p = data;
+	const uint8_t* end = p + len;
+	uint64_t h;
+
+	if (len >= 32) {
+		uint64_t v1 = XXH_PRIME64_1 + XXH_PRIME64_2;
+		uint64_t v2 = XXH_PRIME64_2;
+		uint64_t v3 = 0;
+		uint64_t v4 = -XXH_PRIME64_1;
+		do {
+			v1 = xxh64_round(v1, read64(p));
+			v2 = xxh64_round(v2, read64(p + 8));
+			v3 = xxh64_round(v3, read64(p + 16));
+			v4 = xxh64_round(v4, read64(p + 24));
+			p += 32;
+		} while (end - p >= 32);
+		h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+		h = xxh64_merge(h, v1);
+		h = xxh64_merge(h, v2);
+		h = xxh64_merge(h, v3);
+		h = xxh64_merge(h, v4);
+	} else {
+		h = XXH_PRIME64_5;
+	}
+	h += len;
+
+	for (; end - p >= 8; p += 8) {
+		h ^= xxh64_round(0, read64(p));
+		h = rotl64(h, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+	}
+	if (end - p >= 4) {
+		h ^= (uint64_t)read32(p) * XXH_PRIME64_1;
+		h = rotl64(h, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+		p += 4;
+	}
+	for (; p < end; p++) {
+		h ^= *p * XXH_PRIME64_5;
+		h = rotl64(h, 11) * XXH_PRIME64_1;
+	}
+
+	h ^= h >> 33;
+	h *= XXH_PRIME64_2;
+	h ^= h >> 29;
+	h *= XXH_PRIME64_3;
+	h ^= h >> 32;
+	return h;
+}
+
+//***binary index***
+bool romdb_open(struct romdb* db, const char* path) {
+	*db = (struct romdb){0};
+	int fd = open(path, O_RDONLY);
+	if (fd == -1)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(struct romdb_header)) {
+		close(fd);
+		return false;
+	}
+	void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return false;
+
+	const struct romdb_header* header = map;
+	if (header->magic != ROMDB_MAGIC || header->version != ROMDB_VERSION
+		|| header->entry_size != sizeof(struct romdb_entry)
+		|| (size_t)st.st_size != sizeof(*header) + (size_t)header->count * sizeof(struct romdb_entry)) {
+		munmap(map, st.st_size);
+		return false;
+	}
+	db->map = map;
+	db->size = st.st_size;
+	db->entries = (const struct romdb_entry*)(header + 1);
+	db->count = header->count;
+	return true;
+}
+
+const struct romdb_entry* romdb_lookup(const struct romdb* db, uint64_t hash) {
+	size_t lo = 0, hi = db->count;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		uint64_t key = db->entries[mid].hash;
+		if (key == hash)
+			return &db->entries[mid];
+		if (key < hash)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return NULL;
+}
+
+void romdb_close(struct romdb* db) {
+	if (db->map)
+		munmap((void*)db->map, db->size);
+	*db = (struct romdb){0};
+}
+
+//***text source***
+static int compare_entries(const void* a, const void* b) {
+	uint64_t x = ((const struct romdb_entry*)a)->hash;
+	uint64_t y = ((const struct romdb_entry*)b)->hash;
+	return (x > y) - (x < y);
+}
+
+static bool parse_keymap(const char* field, char keymap[16]) {
+	memset(keymap, 0, 16);
+	if (strcmp(field, "-") == 0)
+		return true;
+	if (strlen(field) != 16)
+		return false;
+	for (int i = 0; i < 16; i++) {
+		char c = toupper((unsigned char)field[i]);
+		if (c == '.')
+			continue;
+		if (!isalnum((unsigned char)c))
+			return false;
+		keymap[i] = c; // raylib key codes for letters and digits are their ASCII values
+	}
+	return true;
+}
+
+// hash machine quirks cycles keymap [title...]
+static bool parse_line(char* line, struct romdb_entry* entry) {
+	char* fields[5];
+	char* save = NULL;
+	for (int i = 0; i < 5; i++) {
+		fields[i] = strtok_r(i == 0 ? line : NULL, " \t", &save);
+		if (!fields[i])
+			return false;
+	}
+	*entry = (struct romdb_entry){0};
+
+	char* end;
+	entry->hash = strtoull(fields[0], &end, 16);
+	if (*end || end - fields[0] != 16)
+		return false;
+
+	chip8_machine machine;
+	if (!chip8_parse_machine(fields[1], &machine))
+		return false;
+	entry->machine = machine;
+
+	entry->quirks = ROMDB_QUIRKS_DEFAULT;
+	if (strcmp(fields[2], "-") != 0) {
+		unsigned quirks = chip8_default_quirks(machine);
+		if (!chip8_parse_quirks(fields[2], &quirks))
+			return false;
+		entry->quirks = quirks;
+	}
+
+	if (strcmp(fields[3], "-") != 0) {
+		unsigned long cycles = strtoul(fields[3], &end, 10);
+		if (*end || cycles == 0 || cycles > UINT16_MAX)
+			return false;
+		entry->cycles = cycles;
+	}
+
+	return parse_keymap(fields[4], entry->keymap);
+}
+
+bool romdb_compile(const char* source, const char* output) {
+	FILE* in = fopen(source, "r");
+	if (!in) {
+		fprintf(stderr, "Could not open %s\n", source);
+		return false;
+	}
+	struct romdb_entry* entries = NULL;
+	size_t count = 0, capacity = 0;
+	char line[1024];
+	unsigned line_no = 0;
+	bool ok = true;
+	while (fgets(line, sizeof(line), in)) {
+		line_no++;
+		line[strcspn(line, "#\r\n")] = '\0';
+		if (line[strspn(line, " \t")] == '\0')
+			continue;
+		if (count == capacity) {
+			capacity = capacity ? capacity * 2 : 256;
+			struct romdb_entry* grown = realloc(entries, capacity * sizeof(*entries));
+			if (!grown) {
+				fprintf(stderr, "Could not allocate memory\n");
+				ok = false;
+				break;
+			}
+			entries = grown;
+		}
+		if (!parse_line(line, &entries[count])) {
+			fprintf(stderr, "%s:%u: malformed entry\n", source, line_no);
+			ok = false;
+			continue;
+		}
+		count++;
+	}
+	fclose(in);
+
+	if (ok) {
+		qsort(entries, count, sizeof(*entries), compare_entries);
+		for (size_t i = 1; i < count; i++) {
+			if (entries[i].hash == entries[i - 1].hash) {
+				fprintf(stderr, "%s: duplicate hash %016" PRIx64 "\n", source, entries[i].hash);
+				ok = false;
+			}
+		}
+	}
+	if (ok) {
+		FILE* out = fopen(output, "wb");
+		struct romdb_header header = {
+			.magic = ROMDB_MAGIC,
+			.version = ROMDB_VERSION,
+			.count = count,
+			.entry_size = sizeof(struct romdb_entry),
+		};
+		if (!out || fwrite(&header, sizeof(header), 1, out) != 1
+			|| fwrite(entries, sizeof(*entries), count, out) != count) {
+			fprintf(stderr, "Could not write %s\n", output);
+			ok = false;
+		}
+		if (out && fclose(out) != 0)
+			ok = false;
+	}
+	free(entries);
+	return ok;
+}
+
+#ifdef ROMDB_MAIN
+// the build runs this to generate the index, it also prints hashes ready to paste into romdb.txt
+int main(int argc, char** argv) {
+	if (argc == 4 && strcmp(argv[1], "compile") == 0)
+		return romdb_compile(argv[2], argv[3]) ? 0 : 1;
+	if (argc >= 3 && strcmp(argv[1], "hash") == 0) {
+		for (int i = 2; i < argc; i++) {
+			FILE* file = fopen(argv[i], "rb");
+			if (!file) {
+				fprintf(stderr, "File %s not found\n", argv[i]);
+				return 1;
+			}
+			static uint8_t buffer[XOCHIP_RAM_SIZE];
+			size_t len = fread(buffer, 1, sizeof(buffer), file);
+			fclose(file);
+			printf("%016" PRIx64 "  chip8  -  -  -  # %s\n", romdb_hash(buffer, len), argv[i]);
+		}
+		return 0;
+	}
+	fprintf(stderr, "usage: romdb compile SOURCE INDEX\n       romdb hash FILE...\n");
+	return 1;
+}
+#endif
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
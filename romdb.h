@@ -0,0 +1,72 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+#ifndef ROMDB_H
+#define ROMDB_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* ROM database: per ROM settings keyed by the XXH64 hash of the ROM file.
+The text source (romdb.txt) is compiled into a flat binary index of fixed size entries sorted by
+hash, which is mapped read only and binary searched at startup. The index is written in host byte
+order, it is a build artifact and not meant to be copied between machines. */
+#define ROMDB_MAGIC 0x42443843u // "C8DB"
+#define ROMDB_VERSION 1
+#define ROMDB_QUIRKS_DEFAULT 0xFF // use the machine's quirk profile
+
+struct romdb_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t count;
+	uint32_t entry_size;
+};
+
+struct romdb_entry {
+	uint64_t hash;
+	uint8_t machine; // chip8_machine
+	uint8_t quirks; // CHIP8_QUIRK_* bits or ROMDB_QUIRKS_DEFAULT
+	uint16_t cycles; // instructions per 60hz frame, 0 keeps the default timing
+	char keymap[16]; // raylib key (uppercase letter or digit) for each hex key, 0 keeps the default
+	uint32_t reserved;
+};
+
+struct romdb {
+	const void* map;
+	size_t size;
+	const struct romdb_entry* entries;
+	uint32_t count;
+};
+
+// XXH64 with seed 0, the same value xxhsum -H1 prints
+uint64_t romdb_hash(const void* data, size_t len);
+bool romdb_open(struct romdb* db, const char* path);
+const struct romdb_entry* romdb_lookup(const struct romdb* db, uint64_t hash);
+void romdb_close(struct romdb* db);
+// compile the text source into a binary index, errors are reported to stderr
+bool romdb_compile(const char* source, const char* output);
+
+#endif
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
@@ -0,0 +1,461 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+/* Breadth-first exploration of a ROM's state space. Starting from the loaded machine, every action,
+a keypad mask held for --frames frames, is tried on every state of the current level. A child whose
+state hash is already in the shared visited set is dropped, so each distinct state is expanded once
+however many input sequences reach it. Each level is spread over --jobs threads, each forking states
+from its own pool. */
+
+#include <argp.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "chip8.h"
+#include "hash.h"
+#include "pool.h"
+#include "rom.h"
+
+#define SEARCH_DEPTH 8
+#define SEARCH_FRAMES 4
+#define SEARCH_IPF 15 // instructions per 60hz frame, a common setting for CHIP-8 games
+#define SEARCH_TABLE_BITS 24
+#define SEARCH_MAX_STATES 1000000
+#define SEARCH_MAX_ACTIONS 64
+#define SEARCH_CHUNK 64 // states a thread takes at once
+
+//***arguments***
+struct arguments {
+	const char* rom;
+	chip8_machine machine;
+	const char* quirks;
+	unsigned depth;
+	unsigned frames;
+	unsigned ipf;
+	uint16_t actions[SEARCH_MAX_ACTIONS];
+	unsigned action_count;
+	long jobs;
+	unsigned table_bits;
+	size_t max_states;
+};
+
+enum {
+	OPT_IPF = 256,
+	OPT_TABLE,
+};
+
+static struct argp_option options[] = {
+	{"machine", 'm', "NAME", 0, "Machine to run on: chip8, schip or xochip. Defaults to chip8", 0},
+	{"quirks", 'q', "LIST", 0, "Quirks, same syntax as the emulator's --quirks. Defaults to the machine's profile", 0},
+	{"depth", 'd', "COUNT", 0, "Actions deep to search. Defaults to 8", 0},
+	{"frames", 'f', "COUNT", 0, "Frames each action is held for. Defaults to 4", 0},
+	{"ipf", OPT_IPF, "COUNT", 0, "Instructions per frame. Defaults to 15", 0},
+	{"actions", 'a', "LIST", 0, "Comma separated keypad masks to try, each hex keys joined by '+' or 'none', e.g. none,4,6,4+6. Defaults to none and every single key", 0},
+	{"jobs", 'j', "COUNT", 0, "Threads expanding each level. Defaults to the number of CPUs", 0},
+	{"table", OPT_TABLE, "BITS", 0, "Visited set size as a power of two. Defaults to 24", 0},
+	{"max-states", 's', "COUNT", 0, "Stop once a level has this many new states. Defaults to 1000000", 0},
+	{0}
+};
+
+// "none,4,6,4+6" into keypad masks
+static bool parse_actions(const char* spec, struct arguments* arguments) {
+	arguments->action_count = 0;
+	while (*spec) {
+		if (arguments->action_count == SEARCH_MAX_ACTIONS)
+			return false;
+		uint16_t mask = 0;
+		if (strncmp(spec, "none", 4) == 0) {
+			spec += 4;
+		} else {
+			for (;;) {
+				char* end;
+				unsigned long key = strtoul(spec, &end, 16);
+				if (end == spec || key > 0xF)
+					return false;
+				mask |= 1u << key;
+				spec = end;
+				if (*spec != '+')
+					break;
+				spec++;
+			}
+		}
+		arguments->actions[arguments->action_count++] = mask;
+		if (*spec == ',')
+			spec++;
+		else if (*spec)
+			return false;
+	}
+	return arguments->action_count > 0;
+}
+
+static error_t parse_opt(int key, char* arg, struct argp_state* state) {
+	struct arguments* arguments = state->input;
+	switch (key) {
+		case 'm':
+			if (!chip8_parse_machine(arg, &arguments->machine))
+				argp_error(state, "unknown machine '%s'", arg);
+			break;
+		case 'q':
+			arguments->quirks = arg;
+			break;
+		case 'd':
+			arguments->depth = strtoul(arg, NULL, 10);
+			break;
+		case 'f':
+			arguments->frames = strtoul(arg, NULL, 10);
+			if (arguments->frames == 0)
+				argp_error(state, "frames must be at least 1");
+			break;
+		case OPT_IPF:
+			arguments->ipf = strtoul(arg, NULL, 10);
+			if (arguments->ipf == 0)
+				argp_error(state, "ipf must be at least 1");
+			break;
+		case 'a':
+			if (!parse_actions(arg, arguments))
+				argp_error(state, "bad action list '%s'", arg);
+			break;
+		case 'j':
+			arguments->jobs = atol(arg);
+			if (arguments->jobs < 1)
+				argp_error(state, "jobs must be at least 1");
+			break;
+		case OPT_TABLE:
+			arguments->table_bits = strtoul(arg, NULL, 10);
+			if (arguments->table_bits < 4 || arguments->table_bits > 40)
+				argp_error(state, "table must be between 4 and 40 bits");
+			break;
+		case 's':
+			arguments->max_states = strtoull(arg, NULL, 10);
+			if (arguments->max_states == 0)
+				argp_error(state, "max-states must be at least 1");
+			break;
+		case ARGP_KEY_ARG:
+			if (arguments->rom)
+				argp_usage(state);
+			arguments->rom = arg;
+			break;
+		case ARGP_KEY_NO_ARGS:
+			argp_usage(state);
+			break;
+		default:
+			return ARGP_ERR_UNKNOWN;
+	}
+	return 0;
+}
+
+static struct argp argp = {
+	.options = options,
+	.parser = parse_opt,
+	.args_doc = "ROM",
+	.doc = "Explores every state a ROM reaches under a set of inputs, expanding each distinct state once",
+};
+
+//***search***
+// the states one thread produced for a level, all from that thread's pool
+struct level {
+	chip8** states;
+	size_t count;
+	size_t capacity;
+};
+
+struct worker {
+	pthread_t thread;
+	struct search* search;
+	chip8_pool* pool;
+	struct level next;
+	uint64_t children;
+	uint64_t duplicates;
+	uint64_t terminal; // faulted or exited, kept in the visited set but not expanded
+};
+
+struct search {
+	const struct arguments* args;
+	const chip8_hasher* hasher;
+	chip8_visited visited;
+	// the level being expanded, gathered from every worker's previous one
+	chip8** frontier;
+	size_t frontier_count;
+	atomic_size_t next;
+	atomic_size_t added; // new states this level, for --max-states
+	atomic_bool stop; // any of the below, or the level got too big
+	atomic_bool full;
+	atomic_bool out_of_memory;
+	struct worker* workers;
+	long worker_count;
+};
+
+static bool level_push(struct level* level, chip8* chip) {
+	if (level->count == level->capacity) {
+		size_t capacity = level->capacity ? level->capacity * 2 : 1024;
+		chip8** states = realloc(level->states, capacity * sizeof(*states));
+		if (!states)
+			return false;
+		level->states = states;
+		level->capacity = capacity;
+	}
+	level->states[level->count++] = chip;
+	return true;
+}
+
+// holds the action's keys for the given number of frames, false when the machine faulted or exited
+static bool run_action(chip8* chip, chip8_step_fn step, uint16_t keys, const struct arguments* args) {
+	chip->keys = keys;
+	for (unsigned f = 0; f < args->frames; f++) {
+		for (unsigned i = 0; i < args->ipf; i++) {
+			step(chip);
+			if (chip->fault)
+				return false;
+		}
+		chip->events = 0;
+		if (chip->timer_delay > 0)
+			chip->timer_delay--;
+		if (chip->timer_sound > 0)
+			chip->timer_sound--;
+	}
+	return true;
+}
+
+static void expand(struct worker* w, const chip8* parent) {
+	struct search* search = w->search;
+	const struct arguments* args = search->args;
+	for (unsigned a = 0; a < args->action_count; a++) {
+		chip8* child = chip8_clone(w->pool, parent);
+		if (!child) {
+			atomic_store(&search->out_of_memory, true);
+			atomic_store(&search->stop, true);
+			return;
+		}
+		bool alive = run_action(child, chip8_step_for(child), args->actions[a], args);
+		w->children++;
+		switch (chip8_visited_insert(&search->visited, chip8_hash(search->hasher, child))) {
+			case CHIP8_VISITED_SEEN:
+				w->duplicates++;
+				chip8_release(w->pool, child);
+				continue;
+			case CHIP8_VISITED_FULL:
+				atomic_store(&search->full, true);
+				atomic_store(&search->stop, true);
+				chip8_release(w->pool, child);
+				return;
+			case CHIP8_VISITED_NEW:
+				break;
+		}
+		if (!alive) {
+			w->terminal++;
+			chip8_release(w->pool, child);
+			continue;
+		}
+		if (atomic_fetch_add_explicit(&search->added, 1, memory_order_relaxed) >= args->max_states) {
+			atomic_store(&search->stop, true);
+			chip8_release(w->pool, child);
+			return;
+		}
+		if (!level_push(&w->next, child)) {
+			atomic_store(&search->out_of_memory, true);
+			atomic_store(&search->stop, true);
+			chip8_release(w->pool, child);
+			return;
+		}
+	}
+}
+
+static void* worker_run(void* arg) {
+	struct worker* w = arg;
+	struct search* search = w->search;
+	size_t first;
+	while (!atomic_load_explicit(&search->stop, memory_order_relaxed)
+		&& (first = atomic_fetch_add(&search->next, SEARCH_CHUNK)) < search->frontier_count) {
+		size_t last = first + SEARCH_CHUNK < search->frontier_count ? first + SEARCH_CHUNK : search->frontier_count;
+		for (size_t i = first; i < last && !atomic_load_explicit(&search->stop, memory_order_relaxed); i++)
+			expand(w, search->frontier[i]);
+	}
+	return NULL;
+}
+
+static double now_seconds(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char* argv[]) {
+	struct arguments arguments = {
+		.machine = CHIP8_MACHINE_CHIP8,
+		.depth = SEARCH_DEPTH,
+		.frames = SEARCH_FRAMES,
+		.ipf = SEARCH_IPF,
+		.jobs = sysconf(_SC_NPROCESSORS_ONLN),
+		.table_bits = SEARCH_TABLE_BITS,
+		.max_states = SEARCH_MAX_STATES,
+	};
+	parse_actions("none,0,1,2,3,4,5,6,7,8,9,A,B,C,D,E,F", &arguments);
+	argp_parse(&argp, argc, argv, 0, 0, &arguments);
+	unsigned quirks = chip8_default_quirks(arguments.machine);
+	if (arguments.quirks && !chip8_parse_quirks(arguments.quirks, &quirks)) {
+		fprintf(stderr, "Unknown quirk in '%s'\n", arguments.quirks);
+		return 1;
+	}
+	if (arguments.jobs < 1)
+		arguments.jobs = 1;
+
+	struct rom rom;
+	rom_status status = rom_open(&rom, arguments.rom, XOCHIP_RAM_SIZE - START_ADDRESS);
+	if (status != ROM_OK) {
+		fprintf(stderr, "%s: %s\n", arguments.rom, rom_status_name(status));
+		return 1;
+	}
+	chip8* root = chip8_create(arguments.machine, 0);
+	if (!root) {
+		fprintf(stderr, "Could not allocate memory\n");
+		return 1;
+	}
+	root->quirks = quirks;
+	bool loaded = chip8_load(root, rom.data, rom.size);
+	rom_close(&rom);
+	if (!loaded) {
+		fprintf(stderr, "%s: too big for %s\n", arguments.rom, chip8_machine_name(arguments.machine));
+		return 1;
+	}
+
+	struct search search = {.args = &arguments, .worker_count = arguments.jobs};
+	chip8_hasher* hasher = chip8_hasher_create(root);
+	search.hasher = hasher;
+	search.workers = calloc(arguments.jobs, sizeof(*search.workers));
+	if (!hasher || !search.workers || !chip8_visited_init(&search.visited, arguments.table_bits)) {
+		fprintf(stderr, "Could not allocate memory\n");
+		return 1;
+	}
+	for (long i = 0; i < arguments.jobs; i++) {
+		search.workers[i].search = &search;
+		search.workers[i].pool = chip8_pool_create(root);
+		if (!search.workers[i].pool) {
+			fprintf(stderr, "Could not allocate memory\n");
+			return 1;
+		}
+	}
+	atomic_init(&search.stop, false);
+	atomic_init(&search.full, false);
+	atomic_init(&search.out_of_memory, false);
+	chip8_visited_insert(&search.visited, chip8_hash(hasher, root));
+
+	printf("%-6s %12s %12s %12s %12s %12s %9s\n", "depth", "expanded", "children", "new", "duplicates", "visited", "seconds");
+	search.frontier = &root;
+	search.frontier_count = 1;
+	chip8** gathered = NULL;
+	uint64_t total_children = 0, total_duplicates = 0, total_terminal = 0;
+	double started = now_seconds();
+	unsigned depth = 1;
+	for (; depth <= arguments.depth && search.frontier_count > 0; depth++) {
+		double level_start = now_seconds();
+		atomic_init(&search.next, 0);
+		atomic_init(&search.added, 0);
+		// each worker's previous level stays alive until its children are made
+		struct level* previous = calloc(arguments.jobs, sizeof(*previous));
+		if (!previous) {
+			fprintf(stderr, "Could not allocate memory\n");
+			return 1;
+		}
+		for (long i = 0; i < arguments.jobs; i++) {
+			struct worker* w = &search.workers[i];
+			previous[i] = w->next;
+			w->next = (struct level){0};
+			w->children = w->duplicates = w->terminal = 0;
+		}
+		long started_threads = 0;
+		for (; started_threads < arguments.jobs; started_threads++) {
+			if (pthread_create(&search.workers[started_threads].thread, NULL, worker_run, &search.workers[started_threads]) != 0)
+				break;
+		}
+		if (started_threads == 0)
+			worker_run(&search.workers[0]);
+		for (long i = 0; i < started_threads; i++)
+			pthread_join(search.workers[i].thread, NULL);
+
+		// the previous level is done with, its states go back to the pools they came from
+		uint64_t children = 0, duplicates = 0, added = 0;
+		for (long i = 0; i < arguments.jobs; i++) {
+			struct worker* w = &search.workers[i];
+			for (size_t s = 0; s < previous[i].count; s++)
+				chip8_release(w->pool, previous[i].states[s]);
+			free(previous[i].states);
+			children += w->children;
+			duplicates += w->duplicates;
+			total_terminal += w->terminal;
+			added += w->next.count;
+		}
+		free(previous);
+		total_children += children;
+		total_duplicates += duplicates;
+		printf("%-6u %12zu %12" PRIu64 " %12" PRIu64 " %12" PRIu64 " %12zu %9.3f\n", depth, search.frontier_count,
+			children, children - duplicates, duplicates, atomic_load(&search.visited.count), now_seconds() - level_start);
+
+		free(gathered);
+		gathered = malloc((added ? added : 1) * sizeof(*gathered));
+		if (!gathered) {
+			fprintf(stderr, "Could not allocate memory\n");
+			return 1;
+		}
+		search.frontier_count = 0;
+		for (long i = 0; i < arguments.jobs; i++) {
+			struct level* next = &search.workers[i].next;
+			memcpy(gathered + search.frontier_count, next->states, next->count * sizeof(*gathered));
+			search.frontier_count += next->count;
+		}
+		search.frontier = gathered;
+		if (atomic_load(&search.stop))
+			break;
+	}
+
+	double elapsed = now_seconds() - started;
+	size_t visited = atomic_load(&search.visited.count);
+	if (atomic_load(&search.out_of_memory))
+		fprintf(stderr, "Stopped at depth %u: out of memory\n", depth);
+	else if (atomic_load(&search.full))
+		fprintf(stderr, "Stopped at depth %u: the visited set is full, raise --table\n", depth);
+	else if (atomic_load(&search.stop))
+		fprintf(stderr, "Stopped at depth %u: more than %zu new states, raise --max-states\n", depth, arguments.max_states);
+	printf("%zu distinct states (%" PRIu64 " ended in a fault or exit), %" PRIu64 " of %" PRIu64 " children were duplicates (%.1f%%), %.0f children/s\n",
+		visited, total_terminal, total_duplicates, total_children,
+		total_children ? 100.0 * total_duplicates / total_children : 0.0, elapsed > 0 ? total_children / elapsed : 0.0);
+
+	for (long i = 0; i < arguments.jobs; i++) {
+		free(search.workers[i].next.states);
+		chip8_pool_free(search.workers[i].pool);
+	}
+	free(search.workers);
+	free(gathered);
+	chip8_visited_free(&search.visited);
+	chip8_hasher_free(hasher);
+	free(root);
+	return 0;
+}
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
@@ -0,0 +1,349 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+/* Headless emulator serving its display to remote viewers, see stream.h. The ROM runs at 60 frames a
+second whether or not anyone is watching; each frame's message is encoded once and queued to every
+viewer, and the keypads of all viewers are pressed together. A viewer that falls more than
+SERVE_BACKLOG bytes behind is dropped rather than letting frames pile up for it. */
+
+#include <argp.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include "chip8.h"
+#include "pacer.h"
+#include "rom.h"
+#include "stream.h"
+
+#define TIMER_HZ 60
+#define SERVE_MAX_CLIENTS 64
+#define SERVE_BACKLOG 32768 // bytes queued to a viewer, about a second of deltas or a dozen keyframes
+
+//***arguments***
+struct arguments {
+	const char* rom;
+	chip8_machine machine;
+	const char* quirks;
+	float hz;
+	const char* listen;
+	unsigned keyframe;
+};
+
+enum {
+	OPT_HZ = 256,
+	OPT_KEYFRAME,
+};
+
+static struct argp_option options[] = {
+	{"machine", 'm', "NAME", 0, "Machine to run on: chip8, schip or xochip. Defaults to chip8", 0},
+	{"quirks", 'q', "LIST", 0, "Quirks, same syntax as the emulator's --quirks. Defaults to the machine's profile", 0},
+	{"hz", OPT_HZ, "NUMBER", 0, "Clock speed in hz. Defaults to the COSMAC VIP instruction timings", 0},
+	{"listen", 'l', "ADDR", 0, "Address to serve on, unix:PATH or [HOST]:PORT. Defaults to unix:chip8.sock", 0},
+	{"keyframe", OPT_KEYFRAME, "FRAMES", 0, "Frames between keyframes, 0 to only send them to new viewers. Defaults to 300", 0},
+	{0}
+};
+
+static error_t parse_opt(int key, char* arg, struct argp_state* state) {
+	struct arguments* arguments = state->input;
+	switch (key) {
+		case 'm':
+			if (!chip8_parse_machine(arg, &arguments->machine))
+				argp_error(state, "unknown machine '%s'", arg);
+			break;
+		case 'q':
+			arguments->quirks = arg;
+			break;
+		case OPT_HZ:
+			arguments->hz = atof(arg);
+			if (arguments->hz < 0.0f)
+				argp_error(state, "hz must not be negative");
+			break;
+		case 'l':
+			arguments->listen = arg;
+			break;
+		case OPT_KEYFRAME:
+			arguments->keyframe = strtoul(arg, NULL, 10);
+			break;
+		case ARGP_KEY_ARG:
+			if (arguments->rom)
+				argp_usage(state);
+			arguments->rom = arg;
+			break;
+		case ARGP_KEY_NO_ARGS:
+			argp_usage(state);
+			break;
+		default:
+			return ARGP_ERR_UNKNOWN;
+	}
+	return 0;
+}
+
+static struct argp argp = {
+	.options = options,
+	.parser = parse_opt,
+	.args_doc = "ROM",
+	.doc = "Runs a ROM without a window and streams its display to chip-8-emu --connect viewers",
+};
+
+//***viewers***
+struct client {
+	int fd;
+	uint16_t keys;
+	uint8_t in[STREAM_HEADER_SIZE + 2]; // a viewer only ever sends keypad messages
+	size_t in_length;
+	uint8_t out[SERVE_BACKLOG];
+	size_t out_length;
+};
+
+struct server {
+	int listener;
+	struct client* clients[SERVE_MAX_CLIENTS];
+	size_t count;
+	bool joined; // someone connected since the last frame, they need a keyframe
+	uint64_t messages;
+	uint64_t bytes;
+};
+
+static void drop_client(struct server* server, size_t i) {
+	close(server->clients[i]->fd);
+	free(server->clients[i]);
+	server->clients[i] = server->clients[--server->count];
+}
+
+static void accept_clients(struct server* server) {
+	for (;;) {
+		int fd = accept(server->listener, NULL, NULL);
+		if (fd < 0)
+			return;
+		fcntl(fd, F_SETFL, O_NONBLOCK);
+		fcntl(fd, F_SETFD, FD_CLOEXEC);
+		struct client* client = server->count < SERVE_MAX_CLIENTS ? calloc(1, sizeof(*client)) : NULL;
+		if (!client) {
+			close(fd);
+			continue;
+		}
+		// fails harmlessly on Unix sockets
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &(int){1}, sizeof(int));
+		client->fd = fd;
+		server->clients[server->count++] = client;
+		server->joined = true;
+	}
+}
+
+// drains what a viewer sent, false once it hung up or sent something that isn't a keypad message
+static bool read_client(struct client* client) {
+	for (;;) {
+		ssize_t got = recv(client->fd, client->in + client->in_length, sizeof(client->in) - client->in_length, 0);
+		if (got == 0)
+			return false;
+		if (got < 0)
+			return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+		client->in_length += got;
+		if (client->in_length < sizeof(client->in))
+			continue;
+		struct stream_header header;
+		if (!stream_parse_header(client->in, &header) || header.type != STREAM_KEYS)
+			return false;
+		client->keys = client->in[STREAM_HEADER_SIZE] | client->in[STREAM_HEADER_SIZE + 1] << 8;
+		client->in_length = 0;
+	}
+}
+
+// sends as much of the queue as the socket takes, false once the viewer is gone
+static bool flush_client(struct client* client) {
+	while (client->out_length > 0) {
+		ssize_t sent = send(client->fd, client->out, client->out_length, MSG_NOSIGNAL);
+		if (sent < 0)
+			return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+		client->out_length -= sent;
+		memmove(client->out, client->out + sent, client->out_length);
+	}
+	return true;
+}
+
+static void broadcast(struct server* server, const uint8_t* message, size_t size) {
+	server->messages++;
+	server->bytes += size;
+	for (size_t i = 0; i < server->count;) {
+		struct client* client = server->clients[i];
+		if (client->out_length + size > sizeof(client->out)) {
+			fprintf(stderr, "dropping a viewer that fell %zu bytes behind\n", client->out_length);
+			drop_client(server, i);
+			continue;
+		}
+		memcpy(client->out + client->out_length, message, size);
+		client->out_length += size;
+		i++;
+	}
+}
+
+// one pass over the sockets without waiting, the pacer does the waiting
+static void service(struct server* server) {
+	struct pollfd fds[SERVE_MAX_CLIENTS + 1];
+	fds[0] = (struct pollfd){.fd = server->listener, .events = POLLIN};
+	for (size_t i = 0; i < server->count; i++)
+		fds[i + 1] = (struct pollfd){.fd = server->clients[i]->fd, .events = POLLIN | (server->clients[i]->out_length ? POLLOUT : 0)};
+	size_t polled = server->count;
+	if (poll(fds, polled + 1, 0) <= 0)
+		return;
+	// backwards so dropping a viewer doesn't move one that is still to be looked at
+	for (size_t i = polled; i-- > 0;) {
+		struct client* client = server->clients[i];
+		short revents = fds[i + 1].revents;
+		bool alive = !(revents & (POLLERR | POLLNVAL));
+		if (alive && (revents & (POLLIN | POLLHUP)))
+			alive = read_client(client);
+		if (alive && (revents & POLLOUT))
+			alive = flush_client(client);
+		if (!alive)
+			drop_client(server, i);
+	}
+	if (fds[0].revents & POLLIN)
+		accept_clients(server);
+}
+
+static uint16_t viewer_keys(const struct server* server) {
+	uint16_t keys = 0;
+	for (size_t i = 0; i < server->count; i++)
+		keys |= server->clients[i]->keys;
+	return keys;
+}
+
+static volatile sig_atomic_t stopping;
+
+static void on_signal(int sig) {
+	(void)sig;
+	stopping = 1;
+}
+
+int main(int argc, char* argv[]) {
+	struct arguments arguments = {
+		.machine = CHIP8_MACHINE_CHIP8,
+		.listen = "unix:chip8.sock",
+		.keyframe = STREAM_KEYFRAME_INTERVAL,
+	};
+	argp_parse(&argp, argc, argv, 0, 0, &arguments);
+	unsigned quirks = chip8_default_quirks(arguments.machine);
+	if (arguments.quirks && !chip8_parse_quirks(arguments.quirks, &quirks)) {
+		fprintf(stderr, "Unknown quirk in '%s'\n", arguments.quirks);
+		return 1;
+	}
+
+	struct rom rom;
+	rom_status status = rom_open(&rom, arguments.rom, XOCHIP_RAM_SIZE - START_ADDRESS);
+	if (status != ROM_OK) {
+		fprintf(stderr, "%s: %s\n", arguments.rom, rom_status_name(status));
+		return 1;
+	}
+	chip8* chip = chip8_create(arguments.machine, (uint32_t)time(NULL));
+	if (!chip) {
+		fprintf(stderr, "Could not allocate memory\n");
+		return 1;
+	}
+	chip->quirks = quirks;
+	bool loaded = chip8_load(chip, rom.data, rom.size);
+	rom_close(&rom);
+	if (!loaded) {
+		fprintf(stderr, "%s: too big for %s\n", arguments.rom, chip8_machine_name(arguments.machine));
+		return 1;
+	}
+
+	struct server server = {.listener = stream_listen(arguments.listen)};
+	if (server.listener < 0) {
+		fprintf(stderr, "Could not listen on %s\n", arguments.listen);
+		return 1;
+	}
+	struct sigaction action = {.sa_handler = on_signal};
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+
+	struct stream_encoder encoder;
+	stream_encoder_init(&encoder, arguments.machine, arguments.keyframe);
+	static uint8_t message[STREAM_MAX_MESSAGE];
+	const chip8_step_fn step = chip8_step_for(chip);
+	struct pacer pacer;
+	pacer_init(&pacer, 1000000000ull / TIMER_HZ);
+	double budget = 0.0;
+	uint64_t frames = 0;
+	int exit_status = 0;
+	while (!stopping) {
+		service(&server);
+		chip->keys = viewer_keys(&server);
+		budget += 1.0 / TIMER_HZ;
+		while (budget > 0.0 && !chip->fault) {
+			double wait = step(chip);
+			budget -= arguments.hz ? 1.0 / arguments.hz : wait;
+		}
+		chip->events = 0;
+		if (chip->fault) {
+			if (chip->fault != CHIP8_FAULT_EXIT) {
+				fprintf(stderr, "%s at %03X\n", chip8_fault_name(chip->fault), chip->pc);
+				exit_status = 1;
+			}
+			break;
+		}
+		if (chip->timer_delay > 0)
+			chip->timer_delay--;
+		if (chip->timer_sound > 0)
+			chip->timer_sound--;
+		frames++;
+		if (server.count > 0) {
+			size_t size = stream_encode_frame(&encoder, chip, frames, server.joined, message);
+			server.joined = false;
+			if (size)
+				broadcast(&server, message, size);
+		} else {
+			// nobody to keep in sync, whoever comes next starts from a keyframe
+			encoder.started = false;
+		}
+		for (size_t i = server.count; i-- > 0;) {
+			if (!flush_client(server.clients[i]))
+				drop_client(&server, i);
+		}
+		pacer_wait(&pacer);
+	}
+
+	fprintf(stderr, "%" PRIu64 " frames, %" PRIu64 " messages, %" PRIu64 " bytes, %.1f bytes per frame\n",
+		frames, server.messages, server.bytes, frames ? (double)server.bytes / frames : 0.0);
+	while (server.count > 0)
+		drop_client(&server, server.count - 1);
+	close(server.listener);
+	if (strncmp(arguments.listen, "unix:", 5) == 0)
+		unlink(arguments.listen + 5);
+	free(chip);
+	return exit_status;
+}
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
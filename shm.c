@@ -0,0 +1,252 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "shm.h"
+
+// shm_open() wants a single leading slash
+static void object_name(const char* name, char* buf, size_t size) {
+	snprintf(buf, size, "%s%s", name[0] == '/' ? "" : "/", name);
+}
+
+//***emulator***
+struct chip8_shm* shm_create(const char* name) {
+	char path[256];
+	object_name(name, path, sizeof(path));
+	// a previous run that didn't exit cleanly leaves its object behind
+	shm_unlink(path);
+	int fd = shm_open(path, O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd < 0)
+		return NULL;
+	if (ftruncate(fd, sizeof(struct chip8_shm)) != 0) {
+		close(fd);
+		shm_unlink(path);
+		return NULL;
+	}
+	struct chip8_shm* shm = mmap(NULL, sizeof(*shm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (shm == MAP_FAILED) {
+		shm_unlink(path);
+		return NULL;
+	}
+	// ftruncate() zeroed it, so every slot starts stable at sequence 0 and head at 0
+	shm->version = CHIP8_SHM_VERSION;
+	shm->slot_count = CHIP8_SHM_SLOTS;
+	shm->slot_size = sizeof(struct chip8_shm_frame);
+	// agents check the magic first, so it goes in last
+	atomic_thread_fence(memory_order_release);
+	shm->magic = CHIP8_SHM_MAGIC;
+	return shm;
+}
+
+void shm_publish(struct chip8_shm* shm, const chip8* chip, uint64_t frame) {
+	uint64_t head = atomic_load_explicit(&shm->head, memory_order_relaxed);
+	struct chip8_shm_frame* slot = &shm->slots[head % CHIP8_SHM_SLOTS];
+	uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+	atomic_store_explicit(&slot->seq, seq + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	slot->machine = chip->machine;
+	slot->hires = chip->hires;
+	slot->planes = chip->planes;
+	slot->fault = chip->fault;
+	slot->frame = frame;
+	slot->cycles = chip->cycles;
+	slot->pc = chip->pc;
+	slot->i = chip->idx_reg;
+	memcpy(slot->stack, chip->stack, sizeof(slot->stack));
+	memcpy(slot->v, chip->registers, sizeof(slot->v));
+	slot->sp = chip->idx_stack;
+	slot->dt = chip->timer_delay;
+	slot->st = chip->timer_sound;
+	slot->keys = chip->keys;
+	// only XO-CHIP draws into the second plane
+	memcpy(slot->display, chip->display, chip->machine == CHIP8_MACHINE_XOCHIP ? sizeof(slot->display) : sizeof(slot->display[0]));
+	atomic_store_explicit(&slot->seq, seq + 2, memory_order_release);
+	atomic_store_explicit(&shm->head, head + 1, memory_order_release);
+}
+
+void shm_destroy(struct chip8_shm* shm, const char* name) {
+	char path[256];
+	object_name(name, path, sizeof(path));
+	munmap(shm, sizeof(*shm));
+	shm_unlink(path);
+}
+
+//***agents***
+struct chip8_shm* shm_attach(const char* name) {
+	char path[256];
+	object_name(name, path, sizeof(path));
+	int fd = shm_open(path, O_RDWR, 0);
+	if (fd < 0)
+		return NULL;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(struct chip8_shm)) {
+		close(fd);
+		return NULL;
+	}
+	struct chip8_shm* shm = mmap(NULL, sizeof(*shm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (shm == MAP_FAILED)
+		return NULL;
+	uint32_t magic = shm->magic;
+	atomic_thread_fence(memory_order_acquire);
+	if (magic != CHIP8_SHM_MAGIC || shm->version != CHIP8_SHM_VERSION || shm->slot_count != CHIP8_SHM_SLOTS
+		|| shm->slot_size != sizeof(struct chip8_shm_frame)) {
+		munmap(shm, sizeof(*shm));
+		return NULL;
+	}
+	return shm;
+}
+
+void shm_detach(struct chip8_shm* shm) {
+	munmap(shm, sizeof(*shm));
+}
+
+#ifdef SHM_MAIN
+//***command line agent***
+#include <argp.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <time.h>
+
+struct arguments {
+	const char* name;
+	bool show;
+	uint64_t count; // 0 follows until the emulator goes away
+	bool set_keys;
+	uint16_t keys;
+};
+
+static struct argp_option options[] = {
+	{"show", 's', 0, 0, "Draw each frame as text", 0},
+	{"count", 'n', "FRAMES", 0, "Stop after this many frames", 0},
+	{"keys", 'k', "MASK", 0, "Hold the keys of a hex keypad mask, e.g. 0010 for key 4, 0 to release them all, then exit", 0},
+	{0}
+};
+
+static error_t parse_opt(int key, char* arg, struct argp_state* state) {
+	struct arguments* arguments = state->input;
+	switch (key) {
+		case 's':
+			arguments->show = true;
+			break;
+		case 'n':
+			arguments->count = strtoull(arg, NULL, 10);
+			break;
+		case 'k':
+			arguments->set_keys = true;
+			arguments->keys = strtoul(arg, NULL, 16);
+			break;
+		case ARGP_KEY_ARG:
+			if (state->arg_num >= 1)
+				argp_usage(state);
+			arguments->name = arg;
+			break;
+		case ARGP_KEY_END:
+			if (state->arg_num < 1)
+				argp_usage(state);
+			break;
+		default:
+			return ARGP_ERR_UNKNOWN;
+	}
+	return 0;
+}
+
+static struct argp argp = {
+	.options = options,
+	.parser = parse_opt,
+	.args_doc = "NAME",
+	.doc = "Follows the frames chip-8-emu --shm=NAME publishes, or presses keys through it",
+};
+
+// one line of text per frame row, plane 0 only
+static void show(const struct chip8_shm_frame* slot) {
+	unsigned width = slot->hires ? CHIP8_HIRES_WIDTH : CHIP8_WIDTH;
+	unsigned height = slot->hires ? CHIP8_HIRES_HEIGHT : CHIP8_HEIGHT;
+	char line[CHIP8_HIRES_WIDTH + 2];
+	for (unsigned y = 0; y < height; y++) {
+		for (unsigned x = 0; x < width; x++)
+			line[x] = chip8_pixel(slot->display[0], x, y) ? '#' : '.';
+		line[width] = '\n';
+		line[width + 1] = '\0';
+		fputs(line, stdout);
+	}
+}
+
+int main(int argc, char** argv) {
+	struct arguments arguments = {0};
+	argp_parse(&argp, argc, argv, 0, 0, &arguments);
+	struct chip8_shm* shm = shm_attach(arguments.name);
+	if (!shm) {
+		fprintf(stderr, "No frames published as %s\n", arguments.name);
+		return 1;
+	}
+	if (arguments.set_keys) {
+		atomic_store_explicit(&shm->keys, arguments.keys, memory_order_relaxed);
+		shm_detach(shm);
+		return 0;
+	}
+
+	uint64_t last = atomic_load_explicit(&shm->head, memory_order_acquire);
+	uint64_t shown = 0, skipped = 0;
+	// the emulator sends no goodbye, a second without frames counts as gone
+	unsigned idle = 0;
+	while (!arguments.count || shown < arguments.count) {
+		uint64_t head = atomic_load_explicit(&shm->head, memory_order_acquire);
+		if (head == last) {
+			if (++idle > 1000)
+				break;
+			nanosleep(&(struct timespec){.tv_nsec = 1000000}, NULL);
+			continue;
+		}
+		idle = 0;
+		const struct chip8_shm_frame* slot = &shm->slots[(head - 1) % CHIP8_SHM_SLOTS];
+		// a terminal is slower than the emulator, so this one copies the frame out before printing it
+		struct chip8_shm_frame copy;
+		uint32_t seq = chip8_shm_read_begin(slot);
+		memcpy(&copy, slot, sizeof(copy));
+		if (!chip8_shm_read_end(slot, seq))
+			continue; // lapped while reading, take the newest one instead
+		skipped += head - last - 1;
+		last = head;
+		shown++;
+		if (arguments.show)
+			show(&copy);
+		printf("frame %" PRIu64 "  PC %04X  I %04X  V", copy.frame, copy.pc, copy.i);
+		for (unsigned r = 0; r < 16; r++)
+			printf(" %02X", copy.v[r]);
+		printf("\n");
+		fflush(stdout);
+	}
+	fprintf(stderr, "%" PRIu64 " frames shown, %" PRIu64 " skipped\n", shown, skipped);
+	shm_detach(shm);
+	return 0;
+}
+#endif
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
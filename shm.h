@@ -0,0 +1,103 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+#ifndef SHM_H
+#define SHM_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "chip8.h"
+
+/* Frames and keypad input shared with other processes on the same host, for --shm=NAME.
+The emulator creates the POSIX shared memory object /NAME (/dev/shm/NAME on Linux) and publishes every
+emulated frame into a ring of CHIP8_SHM_SLOTS slots: the packed display and the registers. Each slot is
+a seqlock, its sequence number is odd while the emulator writes it, so readers map the region and read
+slots in place without copies or locks, then check the sequence number to see whether the frame was
+overwritten meanwhile. An agent presses keys by storing a keypad mask in keys, which the emulator ORs
+with the keyboard at the start of every frame. Everything is in host byte order. */
+#define CHIP8_SHM_MAGIC 0x4D485338u // "8SHM"
+#define CHIP8_SHM_VERSION 1
+#define CHIP8_SHM_SLOTS 8
+
+struct chip8_shm_frame {
+	_Atomic uint32_t seq;
+	uint8_t machine;
+	uint8_t hires;
+	uint8_t planes; // XO-CHIP planes selected by Fn01
+	uint8_t fault;
+	uint64_t frame; // emulated frames since the start, the first published frame is 1
+	uint64_t cycles;
+	uint16_t pc;
+	uint16_t i;
+	uint16_t stack[CHIP8_STACK_SIZE];
+	uint8_t v[16];
+	uint8_t sp;
+	uint8_t dt;
+	uint8_t st;
+	uint16_t keys; // what the frame ran with
+	chip8_plane display[CHIP8_PLANES]; // see chip8.display
+} __attribute__((aligned(64)));
+
+struct chip8_shm {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t slot_count;
+	uint32_t slot_size; // sizeof(struct chip8_shm_frame)
+	_Atomic uint64_t head; // frames published so far, the newest is in slots[(head - 1) % slot_count]
+	_Alignas(64) _Atomic uint32_t keys; // written by agents, bit n holds hex key n
+	_Alignas(64) struct chip8_shm_frame slots[CHIP8_SHM_SLOTS];
+};
+
+/* Reading slot n in place:
+	uint32_t seq = chip8_shm_read_begin(&shm->slots[n]);
+	... read the slot ...
+	if (!chip8_shm_read_end(&shm->slots[n], seq)) the emulator overwrote it meanwhile, read the newest again */
+static inline uint32_t chip8_shm_read_begin(const struct chip8_shm_frame* slot) {
+	uint32_t seq;
+	while ((seq = atomic_load_explicit(&slot->seq, memory_order_acquire)) & 1u)
+		;
+	return seq;
+}
+static inline bool chip8_shm_read_end(const struct chip8_shm_frame* slot, uint32_t seq) {
+	atomic_thread_fence(memory_order_acquire);
+	return atomic_load_explicit(&slot->seq, memory_order_relaxed) == seq;
+}
+
+// emulator side: creates /name, replacing any stale one, NULL on failure
+struct chip8_shm* shm_create(const char* name);
+// publishes chip as emulated frame number frame
+void shm_publish(struct chip8_shm* shm, const chip8* chip, uint64_t frame);
+static inline uint16_t shm_keys(const struct chip8_shm* shm) {
+	return atomic_load_explicit(&shm->keys, memory_order_relaxed) & 0xFFFFu;
+}
+// unmaps and removes /name, agents that still have it mapped keep their mapping
+void shm_destroy(struct chip8_shm* shm, const char* name);
+
+// agent side: maps an existing /name read-write, NULL when it isn't there or isn't a frame region
+struct chip8_shm* shm_attach(const char* name);
+void shm_detach(struct chip8_shm* shm);
+
+#endif
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
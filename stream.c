@@ -0,0 +1,293 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "stream.h"
+
+//***wire format***
+static void put16(uint8_t* out, uint16_t v) {
+	out[0] = v;
+	out[1] = v >> 8;
+}
+
+static void put32(uint8_t* out, uint32_t v) {
+	for (unsigned b = 0; b < 4; b++)
+		out[b] = v >> (8 * b);
+}
+
+static void put64(uint8_t* out, uint64_t v) {
+	for (unsigned b = 0; b < 8; b++)
+		out[b] = v >> (8 * b);
+}
+
+static uint64_t get64(const uint8_t* in) {
+	uint64_t v = 0;
+	for (unsigned b = 0; b < 8; b++)
+		v |= (uint64_t)in[b] << (8 * b);
+	return v;
+}
+
+static void put_header(uint8_t* out, const struct stream_header* header) {
+	out[0] = header->type;
+	out[1] = header->flags;
+	out[2] = header->planes;
+	out[3] = 0;
+	put32(out + 4, header->length);
+	put64(out + 8, header->frame);
+}
+
+bool stream_parse_header(const uint8_t in[STREAM_HEADER_SIZE], struct stream_header* header) {
+	header->type = in[0];
+	header->flags = in[1];
+	header->planes = in[2];
+	header->reserved = in[3];
+	header->length = in[4] | in[5] << 8 | in[6] << 16 | (uint32_t)in[7] << 24;
+	header->frame = get64(in + 8);
+	if (header->type == STREAM_KEYS)
+		return header->length == 2;
+	return (header->type == STREAM_KEYFRAME || header->type == STREAM_DELTA) && header->length <= STREAM_MAX_PAYLOAD
+		&& header->planes < (1u << CHIP8_PLANES);
+}
+
+//***encoding***
+void stream_encoder_init(struct stream_encoder* encoder, chip8_machine machine, unsigned keyframe_interval) {
+	memset(encoder, 0, sizeof(*encoder));
+	encoder->planes = machine == CHIP8_MACHINE_XOCHIP ? CHIP8_PLANES : 1;
+	encoder->keyframe_interval = keyframe_interval;
+}
+
+static bool row_differs(const chip8_plane a, const chip8_plane b, unsigned y, bool hires) {
+	return a[y][0] != b[y][0] || (hires && a[y][1] != b[y][1]);
+}
+
+size_t stream_encode_frame(struct stream_encoder* encoder, const chip8* chip, uint64_t frame, bool keyframe, uint8_t* out) {
+	const bool hires = chip->hires;
+	const unsigned height = hires ? CHIP8_HIRES_HEIGHT : CHIP8_HEIGHT;
+	keyframe = keyframe || !encoder->started || hires != encoder->hires
+		|| (encoder->keyframe_interval && frame - encoder->last_keyframe >= encoder->keyframe_interval);
+	struct stream_header header = {
+		.type = keyframe ? STREAM_KEYFRAME : STREAM_DELTA,
+		.flags = hires ? STREAM_HIRES : 0,
+		.frame = frame,
+	};
+	uint8_t* at = out + STREAM_HEADER_SIZE;
+	for (unsigned p = 0; p < encoder->planes; p++) {
+		uint64_t rows = 0;
+		for (unsigned y = 0; y < height; y++) {
+			if (keyframe || row_differs(chip->display[p], encoder->sent[p], y, hires))
+				rows |= 1ull << y;
+		}
+		if (!rows)
+			continue;
+		header.planes |= 1u << p;
+		put64(at, rows);
+		at += 8;
+		for (uint64_t left = rows; left; left &= left - 1) {
+			unsigned y = __builtin_ctzll(left);
+			put64(at, chip->display[p][y][0]);
+			at += 8;
+			if (hires) {
+				put64(at, chip->display[p][y][1]);
+				at += 8;
+			}
+		}
+	}
+	if (!header.planes && !keyframe)
+		return 0;
+	memcpy(encoder->sent, chip->display, sizeof(encoder->sent));
+	encoder->hires = hires;
+	encoder->started = true;
+	if (keyframe)
+		encoder->last_keyframe = frame;
+	header.length = at - out - STREAM_HEADER_SIZE;
+	put_header(out, &header);
+	return at - out;
+}
+
+size_t stream_encode_keys(uint16_t keys, uint8_t* out) {
+	struct stream_header header = {.type = STREAM_KEYS, .length = 2};
+	put_header(out, &header);
+	put16(out + STREAM_HEADER_SIZE, keys);
+	return STREAM_HEADER_SIZE + 2;
+}
+
+bool stream_apply(const struct stream_header* header, const uint8_t* payload, chip8_plane display[CHIP8_PLANES], bool* hires) {
+	const bool frame_hires = header->flags & STREAM_HIRES;
+	const unsigned row_bytes = frame_hires ? 16 : 8;
+	const uint8_t* at = payload;
+	const uint8_t* end = payload + header->length;
+	if (header->type == STREAM_KEYFRAME) {
+		// a keyframe without a plane means that plane is blank
+		memset(display, 0, sizeof(chip8_plane) * CHIP8_PLANES);
+	}
+	for (unsigned p = 0; p < CHIP8_PLANES; p++) {
+		if (!(header->planes & (1u << p)))
+			continue;
+		if (end - at < 8)
+			return false;
+		uint64_t rows = get64(at);
+		at += 8;
+		if (!frame_hires && (rows >> CHIP8_HEIGHT))
+			return false;
+		if ((size_t)(end - at) < (size_t)__builtin_popcountll(rows) * row_bytes)
+			return false;
+		for (; rows; rows &= rows - 1) {
+			unsigned y = __builtin_ctzll(rows);
+			display[p][y][0] = get64(at);
+			at += 8;
+			if (frame_hires) {
+				display[p][y][1] = get64(at);
+				at += 8;
+			}
+		}
+	}
+	*hires = frame_hires;
+	return at == end;
+}
+
+//***sockets***
+bool stream_receive(int fd, struct stream_header* header, uint8_t* payload) {
+	uint8_t raw[STREAM_HEADER_SIZE];
+	if (recv(fd, raw, sizeof(raw), MSG_WAITALL) != (ssize_t)sizeof(raw) || !stream_parse_header(raw, header))
+		return false;
+	return header->length == 0 || recv(fd, payload, header->length, MSG_WAITALL) == (ssize_t)header->length;
+}
+
+bool stream_send(int fd, const uint8_t* message, size_t size) {
+	while (size > 0) {
+		ssize_t sent = send(fd, message, size, MSG_NOSIGNAL);
+		if (sent <= 0)
+			return false;
+		message += sent;
+		size -= sent;
+	}
+	return true;
+}
+
+static bool unix_address(const char* addr, struct sockaddr_un* un) {
+	memset(un, 0, sizeof(*un));
+	un->sun_family = AF_UNIX;
+	const char* path = addr + 5;
+	if (strlen(path) >= sizeof(un->sun_path))
+		return false;
+	strcpy(un->sun_path, path);
+	return true;
+}
+
+// resolves [HOST]:PORT, an IPv6 HOST in brackets, no HOST binds every address
+static struct addrinfo* tcp_address(const char* addr, bool passive) {
+	const char* colon = strrchr(addr, ':');
+	const char* port = colon ? colon + 1 : addr;
+	char host[256] = "";
+	if (colon) {
+		size_t length = colon - addr;
+		if (length >= 2 && addr[0] == '[' && addr[length - 1] == ']') {
+			addr++;
+			length -= 2;
+		}
+		if (length >= sizeof(host))
+			return NULL;
+		memcpy(host, addr, length);
+		host[length] = '\0';
+	}
+	struct addrinfo hints = {.ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM, .ai_flags = passive ? AI_PASSIVE : 0};
+	struct addrinfo* list;
+	if (getaddrinfo(host[0] ? host : NULL, port, &hints, &list) != 0)
+		return NULL;
+	return list;
+}
+
+int stream_listen(const char* addr) {
+	int fd = -1;
+	if (strncmp(addr, "unix:", 5) == 0) {
+		struct sockaddr_un un;
+		if (!unix_address(addr, &un))
+			return -1;
+		fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if (fd < 0)
+			return -1;
+		// a socket file left behind by an earlier server
+		unlink(un.sun_path);
+		if (bind(fd, (struct sockaddr*)&un, sizeof(un)) != 0 || listen(fd, 16) != 0) {
+			close(fd);
+			return -1;
+		}
+		return fd;
+	}
+	struct addrinfo* list = tcp_address(addr, true);
+	for (struct addrinfo* ai = list; ai; ai = ai->ai_next) {
+		fd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+		if (fd < 0)
+			continue;
+		setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &(int){1}, sizeof(int));
+		if (bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && listen(fd, 16) == 0)
+			break;
+		close(fd);
+		fd = -1;
+	}
+	if (list)
+		freeaddrinfo(list);
+	return fd;
+}
+
+int stream_connect(const char* addr) {
+	int fd = -1;
+	if (strncmp(addr, "unix:", 5) == 0) {
+		struct sockaddr_un un;
+		if (!unix_address(addr, &un))
+			return -1;
+		fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if (fd >= 0 && connect(fd, (struct sockaddr*)&un, sizeof(un)) != 0) {
+			close(fd);
+			fd = -1;
+		}
+		return fd;
+	}
+	struct addrinfo* list = tcp_address(addr, false);
+	for (struct addrinfo* ai = list; ai; ai = ai->ai_next) {
+		fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+		if (fd < 0)
+			continue;
+		if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+			// small messages, one per frame: don't hold them back waiting for more
+			setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &(int){1}, sizeof(int));
+			break;
+		}
+		close(fd);
+		fd = -1;
+	}
+	if (list)
+		freeaddrinfo(list);
+	return fd;
+}
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
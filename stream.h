@@ -0,0 +1,95 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "chip8.h"
+
+/* Display streaming between a headless chip8-serve and viewers (chip-8-emu --connect), over a Unix
+(unix:PATH) or TCP (HOST:PORT) stream socket.
+
+The server sends one message per emulated frame in which the display changed: a delta carrying only
+the packed rows that differ from the previous frame, or every keyframe interval, and whenever the
+resolution changes or a viewer joins, a keyframe with every row. A lo-res row is 8 bytes and a hi-res
+one 16, so a game moving a few sprites costs tens of bytes a frame. Viewers send their keypad mask
+back whenever it changes. Every multi-byte field is little endian. */
+#define STREAM_KEYFRAME_INTERVAL 300 // default, in frames: 5 seconds
+
+enum stream_type {
+	STREAM_KEYFRAME = 1, // server: every row of every plane
+	STREAM_DELTA = 2, // server: the rows that changed since the previous frame
+	STREAM_KEYS = 3, // viewer: a 2 byte keypad mask
+};
+
+#define STREAM_HIRES 0x1u // header flag, the rows are hi-res
+
+/* A message is this header and length bytes of payload. A frame's payload is, for each plane whose bit
+is set in planes, a 64-bit mask of the rows that follow and then those rows, top to bottom. */
+struct stream_header {
+	uint8_t type;
+	uint8_t flags;
+	uint8_t planes;
+	uint8_t reserved;
+	uint32_t length;
+	uint64_t frame;
+};
+#define STREAM_HEADER_SIZE 16
+#define STREAM_MAX_PAYLOAD (CHIP8_PLANES * (8 + CHIP8_HIRES_HEIGHT * 16))
+#define STREAM_MAX_MESSAGE (STREAM_HEADER_SIZE + STREAM_MAX_PAYLOAD)
+
+// what the viewers hold after the last message, deltas are taken against it
+struct stream_encoder {
+	chip8_plane sent[CHIP8_PLANES];
+	bool hires;
+	bool started;
+	unsigned planes; // planes the machine draws into, 2 on XO-CHIP only
+	unsigned keyframe_interval; // 0 for keyframes only when forced
+	uint64_t last_keyframe;
+};
+
+void stream_encoder_init(struct stream_encoder* encoder, chip8_machine machine, unsigned keyframe_interval);
+/* The message for frame into out, which has room for STREAM_MAX_MESSAGE bytes. Returns its size, 0
+when nothing changed and no keyframe is due. A keyframe is forced by keyframe, on the first frame and
+on a resolution change, and otherwise comes every keyframe_interval frames. */
+size_t stream_encode_frame(struct stream_encoder* encoder, const chip8* chip, uint64_t frame, bool keyframe, uint8_t* out);
+size_t stream_encode_keys(uint16_t keys, uint8_t* out);
+
+bool stream_parse_header(const uint8_t in[STREAM_HEADER_SIZE], struct stream_header* header);
+// applies a frame message to a display, false when the payload doesn't match its header
+bool stream_apply(const struct stream_header* header, const uint8_t* payload, chip8_plane display[CHIP8_PLANES], bool* hires);
+
+// a non-blocking listening socket on unix:PATH or [HOST]:PORT, -1 on failure
+int stream_listen(const char* addr);
+// a blocking connection to unix:PATH or HOST:PORT, -1 on failure
+int stream_connect(const char* addr);
+// blocking whole-message I/O for viewers, payload has room for STREAM_MAX_PAYLOAD bytes
+bool stream_receive(int fd, struct stream_header* header, uint8_t* payload);
+bool stream_send(int fd, const uint8_t* message, size_t size);
+
+#endif
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
@@ -0,0 +1,295 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "trace.h"
+
+#define TRACE_RING_SIZE (1u << 20) // records, 16 MB
+#define TRACE_PUBLISH 64 // records between updates of the shared head, keeps its cache line quiet
+#define TRACE_IDLE_NS 1000000 // writer sleep when the ring is empty
+
+struct tracer {
+	struct chip8_trace sink; // the emulation thread's end of the ring
+	FILE* file;
+	pthread_t writer;
+	uint64_t tail_cache; // last tail seen, only reloaded when the ring looks full
+	// shared, on their own cache lines
+	_Alignas(64) _Atomic uint64_t published; // records before this are ready for the writer
+	_Alignas(64) _Atomic uint64_t tail; // records before this have been written
+	atomic_bool done;
+	bool write_error;
+};
+
+static struct tracer tracer;
+
+/* Called by the interpreter every TRACE_PUBLISH records, and on every record while the ring is full:
+publishes what it wrote and lets it fill up to the next publication or the writer's tail. */
+static void sync(struct chip8_trace* sink) {
+	struct tracer* t = &tracer;
+	atomic_store_explicit(&t->published, sink->head, memory_order_release);
+	if (sink->head - t->tail_cache >= TRACE_RING_SIZE)
+		t->tail_cache = atomic_load_explicit(&t->tail, memory_order_acquire);
+	uint64_t limit = sink->head + TRACE_PUBLISH;
+	sink->limit = limit < t->tail_cache + TRACE_RING_SIZE ? limit : t->tail_cache + TRACE_RING_SIZE;
+}
+
+double trace_step(chip8* chip) {
+	return chip8_step_trace(chip, &tracer.sink);
+}
+
+struct chip8_trace* trace_sink(void) {
+	return &tracer.sink;
+}
+
+static void* writer(void* arg) {
+	struct tracer* t = arg;
+	uint64_t tail = atomic_load_explicit(&t->tail, memory_order_relaxed);
+	for (;;) {
+		uint64_t head = atomic_load_explicit(&t->published, memory_order_acquire);
+		if (head == tail) {
+			if (atomic_load_explicit(&t->done, memory_order_acquire)
+				&& atomic_load_explicit(&t->published, memory_order_acquire) == tail)
+				break;
+			nanosleep(&(struct timespec){.tv_nsec = TRACE_IDLE_NS}, NULL);
+			continue;
+		}
+		// up to the end of the ring in one write, the rest on the next pass
+		uint64_t start = tail & (TRACE_RING_SIZE - 1);
+		uint64_t count = head - tail;
+		if (count > TRACE_RING_SIZE - start)
+			count = TRACE_RING_SIZE - start;
+		if (fwrite(&t->sink.ring[start], sizeof(struct chip8_trace_record), count, t->file) != count)
+			t->write_error = true;
+		tail += count;
+		atomic_store_explicit(&t->tail, tail, memory_order_release);
+	}
+	return NULL;
+}
+
+bool trace_open(const char* path, const chip8* chip) {
+	struct tracer* t = &tracer;
+	t->file = fopen(path, "wb");
+	if (!t->file)
+		return false;
+	struct trace_header header = {
+		.magic = TRACE_MAGIC,
+		.version = TRACE_VERSION,
+		.record_size = sizeof(struct chip8_trace_record),
+		.machine = chip->machine,
+		.quirks = chip->quirks,
+	};
+	t->sink = (struct chip8_trace){
+		.ring = malloc(TRACE_RING_SIZE * sizeof(struct chip8_trace_record)),
+		.mask = TRACE_RING_SIZE - 1,
+		.limit = TRACE_PUBLISH,
+		.sync = sync,
+	};
+	if (!t->sink.ring || fwrite(&header, sizeof(header), 1, t->file) != 1) {
+		free(t->sink.ring);
+		fclose(t->file);
+		return false;
+	}
+	atomic_init(&t->published, 0);
+	atomic_init(&t->tail, 0);
+	atomic_init(&t->done, false);
+	if (pthread_create(&t->writer, NULL, writer, t) != 0) {
+		free(t->sink.ring);
+		fclose(t->file);
+		return false;
+	}
+	return true;
+}
+
+void trace_close(FILE* report) {
+	struct tracer* t = &tracer;
+	// the emulation thread has stopped, hand over the records it didn't publish yet
+	atomic_store_explicit(&t->published, t->sink.head, memory_order_release);
+	atomic_store_explicit(&t->done, true, memory_order_release);
+	pthread_join(t->writer, NULL);
+	if (fclose(t->file) != 0)
+		t->write_error = true;
+	free(t->sink.ring);
+	fprintf(report, "trace: %" PRIu64 " instructions recorded, %" PRIu64 " dropped%s\n",
+		t->sink.head, t->sink.dropped, t->write_error ? ", error writing the file" : "");
+}
+
+#ifdef TRACE_MAIN
+//***offline decoder***
+#include <argp.h>
+
+struct arguments {
+	const char* path;
+	bool pc_filter;
+	uint16_t pc_from, pc_to;
+	uint64_t cycle_from, cycle_to;
+	const char* opcode; // 4 characters, hex digits must match, anything else is a wildcard
+	int reg; // -1 for any
+};
+
+enum {
+	OPT_CYCLES = 256,
+};
+
+static struct argp_option options[] = {
+	{"pc", 'p', "ADDR[-ADDR]", 0, "Only instructions at these addresses (hex)", 0},
+	{"cycles", OPT_CYCLES, "FROM[-TO]", 0, "Only this range of cycles", 0},
+	{"opcode", 'o', "PATTERN", 0, "Only opcodes matching the pattern, . for any digit, e.g. D... or 8..4", 0},
+	{"reg", 'r', "X", 0, "Only instructions that changed Vx (hex)", 0},
+	{0}
+};
+
+static error_t parse_opt(int key, char* arg, struct argp_state* state) {
+	struct arguments* arguments = state->input;
+	char* end;
+	switch (key) {
+		case 'p':
+			arguments->pc_filter = true;
+			arguments->pc_from = strtoul(arg, &end, 16);
+			arguments->pc_to = *end == '-' ? strtoul(end + 1, NULL, 16) : arguments->pc_from;
+			break;
+		case OPT_CYCLES:
+			arguments->cycle_from = strtoull(arg, &end, 10);
+			arguments->cycle_to = *end == '-' ? strtoull(end + 1, NULL, 10) : UINT64_MAX;
+			break;
+		case 'o':
+			if (strlen(arg) != 4)
+				argp_error(state, "opcode patterns are 4 characters");
+			arguments->opcode = arg;
+			break;
+		case 'r':
+			arguments->reg = strtol(arg, NULL, 16) & 0xF;
+			break;
+		case ARGP_KEY_ARG:
+			if (state->arg_num >= 1)
+				argp_usage(state);
+			arguments->path = arg;
+			break;
+		case ARGP_KEY_END:
+			if (state->arg_num < 1)
+				argp_usage(state);
+			break;
+		default:
+			return ARGP_ERR_UNKNOWN;
+	}
+	return 0;
+}
+
+static struct argp argp = {
+	.options = options,
+	.parser = parse_opt,
+	.args_doc = "TRACE",
+	.doc = "Prints a CHIP-8 instruction trace recorded with chip-8-emu --trace",
+};
+
+static bool opcode_matches(const char* pattern, uint16_t opcode) {
+	for (int i = 0; i < 4; i++) {
+		char c = pattern[i];
+		unsigned nibble = (opcode >> (12 - 4 * i)) & 0xFu;
+		unsigned digit;
+		if (c >= '0' && c <= '9')
+			digit = c - '0';
+		else if (c >= 'a' && c <= 'f')
+			digit = c - 'a' + 10;
+		else if (c >= 'A' && c <= 'F')
+			digit = c - 'A' + 10;
+		else
+			continue;
+		if (digit != nibble)
+			return false;
+	}
+	return true;
+}
+
+int main(int argc, char** argv) {
+	struct arguments arguments = {.cycle_to = UINT64_MAX, .reg = -1};
+	argp_parse(&argp, argc, argv, 0, 0, &arguments);
+
+	FILE* file = fopen(arguments.path, "rb");
+	if (!file) {
+		fprintf(stderr, "File %s not found\n", arguments.path);
+		return 1;
+	}
+	struct trace_header header;
+	if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != TRACE_MAGIC
+		|| header.version != TRACE_VERSION || header.record_size != sizeof(struct chip8_trace_record)
+		|| header.machine > CHIP8_MACHINE_XOCHIP) {
+		fprintf(stderr, "%s is not a trace\n", arguments.path);
+		fclose(file);
+		return 1;
+	}
+	// the mnemonics come from a scratch machine with just the traced instruction in RAM
+	chip8* scratch = chip8_create(header.machine, 1);
+	if (!scratch) {
+		fprintf(stderr, "Could not allocate memory\n");
+		fclose(file);
+		return 1;
+	}
+	scratch->quirks = header.quirks;
+	const unsigned mask = scratch->ram_size - 1u;
+
+	static struct chip8_trace_record records[4096];
+	uint64_t expected = 0;
+	bool first = true;
+	size_t count;
+	while ((count = fread(records, sizeof(records[0]), sizeof(records) / sizeof(records[0]), file)) > 0) {
+		for (size_t n = 0; n < count; n++) {
+			const struct chip8_trace_record* r = &records[n];
+			if (!first && r->cycle != expected)
+				printf("... %" PRIu64 " instructions not recorded\n", r->cycle - expected);
+			first = false;
+			expected = r->cycle + 1;
+
+			if (r->cycle < arguments.cycle_from || r->cycle > arguments.cycle_to)
+				continue;
+			if (arguments.pc_filter && (r->pc < arguments.pc_from || r->pc > arguments.pc_to))
+				continue;
+			if (arguments.opcode && !opcode_matches(arguments.opcode, r->opcode))
+				continue;
+			if (arguments.reg >= 0 && (r->reg == CHIP8_TRACE_REG_NONE || (r->reg & 0xF) != arguments.reg))
+				continue;
+
+			scratch->ram[r->pc & mask] = r->opcode >> 8;
+			scratch->ram[(r->pc + 1) & mask] = r->opcode;
+			// F000 nnnn's operand isn't in the record, but it is what I became
+			scratch->ram[(r->pc + 2) & mask] = r->i >> 8;
+			scratch->ram[(r->pc + 3) & mask] = r->i;
+			char text[32];
+			chip8_disassemble(scratch, r->pc, text, sizeof(text));
+			printf("%12" PRIu64 "  %04X  %04X  %-16s I=%04X", r->cycle, r->pc, r->opcode, text, r->i);
+			if (r->reg != CHIP8_TRACE_REG_NONE)
+				printf("  V%X=%02X%s", r->reg & 0xF, r->value, r->reg & CHIP8_TRACE_REG_MORE ? " +" : "");
+			printf("\n");
+		}
+	}
+	free(scratch);
+	fclose(file);
+	return 0;
+}
+#endif
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
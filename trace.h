@@ -0,0 +1,59 @@
+/*
+Copyright (C) 2025 Eric Hernandez
+See end of file for extended copyright information */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "chip8.h"
+
+/* Binary instruction trace, for --trace.
+The traced interpreter, chip8_step_trace(), appends a fixed size chip8_trace_record for every executed
+instruction to a single producer/single consumer ring, and a background thread drains the ring to the
+trace file. The emulation thread never blocks on it: when the ring is full the record is dropped,
+which shows up as a gap in the cycle numbers. The file is this header followed by the records. */
+#define TRACE_MAGIC 0x52544338u // "C8TR"
+#define TRACE_VERSION 1
+
+struct trace_header {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t record_size;
+	uint8_t machine;
+	uint8_t quirks;
+	uint8_t reserved[6];
+};
+
+bool trace_open(const char* path, const chip8* chip);
+// the generic interpreter recording into the trace, a chip8_step_fn to run instead of the specialized one
+double trace_step(chip8* chip);
+// the ring for an interpreter of its own to record into, e.g. chip8_debug.trace
+struct chip8_trace* trace_sink(void);
+// drains what is left, stops the writer and closes the file
+void trace_close(FILE* report);
+
+#endif
+/*MIT License
+Copyright (c) 2025 Eric Hernandez
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/